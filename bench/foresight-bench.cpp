@@ -0,0 +1,395 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <linux/input-event-codes.h>
+#include <linux/input.h>
+#include <optional>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+import fs8.mods;
+import fs8.log;
+import fs8.cli;
+import fs8.lib.evtest;
+
+namespace {
+    using fs8::context_action;
+    using fs8::event_type;
+
+    /// The events that made it through a pipeline; keeps the work observable.
+    std::uint64_t sunk_events = 0; // NOLINT(*-avoid-non-const-global-variables)
+
+    /// Where the events end up, instead of a uinput device.
+    struct [[nodiscard]] sink_events {
+        context_action operator()(event_type const&) const noexcept {
+            ++sunk_events;
+            return context_action::next;
+        }
+    };
+
+    static_assert(fs8::Modifier<sink_events>);
+
+    std::uint64_t typed_matches = 0; // NOLINT(*-avoid-non-const-global-variables)
+
+    constexpr auto matched = [] noexcept {
+        ++typed_matches;
+    };
+
+    // The pipelines, after the apps they stand for, minus the devices.
+
+    constinit auto pen2mice_pipeline =
+      fs8::context
+      | fs8::replay
+      | fs8::keys_status
+      | fs8::mouse_history
+      | fs8::abs2rel
+      | fs8::pen2mice
+      | fs8::ignore_tablet
+      | fs8::ignore_big_jumps
+      | fs8::ignore_fast_left_clicks
+      | fs8::update_mod[fs8::keys_status]
+      | fs8::update_mod[fs8::mouse_history]
+      | fs8::mice_quantifier
+      | fs8::swipe_detector
+      | fs8::low_pass_filter
+      | fs8::ignore_zero_mouse_moves
+      | fs8::ignore_adjacent_syns
+      | sink_events{};
+
+    constinit auto debounce_pipeline =
+      fs8::context
+      | fs8::replay
+      | fs8::debounce[BTN_LEFT, BTN_RIGHT, BTN_MIDDLE]
+      | fs8::ignore_adjacent_syns
+      | sink_events{};
+
+    constinit auto typed_pipeline =
+      fs8::context
+      | fs8::replay
+      | fs8::search_engine
+      | fs8::on[fs8::typed["hello"], matched]
+      | fs8::on[fs8::typed["world"], matched]
+      | fs8::on[fs8::typed["foresight"], matched]
+      | fs8::on[fs8::typed["pipeline"], matched]
+      | fs8::on[fs8::typed["keyboard"], matched]
+      | fs8::on[fs8::typed["mouse"], matched]
+      | fs8::on[fs8::typed["tablet"], matched]
+      | fs8::on[fs8::typed["router"], matched]
+      | fs8::on[fs8::typed["typed"], matched]
+      | fs8::on[fs8::typed["search"], matched]
+      | fs8::on[fs8::typed["engine"], matched]
+      | fs8::on[fs8::typed["pattern"], matched]
+      | fs8::on[fs8::typed["quick"], matched]
+      | fs8::on[fs8::typed["brown"], matched]
+      | fs8::on[fs8::typed["fox"], matched]
+      | fs8::on[fs8::typed["jumps"], matched]
+      | fs8::on[fs8::typed["over"], matched]
+      | fs8::on[fs8::typed["lazy"], matched]
+      | fs8::on[fs8::typed["dog"], matched]
+      | fs8::on[fs8::typed["release"], matched]
+      | fs8::on[fs8::typed["regression"], matched]
+      | fs8::on[fs8::typed["latency"], matched]
+      | fs8::on[fs8::typed["throughput"], matched]
+      | fs8::on[fs8::typed["benchmark"], matched]
+      | fs8::on[fs8::typed["<ctrl-r>"], matched]
+      | fs8::on[fs8::typed["@home"], matched]
+      | sink_events{};
+
+    constinit auto router_pipeline =
+      fs8::context
+      | fs8::replay
+      | fs8::router[fs8::caps::keyboard >> (fs8::context | fs8::keys_status | sink_events{}),
+                    fs8::caps::mouse >> (fs8::context | fs8::mice_quantifier | sink_events{}),
+                    fs8::caps::tablet >> (fs8::context | sink_events{})];
+
+    constinit auto lerp_pipeline =
+      fs8::context
+      | fs8::replay
+      | fs8::mouse_history
+      | fs8::lerp
+      | sink_events{};
+
+    constinit auto sanitizer_pipeline =
+      fs8::context
+      | fs8::replay
+      | fs8::event_sanitizer
+      | sink_events{};
+
+    // Synthetic workloads, for when no recording is given.
+
+    /// Appends events with a timestamp that moves on like a device's would.
+    struct [[nodiscard]] stream_writer {
+        std::vector<event_type>& out;
+        std::int64_t             usec = 1'000'000;
+
+        void add(std::uint16_t const type, std::uint16_t const code, std::int32_t const value) {
+            event_type event{type, code, value};
+            event.time(timeval{.tv_sec = usec / 1'000'000, .tv_usec = usec % 1'000'000});
+            out.push_back(event);
+        }
+
+        void syn(std::int64_t const after_usec) {
+            add(EV_SYN, SYN_REPORT, 0);
+            usec += after_usec;
+        }
+    };
+
+    constexpr std::array<std::uint16_t, 26> letter_codes{
+      KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L, KEY_M,
+      KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z,
+    };
+
+    /// Typing prose that hits some of the patterns now and then.
+    void add_typing(stream_writer& writer, std::size_t const events) {
+        constexpr std::string_view text = "the quick brown fox jumps over the lazy dog and the foresight pipeline "
+                                          "types into a search engine while the router sends a mouse to a tablet ";
+        for (std::size_t index = 0; writer.out.size() < events; ++index) {
+            char const          chr  = text[index % text.size()];
+            std::uint16_t const code = chr == ' ' ? KEY_SPACE : letter_codes[static_cast<std::size_t>(chr - 'a')];
+            writer.add(EV_KEY, code, 1);
+            writer.syn(60'000);
+            writer.add(EV_KEY, code, 0);
+            writer.syn(40'000);
+        }
+    }
+
+    /// A 1000 Hz mouse, with a click now and then, and a bouncing one less often.
+    void add_mouse(stream_writer& writer, std::size_t const events) {
+        for (std::int32_t frame = 0; writer.out.size() < events; ++frame) {
+            writer.add(EV_REL, REL_X, (frame % 7) - 3);
+            writer.add(EV_REL, REL_Y, (frame % 5) - 2);
+            writer.syn(1'000);
+            if (frame % 250 == 0) {
+                writer.add(EV_KEY, BTN_LEFT, 1);
+                writer.syn(80'000);
+                writer.add(EV_KEY, BTN_LEFT, 0);
+                writer.syn(frame % 1000 == 0 ? 5'000 : 1'000);
+            }
+            if (frame % 1000 == 0) {
+                writer.add(EV_KEY, BTN_LEFT, 1); // the bounce
+                writer.syn(2'000);
+                writer.add(EV_KEY, BTN_LEFT, 0);
+                writer.syn(1'000);
+            }
+        }
+    }
+
+    /// A pen drawing strokes on a 200 Hz tablet.
+    void add_pen(stream_writer& writer, std::size_t const events) {
+        writer.add(EV_KEY, BTN_TOOL_PEN, 1);
+        writer.syn(5'000);
+        for (std::int32_t frame = 0; writer.out.size() < events; ++frame) {
+            std::int32_t const stroke = frame % 400;
+            if (stroke == 0) {
+                writer.add(EV_KEY, BTN_TOUCH, 1);
+            } else if (stroke == 300) {
+                writer.add(EV_KEY, BTN_TOUCH, 0);
+            }
+            writer.add(EV_ABS, ABS_X, 10'000 + (frame % 2'000) * 3);
+            writer.add(EV_ABS, ABS_Y, 8'000 + (frame % 1'500) * 2);
+            writer.add(EV_ABS, ABS_PRESSURE, stroke < 300 ? 800 + (stroke % 50) : 0);
+            writer.syn(5'000);
+        }
+    }
+
+    /// The keyboard and the mouse at once, as the router and the sanitizer see them.
+    void add_mixed(stream_writer& writer, std::size_t const events) {
+        std::vector<event_type> keys;
+        std::vector<event_type> mice;
+        stream_writer           key_writer{keys};
+        stream_writer           mouse_writer{mice};
+        add_typing(key_writer, events / 4);
+        add_mouse(mouse_writer, events - keys.size());
+        std::ranges::merge(keys, mice, std::back_inserter(writer.out), {}, &event_type::micro_time, &event_type::micro_time);
+    }
+
+    // Recordings.
+
+    [[nodiscard]] std::string read_file(std::string const& path) {
+        std::ifstream file{path, std::ios::binary};
+        if (!file) {
+            throw std::runtime_error(std::format("Can't open '{}'.", path));
+        }
+        return std::string{std::istreambuf_iterator<char>{file}, {}};
+    }
+
+    /// Load an evtest capture (`evtest`, `foresight how-to-type --evtest`), or
+    /// else a binary one: the raw `input_event`s, as `foresight > file` writes.
+    void load_recording(std::string const& path, std::vector<event_type>& out) {
+        auto const content = read_file(path);
+        if (content.contains("Event: time ")) {
+            std::string_view rest{content};
+            while (!rest.empty()) {
+                auto const eol  = rest.find('\n');
+                auto const line = rest.substr(0, eol);
+                rest            = eol == std::string_view::npos ? std::string_view{} : rest.substr(eol + 1);
+
+                fs8::parsed_evtest_event parsed;
+                if (fs8::parse_evtest_line(line, parsed)) {
+                    auto const usec = static_cast<std::int64_t>(parsed.time * 1'000'000);
+                    event_type event{parsed.event};
+                    event.time(timeval{.tv_sec = usec / 1'000'000, .tv_usec = usec % 1'000'000});
+                    out.push_back(event);
+                } else if (line.starts_with("Event: ") && line.contains("SYN_REPORT") && !out.empty()) {
+                    // The parser skips evtest's SYN_REPORT separators; the frames need them.
+                    event_type syn_event{EV_SYN, SYN_REPORT, 0};
+                    syn_event.time(out.back().time());
+                    out.push_back(syn_event);
+                }
+            }
+            return;
+        }
+        if (content.size() % sizeof(input_event) != 0) {
+            throw std::runtime_error(std::format("'{}' is neither an evtest capture nor a stream of input_events.", path));
+        }
+        for (std::size_t offset = 0; offset < content.size(); offset += sizeof(input_event)) {
+            input_event raw{};
+            std::memcpy(&raw, content.data() + offset, sizeof(raw));
+            out.emplace_back(raw);
+        }
+    }
+
+    // Running them.
+
+    struct [[nodiscard]] bench_result {
+        std::string_view name;
+        std::size_t      events  = 0;
+        double           best    = 0; // ns/event
+        double           median  = 0; // ns/event
+        std::uint64_t    outputs = 0; // per round
+    };
+
+    template <typename PipelineT>
+    [[nodiscard]] bench_result run(std::string_view const      name,
+                                   PipelineT&                  pipeline,
+                                   std::span<event_type const> events,
+                                   std::size_t const           rounds) {
+        using clock = std::chrono::steady_clock;
+
+        std::vector<double> per_event;
+        std::uint64_t       outputs = 0;
+        for (std::size_t round = 0; round <= rounds; ++round) { // the first one warms up
+            pipeline.mod(fs8::replay).load(events);
+            auto const sunk_before = sunk_events;
+            auto const start       = clock::now();
+            pipeline();
+            auto const elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+            outputs            = sunk_events - sunk_before;
+            if (round != 0) {
+                per_event.push_back(elapsed / static_cast<double>(std::max<std::size_t>(events.size(), 1)));
+            }
+        }
+        std::ranges::sort(per_event);
+        return bench_result{
+          .name    = name,
+          .events  = events.size(),
+          .best    = per_event.front(),
+          .median  = per_event[per_event.size() / 2],
+          .outputs = outputs,
+        };
+    }
+
+    void print_result(bench_result const& result) {
+        std::println("{:<10} {:>10} {:>12.1f} {:>12.1f} {:>14.0f} {:>10}",
+                     result.name,
+                     result.events,
+                     result.median,
+                     result.best,
+                     result.median > 0 ? 1e9 / result.median : 0.0,
+                     result.outputs);
+    }
+
+    [[nodiscard]] std::size_t parse_count(std::string_view const str, std::string_view const flag) {
+        std::size_t value    = 0;
+        auto const [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        if (ec != std::errc{} || ptr != str.data() + str.size() || value == 0) {
+            throw std::runtime_error(std::format("Invalid {} value: '{}'.", flag, str));
+        }
+        return value;
+    }
+} // namespace
+
+static constexpr auto args =
+  fs8::arguments.positional("recording...")
+    .add_flag({.name = "--events", .alias = "-n", .help = "Events per synthetic workload (default: 1000000).", .takes_value = true})
+    .add_flag({.name = "--rounds", .alias = "-r", .help = "Timed rounds per pipeline, after a warm-up one (default: 5).", .takes_value = true})
+    .help(R"TEXT(
+Usage: foresight-bench [recording...] [options]
+
+Replays input events through representative pipelines as fast as they go
+(pen2mice, debounce, typed with a search_engine full of patterns, router, lerp
+and the sanitizer), and reports the throughput of each: the median and the best
+ns/event over the rounds, and the events/sec of the median.
+
+Without recordings, each pipeline gets a synthetic workload of its own kind
+(a pen, a mouse, typing, or a mix). With them, every pipeline replays all of
+them, in order, with their original timestamps.
+
+Arguments:
+    -h | --help              Print help.
+    -n | --events <count>    Events per synthetic workload (default: 1000000).
+    -r | --rounds <count>    Timed rounds per pipeline (default: 5).
+
+Positionals:
+    recording                evtest output (`evtest /dev/input/eventN > file`), or
+                             a binary capture of raw input_events
+                             (`foresight ... > file`).
+)TEXT");
+
+int main(int const argc, char const* const* argv) try {
+    auto const parsed = args(argc, argv);
+    if (parsed.exit_if_needed()) {
+        return 0;
+    }
+
+    std::size_t const events = parsed.flag_value("--events").transform([](std::string_view str) {
+                                   return parse_count(str, "--events");
+                               }).value_or(1'000'000);
+    std::size_t const rounds = parsed.flag_value("--rounds").transform([](std::string_view str) {
+                                   return parse_count(str, "--rounds");
+                               }).value_or(5);
+
+    std::vector<event_type> recorded;
+    for (char const* const path : parsed) {
+        load_recording(path, recorded);
+    }
+
+    auto const workload = [&](void (*add)(stream_writer&, std::size_t)) {
+        if (!recorded.empty()) {
+            return recorded;
+        }
+        std::vector<event_type> out;
+        out.reserve(events + 16);
+        stream_writer writer{out};
+        add(writer, events);
+        return out;
+    };
+
+    auto const pen    = workload(add_pen);
+    auto const mouse  = workload(add_mouse);
+    auto const typing = workload(add_typing);
+    auto const mixed  = workload(add_mixed);
+
+    std::println("{:<10} {:>10} {:>12} {:>12} {:>14} {:>10}", "pipeline", "events", "ns/event", "best", "events/sec", "outputs");
+    print_result(run("pen2mice", pen2mice_pipeline, pen, rounds));
+    print_result(run("debounce", debounce_pipeline, mouse, rounds));
+    print_result(run("typed", typed_pipeline, typing, rounds));
+    print_result(run("router", router_pipeline, mixed, rounds));
+    print_result(run("lerp", lerp_pipeline, mouse, rounds));
+    print_result(run("sanitizer", sanitizer_pipeline, mixed, rounds));
+
+    return 0;
+} catch (std::runtime_error const& err) {
+    fs8::log("Runtime Error: {}", err.what());
+    return 1;
+}
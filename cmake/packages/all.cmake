@@ -8,3 +8,4 @@ if (IS_DEBUG)
     # include(fuzztest)
 endif ()
 include(libevdev)
+include(liburing)
@@ -7,11 +7,13 @@ module;
 #include <cstring>
 #include <fcntl.h>
 #include <filesystem>
+#include <functional>
 #include <libevdev/libevdev.h>
 #include <linux/input-event-codes.h>
 #include <linux/limits.h>
 #include <numeric>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -436,6 +438,58 @@ std::optional<input_event> evdev::next() noexcept {
     return std::nullopt;
 }
 
+std::span<input_event> evdev::read_events(std::span<input_event> const buf) noexcept {
+    if (dev == nullptr || buf.empty()) [[unlikely]] {
+        return {};
+    }
+    int const fd = libevdev_get_fd(dev);
+    if (fd < 0) [[unlikely]] {
+        return {};
+    }
+
+    // evdev only ever hands out whole events, so the byte count is a multiple
+    // of the event size; EAGAIN / ENODEV just mean "nothing to read".
+    auto const res = ::read(fd, buf.data(), buf.size_bytes());
+    if (res <= 0) [[unlikely]] {
+        return {};
+    }
+    auto const got = buf.first(static_cast<std::size_t>(res) / sizeof(input_event));
+    for (auto const& ev : got) {
+        mirror(ev);
+    }
+    return got;
+}
+
+void evdev::mirror(input_event const& ev) noexcept {
+    if (dev == nullptr) [[unlikely]] {
+        return;
+    }
+    switch (ev.type) {
+        case EV_ABS:
+            if (ev.code >= ABS_MT_SLOT) {
+                break;
+            }
+            [[fallthrough]];
+        case EV_KEY:
+        case EV_SW:
+        case EV_LED: libevdev_set_event_value(dev, ev.type, ev.code, ev.value); break;
+        default: break;
+    }
+}
+
+void evdev::resync(std::function_ref<void(input_event const&)> const out) noexcept {
+    if (dev == nullptr) [[unlikely]] {
+        return;
+    }
+    input_event input{};
+    if (libevdev_next_event(dev, LIBEVDEV_READ_FLAG_FORCE_SYNC, &input) != LIBEVDEV_READ_STATUS_SYNC) {
+        return;
+    }
+    while (libevdev_next_event(dev, LIBEVDEV_READ_FLAG_SYNC, &input) == LIBEVDEV_READ_STATUS_SYNC) {
+        out(input);
+    }
+}
+
 bool evdev::send_event(input_event const& event) const noexcept {
     if (dev == nullptr) [[unlikely]] {
         return false;
@@ -3,9 +3,11 @@
 module;
 #include <concepts>
 #include <filesystem>
+#include <functional>
 #include <libevdev/libevdev.h>
 #include <optional>
 #include <ranges>
+#include <span>
 #include <string_view>
 #include <utility>
 export module fs8.devices.evdev;
@@ -199,6 +201,23 @@ namespace fs8 {
          */
         [[nodiscard]] std::optional<input_event> next() noexcept;
 
+        /// Read every whole event the kernel has queued (up to `buf.size()`)
+        /// with a single read(2), bypassing libevdev's own queue; returns the
+        /// filled prefix of `buf`, empty when nothing is pending.
+        /// libevdev's view of the key/abs/switch/led state is kept current, so
+        /// a later `resync` reports the right differences. Multitouch slots are
+        /// not tracked: use `next` on devices with `ABS_MT_SLOT`.
+        [[nodiscard]] std::span<input_event> read_events(std::span<input_event> buf) noexcept;
+
+        /// Record an event read outside of libevdev (see `read_events`) in
+        /// libevdev's view of the key/abs/switch/led state.
+        void mirror(input_event const& ev) noexcept;
+
+        /// Recover from a `SYN_DROPPED` seen through `read_events`: libevdev
+        /// discards what's left in the kernel buffer, re-reads the device state,
+        /// and the differences are handed to `out` as events.
+        void resync(std::function_ref<void(input_event const&)> out) noexcept;
+
         /// Write a single input_event back into the device (e.g. an EV_LED to
         /// reflect a mode toggle on the hardware device). Returns false on
         /// failure (including devices that don't accept writes).
@@ -3,6 +3,8 @@
 module;
 #include <array>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
 #include <cstring>
 #include <dirent.h>
 #include <fcntl.h>
@@ -15,7 +17,9 @@ module;
 #include <span>
 #include <sys/stat.h>
 #include <system_error>
+#include <tuple>
 #include <unistd.h>
+#include <vector>
 module fs8.mods;
 import fs8.event;
 import fs8.log;
@@ -37,8 +41,22 @@ struct fs8::pimpl_idiom<basic_uinput>::impl {
     /// origin chain (phys) before the kernel registered the device.
     /// libevdev never closes a caller-provided fd; we own it.
     int owned_fd = -1;
+
+    /// The frame held back in the `per_frame` mode.
+    std::vector<input_event> pending;
+
+    /// The triggers of the held events, when they're traced.
+    std::vector<trace_trigger> pending_triggers;
+
+    /// Events that didn't make it to the kernel.
+    std::uint64_t write_failures = 0;
 };
 
+namespace {
+    /// A frame that doesn't end is written out once it's this long anyway.
+    constexpr std::size_t max_pending_events = 256;
+} // namespace
+
 static constexpr std::string_view uinput_path = "/dev/uinput";
 
 #define SYS_INPUT_DIR "/sys/devices/virtual/input/"
@@ -123,6 +141,7 @@ void basic_uinput::close() noexcept {
     if (pimpl.get() == nullptr) [[unlikely]] {
         return;
     }
+    std::ignore = flush();
     if (pimpl->dev != nullptr) {
         libevdev_uinput_destroy(pimpl->dev);
         pimpl->dev = nullptr;
@@ -739,10 +758,17 @@ bool basic_uinput::emit(ev_type const type, code_type const code, value_type con
         return false;
     }
     assert(is_ok());
+    if (writes == uinput_write_mode::per_frame) {
+        return hold(type, code, value);
+    }
     if (auto const ret = libevdev_uinput_write_event(pimpl->dev, type, code, value); ret < 0) [[unlikely]] {
         pimpl->err_code = -ret;
+        ++pimpl->write_failures;
         return false;
     }
+    if (is_tracing()) [[unlikely]] {
+        trace_egress(this, devnode());
+    }
     return true;
 }
 
@@ -762,6 +788,93 @@ bool basic_uinput::emit_syn() noexcept {
     return emit(EV_SYN, SYN_REPORT, 0);
 }
 
+bool basic_uinput::hold(ev_type const type, code_type const code, value_type const value) noexcept try {
+    // The same checks libevdev_uinput_write_event does before its write.
+    if (type > EV_MAX || code > static_cast<unsigned>(libevdev_event_type_get_max(type))) [[unlikely]] {
+        pimpl->err_code = EINVAL;
+        ++pimpl->write_failures;
+        return false;
+    }
+    input_event event{}; // zero time: the kernel stamps it, as with libevdev
+    event.type  = type;
+    event.code  = code;
+    event.value = value;
+    pimpl->pending.push_back(event);
+    if (is_tracing()) [[unlikely]] {
+        pimpl->pending_triggers.push_back(*basic_traced_event::instance());
+    }
+    if ((type == EV_SYN && code == SYN_REPORT) || pimpl->pending.size() >= max_pending_events) {
+        return flush();
+    }
+    return true;
+} catch (...) {
+    // Out of memory; the held frame goes out without this event.
+    pimpl->err_code = ENOMEM;
+    ++pimpl->write_failures;
+    std::ignore = flush();
+    return false;
+}
+
+bool basic_uinput::flush() noexcept {
+    if (pimpl.get() == nullptr || pimpl->pending.empty()) {
+        return true;
+    }
+    if (pimpl->dev == nullptr) [[unlikely]] {
+        pimpl->write_failures += pimpl->pending.size();
+        pimpl->pending.clear();
+        pimpl->pending_triggers.clear();
+        return false;
+    }
+    int const   fd   = libevdev_uinput_get_fd(pimpl->dev);
+    auto const* data = reinterpret_cast<char const*>(pimpl->pending.data());
+    std::size_t left = pimpl->pending.size() * sizeof(input_event);
+    bool        ok   = true;
+    while (left > 0) {
+        auto const written = ::write(fd, data, left);
+        if (written < 0) [[unlikely]] {
+            if (errno == EINTR) {
+                continue;
+            }
+            pimpl->err_code        = errno;
+            pimpl->write_failures += left / sizeof(input_event);
+            ok                     = false;
+            break;
+        }
+        data += written;
+        left -= static_cast<std::size_t>(written);
+    }
+    if (ok) {
+        for (auto const& trigger : pimpl->pending_triggers) {
+            trace_egress(trigger, this, devnode());
+        }
+    }
+    pimpl->pending.clear();
+    pimpl->pending_triggers.clear();
+    return ok;
+}
+
+void basic_uinput::write_mode(uinput_write_mode const inp_writes) noexcept {
+    if (writes == inp_writes) {
+        return;
+    }
+    std::ignore = flush();
+    writes      = inp_writes;
+}
+
+std::size_t basic_uinput::pending_events() const noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return 0;
+    }
+    return pimpl->pending.size();
+}
+
+std::uint64_t basic_uinput::write_failures() const noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return 0;
+    }
+    return pimpl->write_failures;
+}
+
 bool basic_uinput::init(dev_caps_view const caps_view) noexcept {
     // don't re-initialize
     if (is_ok()) {
@@ -1,11 +1,13 @@
 // Created by moisrex on 6/29/24.
 
 module;
+#include <cstdint>
 #include <filesystem>
 #include <libevdev/libevdev-uinput.h>
 #include <ranges>
 #include <string_view>
 #include <system_error>
+#include <tuple>
 export module fs8.mods:uinput;
 export import fs8.devices.evdev;
 export import fs8.event;
@@ -54,6 +56,12 @@ export namespace fs8 {
 
     [[nodiscard]] std::string_view to_string(uinput_access_result) noexcept;
 
+    /// How `basic_uinput` hands the events to the kernel.
+    enum struct [[nodiscard]] uinput_write_mode : std::uint8_t {
+        per_event, // one write per event, as soon as it's emitted
+        per_frame, // held until SYN_REPORT (or a flush), then written with a single write
+    };
+
     struct basic_uinput;
 
     /// Copy a matching device into a virtual (uinput) device, applying caps.
@@ -67,6 +75,11 @@ export namespace fs8 {
      * If uinput_fd is LIBEVDEV_UINPUT_OPEN_MANAGED, we will open /dev/uinput in read/write mode and manage
      * the file descriptor. Otherwise, uinput_fd must be opened by the caller and opened with the appropriate
      * permissions.
+     *
+     * With `uinput[uinput_write_mode::per_frame]` the events are held back until
+     * their `SYN_REPORT` and the whole frame goes out in a single `write`, in
+     * the order they were emitted. The pipeline flushes a partial frame before
+     * it blocks for new events, and so does `flush()`/`close()`.
      */
     constexpr struct [[nodiscard]] basic_uinput : pimpl_idiom<basic_uinput> {
         using pimpl_idiom::pimpl_idiom;
@@ -80,6 +93,12 @@ export namespace fs8 {
         /// by `input_manager` to avoid feedback loops.
         bool self_created = true;
 
+      private:
+        uinput_write_mode writes = uinput_write_mode::per_event;
+
+        [[nodiscard]] bool hold(ev_type type, code_type code, value_type value) noexcept;
+
+      public:
         basic_uinput(evdev const& evdev_dev, std::filesystem::path const& file) noexcept;
         basic_uinput(libevdev const* evdev_dev, std::filesystem::path const& file) noexcept;
         explicit basic_uinput(libevdev const* evdev_dev, int file_descriptor = LIBEVDEV_UINPUT_OPEN_MANAGED) noexcept;
@@ -97,6 +116,28 @@ export namespace fs8 {
 
         void close() noexcept;
 
+        consteval basic_uinput operator[](uinput_write_mode const inp_writes) const noexcept {
+            auto res{*this};
+            res.writes = inp_writes;
+            return res;
+        }
+
+        /// Changing it flushes the events held so far.
+        void write_mode(uinput_write_mode inp_writes) noexcept;
+
+        [[nodiscard]] constexpr uinput_write_mode write_mode() const noexcept {
+            return writes;
+        }
+
+        /// Write out the events held back in the `per_frame` mode.
+        bool flush() noexcept;
+
+        /// The number of events held back, waiting for their `SYN_REPORT`.
+        [[nodiscard]] std::size_t pending_events() const noexcept;
+
+        /// The number of events that failed to be written, since it was created.
+        [[nodiscard]] std::uint64_t write_failures() const noexcept;
+
         [[nodiscard]] std::error_code error() const noexcept;
         [[nodiscard]] bool            is_ok() const noexcept;
 
@@ -282,6 +323,10 @@ export namespace fs8 {
 
         context_action operator()(event_type const& event) noexcept;
 
+        void operator()(flush_tag) noexcept {
+            std::ignore = flush();
+        }
+
         friend bool finalize_device(basic_uinput& self, evdev const& best, dev_caps_view caps_view) noexcept;
     } uinput;
 
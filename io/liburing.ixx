@@ -3,11 +3,15 @@
 #ifndef LIBURING_IXX_H
 #define LIBURING_IXX_H
 
+// FS8_HAS_LIBURING is defined when the liburing headers are available, so the
+// users can compile their io_uring paths out and stick to the portable ones.
 #ifdef __linux__
 #    if __has_include(<liburing/liburing-hdr-only.h>)
 #        include <liburing/liburing-hdr-only.h>
-#    else
+#        define FS8_HAS_LIBURING 1
+#    elif __has_include(<liburing.h>)
 #        include <liburing.h>
+#        define FS8_HAS_LIBURING 1
 #    endif
 #endif
 
@@ -0,0 +1,294 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+export module fs8.lib.aho_table;
+
+export namespace fs8 {
+
+    /**
+     * A read-only view of an Aho-Corasick automaton that was built at compile
+     * time (see `aho_table_of`).
+     *
+     * The failure links are folded into the transitions, so moving on is one
+     * lookup of the code point's column and one load from a flat table; and a
+     * pattern ends at a state if that state is in the range of the failure-link
+     * tree its end state covers (like the runtime `search_engine` does).
+     */
+    struct [[nodiscard]] aho_table_view {
+        using state_type = std::uint16_t;
+
+        std::span<std::string_view const> patterns;       // the patterns, as written
+        std::span<char32_t const>         codes;          // the code points of all the patterns, one after another
+        std::span<state_type const>       offsets;        // where each pattern starts in `codes`
+        std::span<state_type const>       lengths;        // code points in each pattern
+        std::span<state_type const>       pattern_states; // the state each pattern ends at
+        std::span<char32_t const>         symbols;        // sorted; column 0 is everything else
+        std::span<state_type const>       transitions;    // [state * (symbols + 1) + column]
+        std::span<state_type const>       enter;          // per state, pre-order of the failure-link tree
+        std::span<state_type const>       leave;          // per state, the end of its subtree's range
+        std::size_t                       longest = 0;    // the length of the longest pattern
+
+        [[nodiscard]] constexpr bool empty() const noexcept {
+            return transitions.empty();
+        }
+
+        [[nodiscard]] constexpr std::size_t size() const noexcept {
+            return patterns.size();
+        }
+
+        /// The id of `pattern`, or `size()` if it isn't one of them.
+        [[nodiscard]] constexpr std::size_t find(std::string_view const pattern) const noexcept {
+            return static_cast<std::size_t>(std::ranges::find(patterns, pattern) - patterns.begin());
+        }
+
+        /// The code points of a pattern.
+        [[nodiscard]] constexpr std::u32string_view code_points(std::size_t const id) const noexcept {
+            return {codes.data() + offsets[id], lengths[id]};
+        }
+
+        [[nodiscard]] constexpr std::size_t column(char32_t const code) const noexcept {
+            if (symbols.empty() || code < symbols.front() || code > symbols.back()) [[likely]] {
+                return 0;
+            }
+            auto const pos = std::ranges::lower_bound(symbols, code);
+            return *pos == code ? static_cast<std::size_t>(pos - symbols.begin()) + 1 : 0;
+        }
+
+        [[nodiscard]] constexpr std::uint32_t next(std::uint32_t const state, char32_t const code) const noexcept {
+            return transitions[(state * (symbols.size() + 1)) + column(code)];
+        }
+
+        [[nodiscard]] constexpr bool matches(std::uint32_t const state, std::size_t const id) const noexcept {
+            auto const end  = pattern_states[id];
+            auto const rank = enter[state];
+            return enter[end] <= rank && rank < leave[end];
+        }
+    };
+
+    /**
+     * The sizes of an `aho_table`.
+     */
+    struct [[nodiscard]] aho_table_size {
+        std::size_t patterns = 0;
+        std::size_t codes    = 0;
+        std::size_t states   = 0;
+        std::size_t symbols  = 0;
+    };
+
+    /**
+     * An Aho-Corasick automaton as flat arrays, exactly as big as the patterns
+     * need; built by `aho_table_of`, and kept in the binary's read-only data.
+     */
+    template <aho_table_size Size>
+    struct [[nodiscard]] aho_table {
+        using state_type = aho_table_view::state_type;
+
+        std::array<std::string_view, Size.patterns>              patterns{};
+        std::array<char32_t, Size.codes>                         codes{};
+        std::array<state_type, Size.patterns>                    offsets{};
+        std::array<state_type, Size.patterns>                    lengths{};
+        std::array<state_type, Size.patterns>                    pattern_states{};
+        std::array<char32_t, Size.symbols>                       symbols{};
+        std::array<state_type, Size.states * (Size.symbols + 1)> transitions{};
+        std::array<state_type, Size.states>                      enter{};
+        std::array<state_type, Size.states>                      leave{};
+        std::size_t                                              longest = 0;
+
+        [[nodiscard]] constexpr aho_table_view view() const noexcept {
+            return {
+              .patterns       = patterns,
+              .codes          = codes,
+              .offsets        = offsets,
+              .lengths        = lengths,
+              .pattern_states = pattern_states,
+              .symbols        = symbols,
+              .transitions    = transitions,
+              .enter          = enter,
+              .leave          = leave,
+              .longest        = longest,
+            };
+        }
+    };
+
+    namespace details {
+        /// The automaton in vectors, only while it's being built.
+        struct [[nodiscard]] aho_build {
+            using state_type = aho_table_view::state_type;
+
+            std::vector<char32_t>   codes;
+            std::vector<state_type> offsets;
+            std::vector<state_type> lengths;
+            std::vector<state_type> pattern_states;
+            std::vector<char32_t>   symbols;
+            std::vector<state_type> transitions;
+            std::vector<state_type> enter;
+            std::vector<state_type> leave;
+            std::size_t             longest = 0;
+
+            [[nodiscard]] constexpr std::size_t states() const noexcept {
+                return enter.size();
+            }
+        };
+
+        /// UTF-8 to code points; only plain text, the modifier tags (`<...>`,
+        /// `[...]`) and `U+XXXX` need the runtime parser and the keymap.
+        consteval std::vector<char32_t> aho_code_points(std::string_view pattern) {
+            std::vector<char32_t> codes;
+            while (!pattern.empty()) {
+                auto const lead = static_cast<unsigned char>(pattern.front());
+                if (lead == '<' || lead == '[' || (lead == 'U' && pattern.starts_with("U+"))) {
+                    throw std::invalid_argument("Modifier tags and U+XXXX can't be compiled; add the pattern at runtime instead.");
+                }
+                std::size_t const size = lead < 0x80U ? 1 : lead < 0xE0U ? 2 : lead < 0xF0U ? 3 : 4;
+                if ((lead >= 0x80U && lead < 0xC0U) || size > pattern.size()) {
+                    throw std::invalid_argument("Invalid UTF-8 in the pattern.");
+                }
+                char32_t code = size == 1 ? lead : lead & (0x7FU >> size);
+                for (std::size_t i = 1; i < size; ++i) {
+                    code = (code << 6U) | (static_cast<unsigned char>(pattern[i]) & 0x3FU);
+                }
+                codes.push_back(code);
+                pattern.remove_prefix(size);
+            }
+            if (codes.empty()) {
+                throw std::invalid_argument("Empty pattern.");
+            }
+            return codes;
+        }
+
+        consteval aho_build build_aho(std::span<std::string_view const> const patterns) {
+            using state_type = aho_build::state_type;
+
+            struct node_type {
+                std::vector<std::pair<char32_t, std::size_t>> children;
+                std::size_t                                   fail = 0;
+            };
+
+            aho_build              result;
+            std::vector<node_type> trie(1);
+
+            // The trie, and the alphabet.
+            for (auto const pattern : patterns) {
+                auto const  codes   = aho_code_points(pattern);
+                std::size_t current = 0;
+                for (char32_t const code : codes) {
+                    auto const it = std::ranges::find(trie[current].children, code, &std::pair<char32_t, std::size_t>::first);
+                    if (it != trie[current].children.end()) {
+                        current = it->second;
+                        continue;
+                    }
+                    trie[current].children.emplace_back(code, trie.size());
+                    current = trie.size();
+                    trie.emplace_back();
+                    result.symbols.push_back(code);
+                }
+                result.offsets.push_back(static_cast<state_type>(result.codes.size()));
+                result.lengths.push_back(static_cast<state_type>(codes.size()));
+                result.codes.insert(result.codes.end(), codes.begin(), codes.end());
+                result.pattern_states.push_back(static_cast<state_type>(current));
+                result.longest = std::max(result.longest, codes.size());
+            }
+            if (result.codes.size() >= std::numeric_limits<state_type>::max()) {
+                throw std::length_error("Too many code points for a compiled table.");
+            }
+            std::ranges::sort(result.symbols);
+            auto const [first, last] = std::ranges::unique(result.symbols);
+            result.symbols.erase(first, last);
+
+            auto const columns = result.symbols.size() + 1;
+            auto const column  = [&](char32_t const code) {
+                return static_cast<std::size_t>(std::ranges::lower_bound(result.symbols, code) - result.symbols.begin()) + 1;
+            };
+
+            // The transitions in BFS order; a missing one is the failure
+            // state's, which is already complete by then.
+            result.transitions.assign(trie.size() * columns, 0);
+            std::vector<std::size_t> order{0};
+            for (std::size_t head = 0; head < order.size(); ++head) {
+                auto const state = order[head];
+                auto const fail  = trie[state].fail;
+                if (state != 0) {
+                    std::copy_n(result.transitions.begin() + static_cast<std::ptrdiff_t>(fail * columns),
+                                columns,
+                                result.transitions.begin() + static_cast<std::ptrdiff_t>(state * columns));
+                }
+                for (auto const& [code, child] : trie[state].children) {
+                    auto& slot       = result.transitions[(state * columns) + column(code)];
+                    trie[child].fail = state == 0 ? 0 : slot;
+                    slot             = static_cast<state_type>(child);
+                    order.push_back(child);
+                }
+            }
+
+            // Pre-order ranges of the failure-link tree, the same as the
+            // runtime engine's.
+            result.enter.assign(trie.size(), 0);
+            result.leave.assign(trie.size(), 1);
+            for (auto const state : order | std::views::reverse) {
+                if (state != 0) {
+                    result.leave[trie[state].fail] += result.leave[state];
+                }
+            }
+            std::vector<std::size_t> next_rank(trie.size(), 0);
+            next_rank[0]    = 1;
+            result.leave[0] = static_cast<state_type>(trie.size());
+            for (auto const state : order | std::views::drop(1)) {
+                auto& parent_rank    = next_rank[trie[state].fail];
+                result.enter[state]  = static_cast<state_type>(parent_rank);
+                result.leave[state] += result.enter[state];
+                parent_rank          = result.leave[state];
+                next_rank[state]     = result.enter[state] + 1U;
+            }
+            return result;
+        }
+
+        consteval aho_table_size aho_size_of(std::span<std::string_view const> const patterns) {
+            auto const built = build_aho(patterns);
+            return {
+              .patterns = patterns.size(),
+              .codes    = built.codes.size(),
+              .states   = built.states(),
+              .symbols  = built.symbols.size(),
+            };
+        }
+
+        template <aho_table_size Size>
+        consteval aho_table<Size> make_aho_table(std::span<std::string_view const> const patterns) {
+            auto const      built = build_aho(patterns);
+            aho_table<Size> table;
+            std::ranges::copy(patterns, table.patterns.begin());
+            std::ranges::copy(built.codes, table.codes.begin());
+            std::ranges::copy(built.offsets, table.offsets.begin());
+            std::ranges::copy(built.lengths, table.lengths.begin());
+            std::ranges::copy(built.pattern_states, table.pattern_states.begin());
+            std::ranges::copy(built.symbols, table.symbols.begin());
+            std::ranges::copy(built.transitions, table.transitions.begin());
+            std::ranges::copy(built.enter, table.enter.begin());
+            std::ranges::copy(built.leave, table.leave.begin());
+            table.longest = built.longest;
+            return table;
+        }
+    } // namespace details
+
+    /**
+     * The automaton of a constant list of patterns, built by the compiler:
+     *
+     *   constexpr std::array<std::string_view, 2> hotkeys{"test", "@es"};
+     *   constexpr auto const&                     table = aho_table_of<hotkeys>;
+     *
+     * The ids of the patterns are their indices in the list.
+     */
+    template <auto const& Patterns>
+    constexpr auto aho_table_of = details::make_aho_table<details::aho_size_of(Patterns)>(Patterns);
+
+} // namespace fs8
@@ -0,0 +1,323 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+module fs8.lib.dictionary;
+
+using fs8::dictionary;
+
+namespace {
+    [[nodiscard]] int open_file(std::string_view const path) noexcept try {
+        std::string const c_path{path};
+        int               fd = -1;
+        do {
+            fd = ::open(c_path.c_str(), O_RDONLY | O_CLOEXEC);
+        } while (fd == -1 && errno == EINTR);
+        return fd;
+    } catch (...) {
+        return -1;
+    }
+
+    /// The word and the frequency of a line; false for a comment, a blank line, or a bad frequency.
+    [[nodiscard]] bool parse_line(std::string_view line, std::string_view& word, std::uint64_t& frequency) noexcept {
+        if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+        }
+        if (line.empty() || line.starts_with('#')) {
+            return false;
+        }
+        frequency      = 1;
+        auto const tab = line.find('\t');
+        word           = line.substr(0, tab);
+        if (tab != std::string_view::npos) {
+            auto const number = line.substr(tab + 1);
+            auto const [ptr, err] =
+              std::from_chars(number.data(), number.data() + number.size(), frequency);
+            if (err != std::errc{} || ptr != number.data() + number.size()) {
+                return false;
+            }
+        }
+        return !word.empty();
+    }
+
+    /// The UTF-8 of `code`; its length.
+    [[nodiscard]] std::size_t to_utf8(char32_t const code, std::array<char, 4>& out) noexcept {
+        if (code < 0x80U) {
+            out[0] = static_cast<char>(code);
+            return 1;
+        }
+        if (code < 0x800U) {
+            out[0] = static_cast<char>(0xC0U | (code >> 6U));
+            out[1] = static_cast<char>(0x80U | (code & 0x3FU));
+            return 2;
+        }
+        if (code < 0x1'0000U) {
+            out[0] = static_cast<char>(0xE0U | (code >> 12U));
+            out[1] = static_cast<char>(0x80U | ((code >> 6U) & 0x3FU));
+            out[2] = static_cast<char>(0x80U | (code & 0x3FU));
+            return 3;
+        }
+        out[0] = static_cast<char>(0xF0U | (code >> 18U));
+        out[1] = static_cast<char>(0x80U | ((code >> 12U) & 0x3FU));
+        out[2] = static_cast<char>(0x80U | ((code >> 6U) & 0x3FU));
+        out[3] = static_cast<char>(0x80U | (code & 0x3FU));
+        return 4;
+    }
+} // namespace
+
+dictionary::dictionary(dictionary&& other) noexcept
+  : fd{std::exchange(other.fd, -1)},
+    base{std::exchange(other.base, nullptr)},
+    map_size{std::exchange(other.map_size, 0)},
+    top{other.top},
+    entries{std::move(other.entries)},
+    node_entry{std::move(other.node_entry)},
+    first_edge{std::move(other.first_edge)},
+    edge_labels{std::move(other.edge_labels)},
+    edge_nodes{std::move(other.edge_nodes)},
+    best{std::move(other.best)},
+    best_count{std::move(other.best_count)} {}
+
+dictionary& dictionary::operator=(dictionary&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd          = std::exchange(other.fd, -1);
+        base        = std::exchange(other.base, nullptr);
+        map_size    = std::exchange(other.map_size, 0);
+        top         = other.top;
+        entries     = std::move(other.entries);
+        node_entry  = std::move(other.node_entry);
+        first_edge  = std::move(other.first_edge);
+        edge_labels = std::move(other.edge_labels);
+        edge_nodes  = std::move(other.edge_nodes);
+        best        = std::move(other.best);
+        best_count  = std::move(other.best_count);
+    }
+    return *this;
+}
+
+bool dictionary::open(std::string_view const path, std::size_t const inp_top) noexcept {
+    close();
+    top = std::clamp<std::size_t>(inp_top, 1, std::numeric_limits<std::uint8_t>::max());
+    fd  = open_file(path);
+    if (fd == -1) [[unlikely]] {
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0) [[unlikely]] {
+        close();
+        return false;
+    }
+    if (auto const size = static_cast<std::size_t>(info.st_size); size != 0) {
+        void* const ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) [[unlikely]] {
+            close();
+            return false;
+        }
+        base     = static_cast<std::byte const*>(ptr);
+        map_size = size;
+    }
+    try {
+        build();
+    } catch (...) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void dictionary::close() noexcept {
+    if (base != nullptr) {
+        ::munmap(const_cast<std::byte*>(base), map_size); // NOLINT(*-const-cast)
+    }
+    if (fd != -1) {
+        ::close(fd);
+    }
+    fd       = -1;
+    base     = nullptr;
+    map_size = 0;
+    entries.clear();
+    node_entry.clear();
+    first_edge.clear();
+    edge_labels.clear();
+    edge_nodes.clear();
+    best.clear();
+    best_count.clear();
+}
+
+void dictionary::build() {
+    // The entries, sorted; the same word twice is one entry.
+    std::string_view text{reinterpret_cast<char const*>(base), map_size};
+    while (!text.empty()) {
+        auto const end  = text.find('\n');
+        auto const line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+        std::string_view word;
+        std::uint64_t    frequency = 0;
+        if (parse_line(line, word, frequency)) {
+            entries.push_back({.word = word, .frequency = frequency});
+        }
+    }
+    std::ranges::sort(entries, {}, &entry::word);
+    std::size_t kept = 0;
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        if (kept != 0 && entries[kept - 1].word == entries[index].word) {
+            entries[kept - 1].frequency += entries[index].frequency;
+            continue;
+        }
+        entries[kept++] = entries[index];
+    }
+    entries.resize(kept);
+    if (entries.size() >= no_entry) [[unlikely]] {
+        entries.resize(no_entry - 1);
+    }
+
+    // The trie, from the sorted words: a word shares the path of the one
+    // before it as far as they're the same, so the nodes come in pre-order,
+    // and the children of a node in the order of their labels.
+    std::vector<std::uint32_t> parents{0};
+    std::vector<char>          labels{0};
+    std::vector<std::uint32_t> path{0};
+    node_entry.assign(1, no_entry);
+    std::string_view previous;
+    for (entry_id id = 0; id < entries.size(); ++id) {
+        auto const  word   = entries[id].word;
+        std::size_t common = 0;
+        while (common < word.size() && common < previous.size() && word[common] == previous[common]) {
+            ++common;
+        }
+        path.resize(common + 1);
+        for (auto const byte : word.substr(common)) {
+            parents.push_back(path.back());
+            labels.push_back(byte);
+            node_entry.push_back(no_entry);
+            path.push_back(static_cast<std::uint32_t>(node_entry.size() - 1));
+        }
+        node_entry[path.back()] = id;
+        previous                = word;
+    }
+    auto const node_count = node_entry.size();
+
+    // The edges of each node next to each other; counted, then placed in the
+    // order of the nodes, which keeps them sorted.
+    first_edge.assign(node_count + 1, 0);
+    for (std::size_t node = 1; node < node_count; ++node) {
+        ++first_edge[parents[node] + 1];
+    }
+    for (std::size_t node = 0; node < node_count; ++node) {
+        first_edge[node + 1] += first_edge[node];
+    }
+    edge_labels.resize(node_count - 1);
+    edge_nodes.resize(node_count - 1);
+    std::vector<std::uint32_t> filled{first_edge.begin(), first_edge.end() - 1};
+    for (std::size_t node = 1; node < node_count; ++node) {
+        auto const pos   = filled[parents[node]]++;
+        edge_labels[pos] = labels[node];
+        edge_nodes[pos]  = static_cast<std::uint32_t>(node);
+    }
+
+    // The best entries of each node, from its own and its children's; the
+    // children come after their parent, so backwards has them ready.
+    auto const ranks_before = [this](entry_id const lhs, entry_id const rhs) noexcept {
+        auto const lhs_freq = entries[lhs].frequency;
+        auto const rhs_freq = entries[rhs].frequency;
+        return lhs_freq != rhs_freq ? lhs_freq > rhs_freq : lhs < rhs;
+    };
+    best.assign(node_count * top, no_entry);
+    best_count.assign(node_count, 0);
+    std::vector<entry_id> candidates;
+    for (auto node = node_count; node-- > 0;) {
+        candidates.clear();
+        if (node_entry[node] != no_entry) {
+            candidates.push_back(node_entry[node]);
+        }
+        for (auto edge = first_edge[node]; edge < first_edge[node + 1]; ++edge) {
+            auto const child_node = edge_nodes[edge];
+            auto const from       = best.begin() + static_cast<std::ptrdiff_t>(child_node * top);
+            candidates.insert(candidates.end(), from, from + best_count[child_node]);
+        }
+        auto const count = std::min(candidates.size(), top);
+        std::ranges::partial_sort(candidates, candidates.begin() + static_cast<std::ptrdiff_t>(count), ranks_before);
+        std::copy_n(candidates.begin(), count, best.begin() + static_cast<std::ptrdiff_t>(node * top));
+        best_count[node] = static_cast<std::uint8_t>(count);
+    }
+}
+
+std::uint32_t dictionary::child(std::uint32_t const node, char const label) const noexcept {
+    auto const from = edge_labels.begin() + first_edge[node];
+    auto const to   = edge_labels.begin() + first_edge[node + 1];
+    auto const pos  = std::lower_bound(from, to, label, [](char const lhs, char const rhs) noexcept {
+        return static_cast<unsigned char>(lhs) < static_cast<unsigned char>(rhs);
+    });
+    return pos != to && *pos == label ? edge_nodes[static_cast<std::size_t>(pos - edge_labels.begin())] : 0;
+}
+
+void dictionary::step(cursor& at, char const byte) const {
+    bool const was_in_trie = in_trie(at);
+    at.typed += byte;
+    if (!was_in_trie) {
+        return;
+    }
+    if (auto const next = child(at.path.empty() ? 0 : at.path.back(), byte); next != 0) {
+        at.path.push_back(next);
+    }
+}
+
+void dictionary::push(cursor& at, char32_t const code) const {
+    std::array<char, 4> bytes{};
+    auto const          size = to_utf8(code, bytes);
+    for (auto const byte : std::span{bytes}.first(size)) {
+        step(at, byte);
+    }
+    if (in_trie(at)) [[likely]] {
+        return;
+    }
+
+    // Fell off a phrase: the word after the last space might still be in
+    // there. What's typed after it has no spaces, so it's typed again at most
+    // once.
+    auto const space = at.typed.rfind(' ');
+    if (space == std::string::npos) {
+        return;
+    }
+    std::string const rest = at.typed.substr(space + 1);
+    reset(at);
+    for (auto const byte : rest) {
+        step(at, byte);
+    }
+}
+
+void dictionary::pop(cursor& at) const noexcept {
+    while (!at.typed.empty() && (static_cast<unsigned char>(at.typed.back()) & 0xC0U) == 0x80U) {
+        at.typed.pop_back();
+    }
+    if (!at.typed.empty()) {
+        at.typed.pop_back();
+    }
+    at.path.resize(std::min(at.path.size(), at.typed.size()));
+}
+
+std::span<dictionary::entry_id const> dictionary::completions(cursor const& at) const noexcept {
+    if (at.typed.empty() || !in_trie(at)) {
+        return {};
+    }
+    auto const node = at.path.back();
+    return {best.data() + (node * top), best_count[node]};
+}
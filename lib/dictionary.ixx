@@ -0,0 +1,135 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+export module fs8.lib.dictionary;
+
+export namespace fs8 {
+
+    /**
+     * A list of words (or phrases) and how often they're used, as a trie for
+     * completing what's being typed.
+     *
+     * The file is text, one entry per line:
+     *
+     *   word<TAB>frequency
+     *
+     * The frequency is optional (1), lines that start with `#` are comments,
+     * and a word that's in there twice gets the sum of its frequencies. The
+     * file is mapped, not read; the words are views into the mapping.
+     *
+     * The trie goes by the bytes of the UTF-8; a node's edges are sorted and
+     * next to each other. Every node keeps the best `top` entries under it
+     * (by frequency, then in alphabetical order), worked out once when the
+     * file's opened, so completing is a lookup, whatever's under the node.
+     */
+    struct [[nodiscard]] dictionary {
+        using entry_id = std::uint32_t;
+
+        /// How many completions each node keeps, unless asked otherwise.
+        static constexpr std::size_t default_top = 8;
+
+        /**
+         * Where the typing is in the trie: the node after each byte typed
+         * since the word started, for as long as the trie goes along.
+         */
+        struct [[nodiscard]] cursor {
+            std::string                typed; // UTF-8, since the start of the word
+            std::vector<std::uint32_t> path;  // the node after each byte of `typed` that's in the trie
+        };
+
+      private:
+        struct [[nodiscard]] entry {
+            std::string_view word;
+            std::uint64_t    frequency = 0;
+        };
+
+        int              fd       = -1;
+        std::byte const* base     = nullptr;
+        std::size_t      map_size = 0;
+        std::size_t      top      = default_top;
+
+        std::vector<entry>         entries;     // sorted by word
+        std::vector<entry_id>      node_entry;  // per node, the entry that ends there, or `no_entry`
+        std::vector<std::uint32_t> first_edge;  // per node, and one past the last: where its edges start
+        std::vector<char>          edge_labels; // sorted within a node's edges
+        std::vector<std::uint32_t> edge_nodes;
+        std::vector<entry_id>      best;       // [node * top + rank]
+        std::vector<std::uint8_t>  best_count; // per node
+
+        void build();
+
+        /// The child of `node` by `label`; 0 (the root) if there's none.
+        [[nodiscard]] std::uint32_t child(std::uint32_t node, char label) const noexcept;
+
+        /// Move along `byte`, if the trie goes that way.
+        void step(cursor& at, char byte) const;
+
+      public:
+        static constexpr entry_id no_entry = ~entry_id{0};
+
+        constexpr dictionary() noexcept = default;
+
+        dictionary(dictionary const&)            = delete;
+        dictionary& operator=(dictionary const&) = delete;
+        dictionary(dictionary&& other) noexcept;
+        dictionary& operator=(dictionary&& other) noexcept;
+
+        ~dictionary() noexcept {
+            close();
+        }
+
+        /// Map the file and build the trie; keep the best `inp_top` completions per node.
+        [[nodiscard]] bool open(std::string_view path, std::size_t inp_top = default_top) noexcept;
+        void               close() noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept {
+            return !first_edge.empty();
+        }
+
+        /// The entries.
+        [[nodiscard]] std::size_t size() const noexcept {
+            return entries.size();
+        }
+
+        [[nodiscard]] std::size_t nodes() const noexcept {
+            return node_entry.size();
+        }
+
+        [[nodiscard]] std::string_view word(entry_id const id) const noexcept {
+            return entries[id].word;
+        }
+
+        [[nodiscard]] std::uint64_t frequency(entry_id const id) const noexcept {
+            return entries[id].frequency;
+        }
+
+        /// Type `code` at `at`: one step per byte. A space the phrases don't
+        /// go on with starts a new word, from what was typed after it.
+        void push(cursor& at, char32_t code) const;
+
+        /// Take back the last code point typed.
+        void pop(cursor& at) const noexcept;
+
+        /// Start a new word.
+        static void reset(cursor& at) noexcept {
+            at.typed.clear();
+            at.path.clear();
+        }
+
+        /// Is `at` still in the trie?
+        [[nodiscard]] bool in_trie(cursor const& at) const noexcept {
+            return is_open() && at.path.size() == at.typed.size();
+        }
+
+        /// The best entries that start with what was typed at `at`, the best
+        /// first; none once the typing's left the trie, or before it starts.
+        [[nodiscard]] std::span<entry_id const> completions(cursor const& at) const noexcept;
+    };
+
+} // namespace fs8
@@ -0,0 +1,193 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <linux/input.h>
+#include <span>
+#include <vector>
+module fs8.lib.event_codec;
+import fs8.event;
+
+using fs8::event_decoder;
+using fs8::event_encoder;
+using fs8::event_type;
+
+namespace {
+    constexpr std::uint32_t literal_symbol = fs8::event_codec_symbols; // spelled out, not kept
+
+    [[nodiscard]] constexpr std::uint64_t zigzag(std::int64_t const value) noexcept {
+        return (static_cast<std::uint64_t>(value) << 1U) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    [[nodiscard]] constexpr std::int64_t unzigzag(std::uint64_t const value) noexcept {
+        return static_cast<std::int64_t>(value >> 1U) ^ -static_cast<std::int64_t>(value & 1U);
+    }
+
+    [[nodiscard]] std::byte* put_varint(std::byte* out, std::uint64_t value) noexcept {
+        while (value >= 0x80U) {
+            *out++   = static_cast<std::byte>(value | 0x80U);
+            value >>= 7U;
+        }
+        *out++ = static_cast<std::byte>(value);
+        return out;
+    }
+
+    /// Reads a varint at `pos`, moving it past; false if it runs past `end`,
+    /// or past 64 bits.
+    [[nodiscard]] bool get_varint(std::byte const*& pos, std::byte const* const end, std::uint64_t& value) noexcept {
+        if (pos != end && (*pos & std::byte{0x80}) == std::byte{}) [[likely]] {
+            value = static_cast<std::uint64_t>(*pos++);
+            return true;
+        }
+        value = 0;
+        for (unsigned shift = 0; pos != end && shift < 64; shift += 7) {
+            auto const byte  = static_cast<std::uint64_t>(*pos++);
+            value           |= (byte & 0x7FU) << shift;
+            if (byte < 0x80U) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] constexpr std::uint64_t key_of(event_type const& event) noexcept {
+        return static_cast<std::uint64_t>(event.type())
+             | (static_cast<std::uint64_t>(event.code()) << 16U)
+             | (static_cast<std::uint64_t>(event.source()) << 32U);
+    }
+
+    [[nodiscard]] constexpr std::size_t hash_of(std::uint64_t const key, std::size_t const mask) noexcept {
+        return static_cast<std::size_t>((key * 0x9E37'79B9'7F4A'7C15ULL) >> 32U) & mask;
+    }
+} // namespace
+
+// --- encoder ---
+
+std::size_t event_encoder::encode(event_type const& event, std::span<std::byte> const out) noexcept {
+    if (out.size() < max_encoded_event_size) [[unlikely]] {
+        return 0;
+    }
+    auto const key  = key_of(event);
+    auto const time = static_cast<std::int64_t>(event.micro_time().count());
+
+    // Find its symbol, or give it one if there are any left.
+    constexpr auto mask = std::tuple_size_v<decltype(table)> - 1;
+    auto           pos  = hash_of(key, mask);
+    while (table[pos].symbol != 0 && table[pos].key != key) {
+        pos = (pos + 1) & mask;
+    }
+    auto&         cur    = table[pos];
+    bool const    known  = cur.symbol != 0;
+    std::uint32_t symbol = literal_symbol;
+    std::int32_t  last   = 0;
+    if (known) [[likely]] {
+        symbol = cur.symbol - 1;
+        last   = cur.value;
+    } else if (symbols < event_codec_symbols) {
+        symbol     = symbols++;
+        cur.key    = key;
+        cur.symbol = symbol + 1;
+    }
+
+    auto*      ptr      = out.data();
+    bool const has_time = time != last_time;
+    ptr                 = put_varint(ptr, (std::uint64_t{symbol} << 1U) | (has_time ? 1U : 0U));
+    if (!known) {
+        ptr = put_varint(ptr, event.type());
+        ptr = put_varint(ptr, event.code());
+        ptr = put_varint(ptr, static_cast<std::uint32_t>(event.source()));
+    }
+    if (has_time) {
+        ptr       = put_varint(ptr, zigzag(time - last_time));
+        last_time = time;
+    }
+    ptr = put_varint(ptr, zigzag(std::int64_t{event.value()} - last));
+    if (symbol != literal_symbol) {
+        cur.value = event.value();
+    }
+    return static_cast<std::size_t>(ptr - out.data());
+}
+
+void event_encoder::encode(event_type const& event, std::vector<std::byte>& out) {
+    auto const size = out.size();
+    out.resize(size + max_encoded_event_size);
+    out.resize(size + encode(event, std::span{out}.subspan(size)));
+}
+
+void event_encoder::reset() noexcept {
+    table.fill({});
+    symbols   = 0;
+    last_time = 0;
+}
+
+// --- decoder ---
+
+std::size_t event_decoder::decode(std::span<std::byte const> const in, event_type& out) noexcept {
+    auto const* pos = in.data();
+    auto const* end = pos + in.size();
+
+    std::uint64_t head = 0;
+    if (!get_varint(pos, end, head)) [[unlikely]] {
+        return 0;
+    }
+    auto const symbol = head >> 1U;
+    entry      literal{};
+    entry*     cur = &literal;
+    if (symbol < symbols) [[likely]] {
+        cur = &entries[symbol];
+    } else {
+        // A new one; it takes the next symbol, unless they're all taken.
+        if (symbol != (symbols < event_codec_symbols ? symbols : literal_symbol)) [[unlikely]] {
+            return 0;
+        }
+        std::uint64_t type   = 0;
+        std::uint64_t code   = 0;
+        std::uint64_t device = 0;
+        if (!get_varint(pos, end, type) || !get_varint(pos, end, code) || !get_varint(pos, end, device)) [[unlikely]] {
+            return 0;
+        }
+        literal.type   = static_cast<event_type::type_type>(type);
+        literal.code   = static_cast<event_type::code_type>(code);
+        literal.device = static_cast<std::uint32_t>(device);
+    }
+
+    auto time = last_time;
+    if ((head & 1U) != 0) {
+        std::uint64_t delta = 0;
+        if (!get_varint(pos, end, delta)) [[unlikely]] {
+            return 0;
+        }
+        time += unzigzag(delta);
+    }
+    std::uint64_t delta = 0;
+    if (!get_varint(pos, end, delta)) [[unlikely]] {
+        return 0;
+    }
+
+    // Whole; only now does the state move on.
+    auto const value = static_cast<std::int32_t>(cur->value + unzigzag(delta));
+    if (cur == &literal && symbols < event_codec_symbols) {
+        cur = &entries[symbols++];
+        *cur = literal;
+    }
+    cur->value = value;
+    last_time  = time;
+
+    input_event raw{};
+    raw.time.tv_sec  = static_cast<decltype(raw.time.tv_sec)>(time / 1'000'000);
+    raw.time.tv_usec = static_cast<decltype(raw.time.tv_usec)>(time % 1'000'000);
+    raw.type         = cur->type;
+    raw.code         = cur->code;
+    raw.value        = value;
+    out              = event_type{raw};
+    out.source(static_cast<fs8::device_id>(cur->device));
+    return static_cast<std::size_t>(pos - in.data());
+}
+
+void event_decoder::reset() noexcept {
+    symbols   = 0;
+    last_time = 0;
+}
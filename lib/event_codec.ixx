@@ -0,0 +1,86 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+export module fs8.lib.event_codec;
+import fs8.event;
+
+export namespace fs8 {
+
+    /**
+     * A compact encoding for streams of events.
+     *
+     * Every event is a few LEB128 varints:
+     *
+     *   symbol << 1 | has_time   which (type, code, device); a new one's spelled out
+     *   [type, code, device]     only for a new symbol
+     *   [time delta]             µs since the previous event, zigzag; if has_time
+     *   value delta              against the last value of the same symbol, zigzag
+     *
+     * The symbols are handed out in the order the (type, code, device) triples
+     * are first seen, the first `event_codec_symbols` of them; the rest are
+     * spelled out every time. So the events of a frame (no time delta), a SYN
+     * or a small mouse move take 2 to 4 bytes, instead of the 24 of an
+     * `input_event`.
+     *
+     * The encoder and the decoder keep the same state, so a stream has to be
+     * decoded from where it was encoded from, e.g. the start of a file or
+     * of a message; `reset()` both ends to start another.
+     */
+    constexpr std::size_t event_codec_symbols = 1024;
+
+    /// The most bytes one event can take.
+    constexpr std::size_t max_encoded_event_size = 32;
+
+    struct [[nodiscard]] event_encoder {
+        constexpr event_encoder() noexcept = default;
+
+        /// Encode `event` into `out`; the bytes written, 0 if `out` is shorter
+        /// than `max_encoded_event_size`.
+        [[nodiscard]] std::size_t encode(event_type const& event, std::span<std::byte> out) noexcept;
+
+        /// Append the encoding of `event` to `out`.
+        void encode(event_type const& event, std::vector<std::byte>& out);
+
+        void reset() noexcept;
+
+      private:
+        struct [[nodiscard]] slot {
+            std::uint64_t key    = 0; // type | code << 16 | device << 32
+            std::uint32_t symbol = 0; // plus one; 0 -> empty
+            std::int32_t  value  = 0;
+        };
+
+        // Open addressing, at most half full.
+        std::array<slot, event_codec_symbols * 2> table{};
+        std::uint32_t                             symbols   = 0;
+        std::int64_t                              last_time = 0;
+    };
+
+    struct [[nodiscard]] event_decoder {
+        constexpr event_decoder() noexcept = default;
+
+        /// Decode the event `in` starts with into `out`; the bytes read, 0 if
+        /// `in` doesn't hold a whole event, or it's not a valid encoding.
+        [[nodiscard]] std::size_t decode(std::span<std::byte const> in, event_type& out) noexcept;
+
+        void reset() noexcept;
+
+      private:
+        struct [[nodiscard]] entry {
+            event_type::type_type type   = 0;
+            event_type::code_type code   = 0;
+            std::uint32_t         device = 0;
+            std::int32_t          value  = 0;
+        };
+
+        std::array<entry, event_codec_symbols> entries{}; // by symbol
+        std::uint32_t                          symbols   = 0;
+        std::int64_t                           last_time = 0;
+    };
+
+} // namespace fs8
@@ -0,0 +1,505 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <linux/input.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <stop_token>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <utility>
+module fs8.lib.recording;
+import fs8.event;
+
+using fs8::event_type;
+using fs8::recorded_event;
+using fs8::recording_block;
+using fs8::recording_header;
+using fs8::recording_reader;
+using fs8::recording_writer;
+
+namespace {
+    constexpr std::size_t header_size = sizeof(recording_header);
+
+    /// The file's allocated ahead by as much as it has, but never by more than this.
+    constexpr std::size_t max_growth = std::size_t{64} << 20U;
+
+    /// The address space a writer maps at once; only as much of it as the
+    /// file has is ever touched.
+    constexpr std::size_t window_size = sizeof(void*) >= 8 ? std::size_t{64} << 30U : std::size_t{1} << 30U;
+
+    /// The first mapping: the header, and 16 blocks (1 MiB).
+    constexpr std::size_t initial_size = header_size + (std::size_t{16} * fs8::recording_block_size);
+
+    [[nodiscard]] constexpr std::size_t block_offset(std::uint64_t const index) noexcept {
+        return header_size + (static_cast<std::size_t>(index) * fs8::recording_block_size);
+    }
+
+    /// The counts are published by the writer, maybe from another process.
+    template <typename T>
+    [[nodiscard]] T load_acquire(T const& value) noexcept {
+        return std::atomic_ref<T>{const_cast<T&>(value)}.load(std::memory_order_acquire); // NOLINT(*-const-cast)
+    }
+
+    template <typename T>
+    void store_release(T& value, T const new_value) noexcept {
+        std::atomic_ref<T>{value}.store(new_value, std::memory_order_release);
+    }
+
+    [[nodiscard]] std::int64_t micros_of(event_type const& event) noexcept {
+        return static_cast<std::int64_t>(event.micro_time().count());
+    }
+
+    [[nodiscard]] bool is_valid(recording_header const& hdr) noexcept {
+        return hdr.magic == recording_header::file_magic
+            && hdr.version == recording_header::file_version
+            && hdr.record_size == sizeof(recorded_event)
+            && hdr.block_size == fs8::recording_block_size
+            && hdr.block_records == fs8::recording_block_records;
+    }
+
+    [[nodiscard]] int open_file(std::string_view const path, int const flags) noexcept try {
+        std::string const c_path{path};
+        int               fd = -1;
+        do {
+            fd = ::open(c_path.c_str(), flags | O_CLOEXEC, 0644);
+        } while (fd == -1 && errno == EINTR);
+        return fd;
+    } catch (...) {
+        return -1;
+    }
+} // namespace
+
+// --- writer ---
+
+/// Allocates the file, and faults its pages in, ahead of the writer, on a
+/// thread of its own. `extend` runs under `extending`, from here or, when
+/// this thread's behind, from the writer; `lock` is only ever held for a
+/// look at `wanted`, so the writer can take it to wake the thread up.
+struct recording_writer::grower {
+    int                      fd   = -1;
+    std::byte*               base = nullptr;
+    std::atomic<std::size_t> ready{0};  // the file's allocated and faulted in this far
+    std::atomic<std::size_t> wanted{0}; // the end of the writer's block
+    std::size_t              window = 0;
+    std::atomic<bool>        failed{false}; // out of space; the writer finds out on its own
+
+    std::mutex                  extending;
+    std::mutex                  lock;
+    std::condition_variable_any wake;
+    std::jthread                thread; // last: everything above is ready before it starts
+
+    grower(int const inp_fd, std::byte* const inp_base, std::size_t const inp_window, std::size_t const inp_ready)
+      : fd{inp_fd},
+        base{inp_base},
+        ready{inp_ready},
+        wanted{inp_ready},
+        window{inp_window} {
+        thread = std::jthread{[this](std::stop_token const stop) noexcept {
+            run(stop);
+        }};
+    }
+
+    /// As far ahead of `end` as the file's allocated.
+    [[nodiscard]] static std::size_t lead(std::size_t const end) noexcept {
+        return std::clamp(end, initial_size, max_growth);
+    }
+
+    /// Less than half the lead is left.
+    [[nodiscard]] bool behind() const noexcept {
+        auto const end = wanted.load(std::memory_order_relaxed);
+        return !failed.load(std::memory_order_relaxed) && ready.load(std::memory_order_relaxed) < std::min(window, end + (lead(end) / 2));
+    }
+
+    /// Allocate the file up to `end`, and fault the pages in; `extending` is held.
+    bool extend(std::size_t end) noexcept {
+        end             = std::min(end, window);
+        auto const from = ready.load(std::memory_order_relaxed);
+        if (end <= from) {
+            return true;
+        }
+        if (::fallocate(fd, 0, static_cast<off_t>(from), static_cast<off_t>(end - from)) != 0) {
+            // Sparse then, as the filesystem can't allocate ahead.
+            struct stat info{};
+            if ((errno != EOPNOTSUPP && errno != ENOSYS)
+                || ::fstat(fd, &info) != 0
+                || (static_cast<std::size_t>(info.st_size) < end && ::ftruncate(fd, static_cast<off_t>(end)) != 0))
+            {
+                failed.store(true, std::memory_order_relaxed);
+                return false;
+            }
+        }
+#ifdef MADV_POPULATE_WRITE
+        // The page tables only; what's written there already stays.
+        auto const page  = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        auto const first = from & ~(page - 1);
+        std::ignore      = ::madvise(base + first, end - first, MADV_POPULATE_WRITE);
+#endif
+        ready.store(end, std::memory_order_release);
+        return true;
+    }
+
+    /// Writer: it's writing up to `end` now.
+    void want(std::size_t const end) noexcept {
+        wanted.store(end, std::memory_order_relaxed);
+        if (behind()) {
+            // Either the thread sees `wanted` before it sleeps, or it's asleep
+            // by the time the lock's ours.
+            { std::scoped_lock const guard{lock}; }
+            wake.notify_one();
+        }
+    }
+
+    void run(std::stop_token const stop) noexcept {
+        for (;;) {
+            {
+                std::unique_lock guard{lock};
+                if (!wake.wait(guard, stop, [this]() noexcept {
+                        return behind();
+                    }))
+                {
+                    return;
+                }
+            }
+            std::scoped_lock const busy{extending};
+            auto const             end = wanted.load(std::memory_order_relaxed);
+            std::ignore                = extend(end + lead(end));
+        }
+    }
+};
+
+recording_writer::recording_writer() noexcept = default;
+
+recording_writer::~recording_writer() noexcept {
+    close();
+}
+
+recording_writer::recording_writer(recording_writer&& other) noexcept
+  : fd{std::exchange(other.fd, -1)},
+    base{std::exchange(other.base, nullptr)},
+    map_size{std::exchange(other.map_size, 0)},
+    block{std::exchange(other.block, nullptr)},
+    last_time{other.last_time},
+    events{std::exchange(other.events, 0)},
+    ahead{std::move(other.ahead)} {}
+
+recording_writer& recording_writer::operator=(recording_writer&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd        = std::exchange(other.fd, -1);
+        base      = std::exchange(other.base, nullptr);
+        map_size  = std::exchange(other.map_size, 0);
+        block     = std::exchange(other.block, nullptr);
+        last_time = other.last_time;
+        events    = std::exchange(other.events, 0);
+        ahead     = std::move(other.ahead);
+    }
+    return *this;
+}
+
+recording_header* recording_writer::header() const noexcept {
+    return reinterpret_cast<recording_header*>(base);
+}
+
+bool recording_writer::reserve(std::size_t const end) noexcept {
+    if (ahead == nullptr || end > map_size) [[unlikely]] {
+        return false; // the window's full
+    }
+    ahead->want(end);
+    if (end <= ahead->ready.load(std::memory_order_acquire)) [[likely]] {
+        return true;
+    }
+    // The thread's behind; wait for the room like it would.
+    std::scoped_lock const guard{ahead->extending};
+    return ahead->extend(end);
+}
+
+bool recording_writer::start_block(std::int64_t const time) noexcept {
+    auto const index = header()->block_count;
+    if (!reserve(block_offset(index + 1))) [[unlikely]] {
+        block = nullptr;
+        return false;
+    }
+    block = std::construct_at(reinterpret_cast<recording_block*>(base + block_offset(index)));
+    block->base_time   = time;
+    block->last_time   = time;
+    block->first_event = events;
+    store_release(header()->block_count, index + 1);
+    last_time = time;
+    return true;
+}
+
+bool recording_writer::open(std::string_view const path) noexcept {
+    close();
+    fd = open_file(path, O_RDWR | O_CREAT);
+    if (fd == -1) [[unlikely]] {
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0) [[unlikely]] {
+        close();
+        return false;
+    }
+    auto const size = static_cast<std::size_t>(info.st_size);
+    if (size != 0 && size < header_size) [[unlikely]] {
+        close();
+        return false;
+    }
+
+    // The mapping never moves; the file grows into it.
+    auto const window = std::max(window_size, std::bit_ceil(size) * 2);
+    void* const ptr   = ::mmap(nullptr, window, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) [[unlikely]] {
+        close();
+        return false;
+    }
+    base     = static_cast<std::byte*>(ptr);
+    map_size = window;
+
+    // Append to it, starting with a new block; it's not grown before it's
+    // known to be a recording.
+    if (size != 0) {
+        auto const& hdr = *header();
+        if (!is_valid(hdr) || block_offset(hdr.block_count) > size) [[unlikely]] {
+            close(); // not ours; leave it be
+            return false;
+        }
+        if (hdr.block_count != 0) {
+            auto const& last = *reinterpret_cast<recording_block const*>(base + block_offset(hdr.block_count - 1));
+            events           = last.first_event + last.count;
+        }
+    }
+    try {
+        ahead = std::make_unique<grower>(fd, base, window, size);
+    } catch (...) {
+        close();
+        return false;
+    }
+    if (size == 0) {
+        if (!reserve(initial_size)) [[unlikely]] {
+            close();
+            return false;
+        }
+        auto* const hdr    = std::construct_at(header());
+        hdr->record_size   = sizeof(recorded_event);
+        hdr->block_size    = recording_block_size;
+        hdr->block_records = recording_block_records;
+    }
+    return true;
+}
+
+void recording_writer::close() noexcept {
+    auto const allocated = ahead == nullptr ? 0 : ahead->ready.load(std::memory_order_acquire);
+    ahead.reset(); // stops allocating ahead
+    if (base != nullptr) {
+        // Drop the room that was allocated ahead but never used; past the
+        // end of the file the mapping isn't to be touched, and a file that
+        // isn't a recording is left be.
+        ::msync(base, std::min(allocated, map_size), MS_ASYNC);
+        if (allocated >= header_size && is_valid(*header())) {
+            std::ignore = ::ftruncate(fd, static_cast<off_t>(block_offset(header()->block_count)));
+        }
+        ::munmap(base, map_size);
+    }
+    if (fd != -1) {
+        ::close(fd);
+    }
+    fd        = -1;
+    base      = nullptr;
+    map_size  = 0;
+    block     = nullptr;
+    last_time = 0;
+    events    = 0;
+}
+
+bool recording_writer::write(event_type const& event) noexcept {
+    if (base == nullptr) [[unlikely]] {
+        return false;
+    }
+    auto const time  = micros_of(event);
+    auto const delta = time - last_time;
+    if (block == nullptr
+        || block->count == recording_block_records
+        || delta > std::numeric_limits<std::int32_t>::max()
+        || delta < std::numeric_limits<std::int32_t>::min()) [[unlikely]]
+    {
+        if (!start_block(time)) {
+            return false;
+        }
+    }
+    auto const  count  = block->count;
+    auto* const record = reinterpret_cast<recorded_event*>(block + 1) + count;
+    record->delta      = static_cast<std::int32_t>(time - last_time); // 0 for the first of a block
+    record->type       = event.type();
+    record->code       = event.code();
+    record->value      = event.value();
+    record->device     = static_cast<std::uint32_t>(event.source());
+    block->last_time = time;
+    store_release(block->count, count + 1);
+    last_time = time;
+    ++events;
+    return true;
+}
+
+// --- reader ---
+
+recording_reader::recording_reader(recording_reader&& other) noexcept
+  : fd{std::exchange(other.fd, -1)},
+    base{std::exchange(other.base, nullptr)},
+    map_size{std::exchange(other.map_size, 0)},
+    hdr{std::exchange(other.hdr, nullptr)} {}
+
+recording_reader& recording_reader::operator=(recording_reader&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd       = std::exchange(other.fd, -1);
+        base     = std::exchange(other.base, nullptr);
+        map_size = std::exchange(other.map_size, 0);
+        hdr      = std::exchange(other.hdr, nullptr);
+    }
+    return *this;
+}
+
+bool recording_reader::open(std::string_view const path) noexcept {
+    close();
+    fd = open_file(path, O_RDONLY);
+    if (fd == -1) [[unlikely]] {
+        return false;
+    }
+    if (!refresh()) [[unlikely]] {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void recording_reader::close() noexcept {
+    if (base != nullptr) {
+        ::munmap(const_cast<std::byte*>(base), map_size); // NOLINT(*-const-cast)
+    }
+    if (fd != -1) {
+        ::close(fd);
+    }
+    fd       = -1;
+    base     = nullptr;
+    map_size = 0;
+    hdr      = nullptr;
+}
+
+bool recording_reader::refresh() noexcept {
+    struct stat info{};
+    if (fd == -1 || ::fstat(fd, &info) != 0) [[unlikely]] {
+        return false;
+    }
+    auto const size = static_cast<std::size_t>(info.st_size);
+    if (size < header_size) [[unlikely]] {
+        return false;
+    }
+    if (size != map_size) {
+        void* const ptr = base == nullptr ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)
+                                          : ::mremap(const_cast<std::byte*>(base), map_size, size, MREMAP_MAYMOVE); // NOLINT(*-const-cast)
+        if (ptr == MAP_FAILED) [[unlikely]] {
+            return false;
+        }
+        base     = static_cast<std::byte const*>(ptr);
+        map_size = size;
+        hdr      = reinterpret_cast<recording_header const*>(base);
+    }
+    return is_valid(*hdr);
+}
+
+std::uint64_t recording_reader::block_count() const noexcept {
+    if (hdr == nullptr) [[unlikely]] {
+        return 0;
+    }
+    return std::min<std::uint64_t>(load_acquire(hdr->block_count), (map_size - header_size) / recording_block_size);
+}
+
+recording_block const& recording_reader::block(std::uint64_t const index) const noexcept {
+    return *reinterpret_cast<recording_block const*>(base + block_offset(index));
+}
+
+std::span<recorded_event const> recording_reader::records(std::uint64_t const index) const noexcept {
+    auto const& cur   = block(index);
+    auto const  count = std::min(load_acquire(cur.count), recording_block_records);
+    return {reinterpret_cast<recorded_event const*>(reinterpret_cast<std::byte const*>(&cur + 1)), count};
+}
+
+std::uint64_t recording_reader::size() const noexcept {
+    auto const blocks = block_count();
+    if (blocks == 0) {
+        return 0;
+    }
+    auto const& last = block(blocks - 1);
+    return last.first_event + records(blocks - 1).size();
+}
+
+recording_reader::cursor recording_reader::seek(std::int64_t const time) const noexcept {
+    auto const blocks = block_count();
+    // The first block that isn't over by `time`.
+    std::uint64_t low  = 0;
+    std::uint64_t high = blocks;
+    while (low < high) {
+        auto const mid = low + ((high - low) / 2);
+        if (block(mid).last_time < time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    cursor at{.block = low};
+    for (cursor probe = at; auto const event = next(probe);) {
+        if (micros_of(*event) >= time) {
+            break;
+        }
+        at = probe;
+    }
+    return at;
+}
+
+std::optional<event_type> recording_reader::next(cursor& at) const noexcept {
+    auto const blocks = block_count();
+    while (at.block < blocks) {
+        auto const recs = records(at.block);
+        if (at.index < recs.size()) {
+            if (at.index == 0) {
+                at.time = block(at.block).base_time;
+            }
+            auto const& rec = recs[at.index++];
+            at.time        += rec.delta;
+
+            input_event raw{};
+            raw.time.tv_sec  = static_cast<decltype(raw.time.tv_sec)>(at.time / 1'000'000);
+            raw.time.tv_usec = static_cast<decltype(raw.time.tv_usec)>(at.time % 1'000'000);
+            raw.type         = rec.type;
+            raw.code         = rec.code;
+            raw.value        = rec.value;
+            event_type event{raw};
+            event.source(static_cast<fs8::device_id>(rec.device));
+            return event;
+        }
+        if (at.block + 1 == blocks) {
+            break; // the writer may not be done with it
+        }
+        ++at.block;
+        at.index = 0;
+    }
+    return std::nullopt;
+}
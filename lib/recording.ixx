@@ -0,0 +1,184 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+export module fs8.lib.recording;
+import fs8.event;
+
+export namespace fs8 {
+
+    /**
+     * The recording file: a header, then fixed-size blocks of fixed-size
+     * records, all in the host's byte order:
+     *
+     *   recording_header | block 0 | block 1 | ...
+     *   block:           recording_block | recorded_event × block_records
+     *
+     * The block headers are the index: block `n` is at a known offset, and it
+     * says when its first and last events happened and how many events came
+     * before it, so a reader can seek by time or by event without touching the
+     * records. The timestamps are deltas against the previous event of the
+     * block; the first one's against the block's `base_time`.
+     *
+     * The writer publishes the counts last (`block_count`, then each block's
+     * `count`), so the file can be read while it's being written, or after a
+     * crash, up to the last complete record.
+     */
+    struct [[nodiscard]] recording_header {
+        static constexpr std::uint32_t file_magic   = 0x65'38'73'66; // "fs8e"
+        static constexpr std::uint16_t file_version = 1;
+
+        std::uint32_t             magic         = file_magic;
+        std::uint16_t             version       = file_version;
+        std::uint16_t             record_size   = 0; ///< bytes per `recorded_event`
+        std::uint32_t             block_size    = 0; ///< bytes per block, its header included
+        std::uint32_t             block_records = 0; ///< records a block holds
+        std::uint64_t             block_count   = 0; ///< blocks started; the last one may be partly filled
+        std::array<std::byte, 40> reserved{};
+    };
+
+    /// The header of a block, and the entry of the index.
+    struct [[nodiscard]] recording_block {
+        std::int64_t  base_time   = 0; ///< µs since the epoch, of the first event
+        std::int64_t  last_time   = 0; ///< µs since the epoch, of the last event
+        std::uint64_t first_event = 0; ///< the events recorded before this block
+        std::uint32_t count       = 0; ///< records written into this block
+        std::uint32_t reserved    = 0;
+    };
+
+    /// One event, in 16 bytes instead of the 24 + 4 of an `event_type`.
+    struct [[nodiscard]] recorded_event {
+        std::int32_t  delta  = 0; ///< µs since the previous event of the block
+        std::uint16_t type   = 0;
+        std::uint16_t code   = 0;
+        std::int32_t  value  = 0;
+        std::uint32_t device = 0; ///< the `device_id` of the source
+    };
+
+    static_assert(sizeof(recording_header) == 64);
+    static_assert(sizeof(recording_block) == 32);
+    static_assert(sizeof(recorded_event) == 16);
+
+    /// 64 KiB blocks.
+    constexpr std::uint32_t recording_block_size    = 64U * 1024U;
+    constexpr std::uint32_t recording_block_records = (recording_block_size - sizeof(recording_block)) / sizeof(recorded_event);
+
+    /**
+     * Appends events to a recording file through a shared mapping.
+     *
+     * A write is a couple of stores into the mapping; the kernel writes the
+     * pages back on its own time. The mapping is a large window reserved up
+     * front, so it never moves, and a thread of the writer's own keeps the
+     * file allocated (`fallocate`) and its pages faulted in
+     * (`MADV_POPULATE_WRITE`) ahead of the block being written; the writes
+     * don't wait for the filesystem unless that thread falls behind.
+     */
+    struct [[nodiscard]] recording_writer {
+      private:
+        struct grower; // the thread that allocates ahead
+
+        int                     fd        = -1;
+        std::byte*              base      = nullptr;
+        std::size_t             map_size  = 0;       // the window, not the file
+        recording_block*        block     = nullptr; // the one being written
+        std::int64_t            last_time = 0;
+        std::uint64_t           events    = 0;
+        std::unique_ptr<grower> ahead;
+
+        [[nodiscard]] recording_header* header() const noexcept;
+        [[nodiscard]] bool              reserve(std::size_t end) noexcept;
+        [[nodiscard]] bool              start_block(std::int64_t time) noexcept;
+
+      public:
+        recording_writer() noexcept;
+
+        recording_writer(recording_writer const&)            = delete;
+        recording_writer& operator=(recording_writer const&) = delete;
+        recording_writer(recording_writer&& other) noexcept;
+        recording_writer& operator=(recording_writer&& other) noexcept;
+
+        ~recording_writer() noexcept;
+
+        /// Create the file, or append to it if it's a recording already.
+        [[nodiscard]] bool open(std::string_view path) noexcept;
+        void               close() noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept {
+            return base != nullptr;
+        }
+
+        /// False if the file couldn't grow; the event is lost then.
+        bool write(event_type const& event) noexcept;
+
+        /// The events in the file, the ones recorded before it was opened included.
+        [[nodiscard]] std::uint64_t size() const noexcept {
+            return events;
+        }
+    };
+
+    /**
+     * Reads a recording file through a read-only mapping: nothing is loaded
+     * or parsed up front, the pages come in as the events are read.
+     */
+    struct [[nodiscard]] recording_reader {
+        /// Where a reader is in the file.
+        struct [[nodiscard]] cursor {
+            std::uint64_t block = 0;
+            std::uint32_t index = 0;
+            std::int64_t  time  = 0;
+        };
+
+      private:
+        int                     fd       = -1;
+        std::byte const*        base     = nullptr;
+        std::size_t             map_size = 0;
+        recording_header const* hdr      = nullptr;
+
+      public:
+        constexpr recording_reader() noexcept = default;
+
+        recording_reader(recording_reader const&)            = delete;
+        recording_reader& operator=(recording_reader const&) = delete;
+        recording_reader(recording_reader&& other) noexcept;
+        recording_reader& operator=(recording_reader&& other) noexcept;
+
+        ~recording_reader() noexcept {
+            close();
+        }
+
+        [[nodiscard]] bool open(std::string_view path) noexcept;
+        void               close() noexcept;
+
+        /// Map what the writer added since; false if the file went bad.
+        [[nodiscard]] bool refresh() noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept {
+            return hdr != nullptr;
+        }
+
+        /// The blocks there's room for in the mapping, of the ones started.
+        [[nodiscard]] std::uint64_t block_count() const noexcept;
+
+        [[nodiscard]] recording_block const& block(std::uint64_t index) const noexcept;
+
+        /// The complete records of a block.
+        [[nodiscard]] std::span<recorded_event const> records(std::uint64_t index) const noexcept;
+
+        /// The events in the file, as far as it's mapped.
+        [[nodiscard]] std::uint64_t size() const noexcept;
+
+        /// The first event at or after `time` (µs since the epoch), found
+        /// through the index.
+        [[nodiscard]] cursor seek(std::int64_t time) const noexcept;
+
+        /// The event at `at`, and move past it; nothing at the end.
+        [[nodiscard]] std::optional<event_type> next(cursor& at) const noexcept;
+    };
+
+} // namespace fs8
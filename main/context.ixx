@@ -1,18 +1,23 @@
 // Created by moisrex on 6/8/25.
 
 module;
+#include <array>
 #include <concepts>
 #include <cstdint>
 #include <functional>
+#include <span>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 export module fs8.context;
 export import fs8.event;
 export import :vars;
 import fs8.event;
 import fs8.log;
+import fs8.metrics;
+import fs8.spans;
 import fs8.traits;
 import dynamic_scoping;
 
@@ -161,6 +166,9 @@ export namespace fs8 {
         next_event,
         toggle_on,
         toggle_off,
+        frame,
+        flush,
+        timer,
     };
 
     /// A tag; carries its runtime `dynamic_tag` id so type-erased contexts can dispatch on it.
@@ -176,6 +184,9 @@ export namespace fs8 {
     using toggle_off_tag = basic_tag<dynamic_tag::toggle_off>;
     using next_event_tag = basic_tag<dynamic_tag::next_event>;
     using load_event_tag = basic_tag<dynamic_tag::load_event>;
+    using frame_tag      = basic_tag<dynamic_tag::frame>;
+    using flush_tag      = basic_tag<dynamic_tag::flush>;
+    using timer_tag      = basic_tag<dynamic_tag::timer>;
 
     /// Run the context mods, don't run the initialization and other setup actions of the mods.
     constexpr no_init_tag no_init{};
@@ -194,6 +205,89 @@ export namespace fs8 {
     /// set_events are done.
     constexpr load_event_tag load_event{};
 
+    /// Hands a `FrameModifier` a whole `event_frame` at once, instead of its events one by one.
+    constexpr frame_tag frame_dispatch{};
+
+    /// Tells the output mods to write out the events they're holding back; the pipeline sends it
+    /// right before it blocks for new events.
+    constexpr flush_tag flush_output{};
+
+    /// Lets the mods act on their timers; the pipeline sends it each time it wakes up from
+    /// `load_event`, and the mods check their own deadlines (see `io_manager.wake_at`).
+    constexpr timer_tag timer_expired{};
+
+    /**
+     * The events of one `SYN_REPORT` frame (the report itself last), handed to
+     * a `FrameModifier` in a single call. The mod may change the events in
+     * place, drop some with `erase_if` and add its own with `emit`; whatever is
+     * left goes on down the pipeline one event at a time.
+     *
+     * A frame comes without its report when the event providers run dry in the
+     * middle of one (see `ends_with_report`).
+     */
+    struct [[nodiscard]] event_frame {
+        constexpr explicit event_frame(std::vector<event_type> &inp_events) noexcept : events_{&inp_events} {}
+
+        [[nodiscard]] constexpr std::span<event_type> events() const noexcept {
+            return *events_;
+        }
+
+        [[nodiscard]] constexpr auto begin() const noexcept {
+            return events().begin();
+        }
+
+        [[nodiscard]] constexpr auto end() const noexcept {
+            return events().end();
+        }
+
+        [[nodiscard]] constexpr std::size_t size() const noexcept {
+            return events_->size();
+        }
+
+        [[nodiscard]] constexpr bool empty() const noexcept {
+            return events_->empty();
+        }
+
+        [[nodiscard]] constexpr event_type &back() const noexcept {
+            return events_->back();
+        }
+
+        [[nodiscard]] constexpr bool ends_with_report() const noexcept {
+            return !empty() && is_syn_report(back());
+        }
+
+        /// Drop the events matching `pred`, keeping the order of the rest.
+        template <typename Pred>
+        constexpr void erase_if(Pred &&pred) noexcept {
+            std::erase_if(*events_, std::forward<Pred>(pred));
+        }
+
+        /// Add `event` right before the frame's `SYN_REPORT` (at the end when it
+        /// has none); false when out of memory.
+        constexpr bool emit(event_type const &event) noexcept try {
+            if (ends_with_report()) {
+                events_->insert(events_->end() - 1, event);
+            } else {
+                events_->push_back(event);
+            }
+            return true;
+        } catch (...) {
+            return false;
+        }
+
+      private:
+        std::vector<event_type> *events_;
+    };
+
+    /// Mods opt into frame dispatch with `static constexpr bool handles_frames = true;`
+    /// and an `operator()` taking `(event_frame, frame_tag)` (optionally after
+    /// the context). They keep their per-event form too: it's what they get
+    /// outside of the top level of a running pipeline.
+    template <typename T>
+    concept FrameModifier = Modifier<T> && requires {
+        requires std::remove_cvref_t<T>::handles_frames;
+    };
+
     template <typename ModT, typename CtxT, typename... Args>
     concept invokable_mod =
       std::is_nothrow_invocable_v<ModT, CtxT &, Args...>
@@ -206,15 +300,56 @@ export namespace fs8 {
         requires std::remove_cvref_t<T>::is_tag;
     } && std::is_trivially_copy_constructible_v<std::remove_cvref_t<T>>;
 
+    /// The events a mod of type `T` dropped (returned `false` or `ignore_event`
+    /// for), for `metrics`.
+    template <typename T>
+    inline named_counter dropped_by{span_name<T>()};
+
+    /// Finds, with `ctx.mod<drop_reporter>()`, the mod that reports the drops:
+    /// one with `static constexpr bool reports_drops = true;` (`metrics`).
+    struct drop_reporter {
+        template <typename T>
+        static constexpr bool value = requires { requires std::remove_cvref_t<T>::reports_drops; };
+    };
+
+    /// The drops are counted only in the pipelines that report them; the rest
+    /// don't pay for a shared counter on every dropped event.
+    template <typename CtxT>
+    constexpr bool counts_drops = has_mod<drop_reporter, std::remove_cvref_t<CtxT>>;
+
+    /// Count the drop of an event; tags aren't events, and the wrappers that
+    /// expose `sub_mods` only pass on what their inner mods dropped.
     template <typename ModT, typename... Args>
+    constexpr void count_drop() noexcept {
+        if constexpr (!(Tag<Args> || ...) && !requires(ModT &mod) { mod.sub_mods(); }) {
+            if !consteval {
+                dropped_by<ModT>.count.add();
+            }
+        }
+    }
+
+    template <bool CountDrops, typename ModT, typename... Args>
     constexpr context_action invoke_mod_inorder(ModT &mod, context_action const default_action, Args &&...args) noexcept {
         using enum context_action;
         using result = std::invoke_result_t<ModT, Args...>;
         static_assert(std::is_nothrow_invocable_v<ModT, Args...>, "Mark the mod as nothrow.");
+        [[maybe_unused]] span_scope<std::remove_cvref_t<ModT>> const span{};
         if constexpr (std::same_as<result, bool>) {
-            return mod(std::forward<Args>(args)...) ? next : ignore_event;
+            if (mod(std::forward<Args>(args)...)) {
+                return next;
+            }
+            if constexpr (CountDrops) {
+                count_drop<std::remove_cvref_t<ModT>, std::remove_cvref_t<Args>...>();
+            }
+            return ignore_event;
         } else if constexpr (std::same_as<result, context_action>) {
-            return mod(std::forward<Args>(args)...);
+            auto const action = mod(std::forward<Args>(args)...);
+            if constexpr (CountDrops) {
+                if (action == ignore_event) [[unlikely]] {
+                    count_drop<std::remove_cvref_t<ModT>, std::remove_cvref_t<Args>...>();
+                }
+            }
+            return action;
         } else {
             static_cast<void>(mod(std::forward<Args>(args)...));
             return default_action;
@@ -225,12 +360,12 @@ export namespace fs8 {
     constexpr context_action invoke_mod(ModT &mod, CtxT &ctx, context_action const default_action, Args... args) noexcept {
         using enum context_action;
         if constexpr (std::invocable<ModT, CtxT &, Args...>) {
-            return invoke_mod_inorder(mod, default_action, ctx, args...);
+            return invoke_mod_inorder<counts_drops<CtxT>>(mod, default_action, ctx, args...);
         } else if constexpr (std::invocable<ModT, event_type &, Args...>) {
             auto &event = ctx.event();
-            return invoke_mod_inorder(mod, default_action, event, args...);
+            return invoke_mod_inorder<counts_drops<CtxT>>(mod, default_action, event, args...);
         } else if constexpr (std::invocable<ModT, Args...>) {
-            return invoke_mod_inorder(mod, default_action, args...);
+            return invoke_mod_inorder<counts_drops<CtxT>>(mod, default_action, args...);
         } else if constexpr (sizeof...(Args) >= 2) {
             // Some mods don't accept the tag-specific arguments (e.g. the device_query the router
             // pushes down a pipeline); drop the leading non-tag argument and retry with fewer args.
@@ -258,6 +393,7 @@ export namespace fs8 {
         using enum context_action;
         using result = std::invoke_result_t<CondT, Args...>;
         static_assert(std::is_nothrow_invocable_v<CondT, Args...>, "Mark the mod as nothrow.");
+        [[maybe_unused]] span_scope<std::remove_cvref_t<CondT>> const span{};
         if constexpr (std::same_as<result, bool>) {
             return cond(std::forward<Args>(args)...);
         } else if constexpr (std::same_as<result, context_action>) {
@@ -343,6 +479,12 @@ export namespace fs8 {
         using enum context_action;
         using tuple_type = std::tuple<Funcs...>;
         using mod_type   = std::tuple_element_t<Index, tuple_type>;
+        if constexpr (sizeof...(Args) == 0 && requires { ctx.template gather_frame<Index>(); }) {
+            // The frame mods of a running pipeline see their events a frame at a time.
+            if (ctx.dispatches_frames(funcs)) {
+                return ctx.template gather_frame<Index>();
+            }
+        }
         if constexpr (invokable_mod<mod_type, CtxT, Args...>) {
             basic_context_view<CtxT, Funcs...> view{ctx, funcs, Index + 1U};
             return invoke_mod(get<Index>(funcs), view, default_action, args...);
@@ -671,10 +813,110 @@ export namespace fs8 {
         using mod_type = mod_of<T, Funcs...>;
 
       private:
+        static constexpr std::size_t frame_mods_count = (0 + ... + (FrameModifier<Funcs> ? 1 : 0));
+
+        /// Where the frame of the mod at `Index` is held, among `frames`.
+        template <std::size_t Index>
+        static consteval std::size_t frame_slot() noexcept {
+            return []<std::size_t... I>(std::index_sequence<I...>) consteval noexcept {
+                return (0 + ... + (FrameModifier<std::tuple_element_t<I, mods_type>> ? 1 : 0));
+            }(std::make_index_sequence<Index>{});
+        }
+
         event_type                                              ev{};
         mods_type                                               mods_{};
         std::array<variable_pointer, variable_size_v<Funcs...>> variables = extract_variables(mods_);
 
+        /// The frame each top-level `FrameModifier` is being fed, while the run loop is on.
+        std::array<std::vector<event_type>, frame_mods_count> frames{};
+        bool                                                  dispatching_frames = false;
+
+        /// Run the held frame of the mod at `Index` through it, then hand what's
+        /// left of it to the rest of the pipeline, event by event.
+        template <std::size_t Index>
+        context_action run_frame() noexcept {
+            using enum context_action;
+            using view_type = basic_context_view<basic_context, std::remove_cvref_t<Funcs>...>;
+            using mod_type  = std::tuple_element_t<Index, mods_type>;
+            static_assert(invokable_mod<mod_type, view_type, event_frame, frame_tag>,
+                          "A mod with `handles_frames` needs an operator() that takes (event_frame, frame_tag).");
+
+            auto      &pending = frames[frame_slot<Index>()];
+            auto const cur     = ev;
+            ev                 = pending.back();
+            view_type view{*this, mods_, Index + 1U};
+            auto      action = invoke_mod(get<Index>(mods_), view, next, event_frame{pending}, frame_dispatch);
+            if (action == next) {
+                // Indexed: a downstream mod re-emitting to here may grow `pending`.
+                for (std::size_t i = 0; i < pending.size(); ++i) {
+                    ev     = pending[i];
+                    action = invoke_mods_from(*this, mods_, Index + 1U);
+                    if (is_exiting(action)) [[unlikely]] {
+                        break;
+                    }
+                }
+            }
+            pending.clear();
+            ev = cur;
+            // Whatever got here has already gone all the way down.
+            return is_exiting(action) ? action : ignore_event;
+        }
+
+        template <std::size_t Index>
+        [[nodiscard]] bool flush_frame(context_action &action) noexcept {
+            if constexpr (FrameModifier<std::tuple_element_t<Index, mods_type>>) {
+                if (!frames[frame_slot<Index>()].empty()) {
+                    if (auto const res = run_frame<Index>(); is_exiting(res)) [[unlikely]] {
+                        action = res;
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /// Push the incomplete frames through, upstream first, so nothing waits
+        /// on a `SYN_REPORT` while the pipeline blocks for new events.
+        context_action flush_frames() noexcept {
+            using enum context_action;
+            return [&]<std::size_t... I>(std::index_sequence<I...>) constexpr noexcept {
+                auto action = next;
+                std::ignore = (flush_frame<I>(action) && ...);
+                return action;
+            }(std::make_index_sequence<sizeof...(Funcs)>{});
+        }
+
+        /// Send out whatever is still held back when the run loop exits: the
+        /// partial frames first, then the outputs' buffers.
+        void flush_pending() noexcept {
+            using ctx_view = basic_context_view<basic_context, std::remove_cvref_t<Funcs>...>;
+            if constexpr (frame_mods_count > 0) {
+                std::ignore = flush_frames();
+            }
+            if constexpr ((invokable_mod<Funcs, ctx_view, flush_tag> || ...)) {
+                std::ignore = invoke_mods(*this, mods_, flush_output);
+            }
+        }
+
+        /// Frame dispatch is only on for the duration of the run loop.
+        struct [[nodiscard]] frame_scope {
+            basic_context &ctx;
+
+            explicit frame_scope(basic_context &inp_ctx) noexcept : ctx{inp_ctx} {
+                ctx.dispatching_frames = frame_mods_count > 0;
+            }
+
+            frame_scope(frame_scope const &)            = delete;
+            frame_scope &operator=(frame_scope const &) = delete;
+
+            ~frame_scope() noexcept {
+                ctx.dispatching_frames = false;
+                for (auto &pending : ctx.frames) {
+                    pending.clear();
+                }
+            }
+        };
+
       public:
         consteval explicit basic_context(event_type const &inp_ev, std::remove_cvref_t<Funcs>... inp_funcs) noexcept
           : ev{inp_ev},
@@ -694,6 +936,33 @@ export namespace fs8 {
             ev = inp_event;
         }
 
+        /// `fork_mod` hook: whether `funcs` are this pipeline's own mods, and the
+        /// run loop is feeding its frame mods whole frames.
+        template <typename T>
+        [[nodiscard]] constexpr bool dispatches_frames(T const &funcs) const noexcept {
+            if constexpr (std::same_as<T, mods_type>) {
+                return dispatching_frames && &funcs == &mods_;
+            } else {
+                return false;
+            }
+        }
+
+        /// `fork_mod` hook: add the current event to the frame of the mod at
+        /// `Index`, and run that frame once its `SYN_REPORT` is in.
+        template <std::size_t Index>
+            requires FrameModifier<std::tuple_element_t<Index, mods_type>>
+        context_action gather_frame() noexcept try {
+            using enum context_action;
+            frames[frame_slot<Index>()].push_back(ev);
+            if (!is_syn_report(ev)) {
+                return ignore_event; // held until the frame is complete
+            }
+            return run_frame<Index>();
+        } catch (...) {
+            // We don't know how to handle this.
+            return context_action::exit;
+        }
+
         template <typename Func, typename Self>
             requires((std::same_as<mod_type<Func>, Funcs> || ...))
         [[nodiscard]] constexpr auto &mod(this Self &&self) noexcept {
@@ -785,6 +1054,10 @@ export namespace fs8 {
         context_action operator()(start_tag) noexcept try {
             // Make the dynamic context point at this pipeline for the whole start phase.
             dynamic_scope scope{dynamic_context, *this};
+            // A restart drops the frames that were half-way through.
+            for (auto &pending : frames) {
+                pending.clear();
+            }
             // invoke the mods
             return invoke_mods(*this, mods_, start);
         } catch (...) {
@@ -824,15 +1097,19 @@ export namespace fs8 {
             // so mods reached from event callbacks (e.g. input_manager hotplug) can
             // introspect the active pipeline.
             dynamic_scope scope{dynamic_context, *this};
+            frame_scope   frames_on{*this};
             using enum context_action;
             using ctx_view = basic_context_view<basic_context<std::remove_cvref_t<Funcs>...>, std::remove_cvref_t<Funcs>...>;
             static_assert(((invokable_mod<Funcs, ctx_view>
                             || invokable_mod<Funcs, ctx_view, load_event_tag>
-                            || invokable_mod<Funcs, ctx_view, next_event_tag>)
+                            || invokable_mod<Funcs, ctx_view, next_event_tag>
+                            || FrameModifier<Funcs>)
                            && ...),
                           "At least one of the mods are not callable");
             static constexpr auto load_event_count = (0 + ... + (invokable_mod<Funcs, ctx_view, load_event_tag> ? 1 : 0));
             static constexpr auto next_event_count = (0 + ... + (invokable_mod<Funcs, ctx_view, next_event_tag> ? 1 : 0));
+            static constexpr auto flush_count      = (0 + ... + (invokable_mod<Funcs, ctx_view, flush_tag> ? 1 : 0));
+            static constexpr auto timer_count      = (0 + ... + (invokable_mod<Funcs, ctx_view, timer_tag> ? 1 : 0));
             static_assert(load_event_count <= 1, "There should only be one single load_event in the mods");
             static_assert(load_event_count + next_event_count >= 1, "Someone needs to provide the events.");
             for (;;) {
@@ -853,14 +1130,32 @@ export namespace fs8 {
                             }
                             break;
                         [[unlikely]] case exit:
+                            flush_pending();
                             return;
                     }
+                    // Don't keep a partial frame waiting for its SYN_REPORT while blocking.
+                    if constexpr (frame_mods_count > 0) {
+                        if (!restart_if(flush_frames())) [[unlikely]] {
+                            flush_pending();
+                            return;
+                        }
+                    }
+                    // Nor the events the outputs are holding back.
+                    if constexpr (flush_count > 0) {
+                        std::ignore = invoke_mods(*this, mods_, flush_output);
+                    }
                     // next_event exhausted -> block in load_event (pure wait; it does
                     // NOT load an event). After it wakes, loop back to next_event.
                     if constexpr (load_event_count > 0) {
                         switch (invoke_mods(*this, mods_, load_event)) {
                             [[likely]] case next:
                             case ignore_event:
+                                // Maybe it was a timer that woke us up.
+                                if constexpr (timer_count > 0) {
+                                    if (!restart_if(invoke_mods(*this, mods_, timer_expired))) [[unlikely]] {
+                                        return;
+                                    }
+                                }
                                 continue; // key change (was `break` -> trailing invoke_mods)
                             [[unlikely]] default:
                             [[unlikely]] case idle:
@@ -869,6 +1164,7 @@ export namespace fs8 {
                                 }
                                 break;
                             [[unlikely]] case exit:
+                                flush_pending();
                                 return;
                         }
                     }
@@ -890,6 +1186,8 @@ export namespace fs8 {
                             }
                             break;
                         [[unlikely]] case exit:
+                            // The events after the last SYN_REPORT still go out.
+                            flush_pending();
                             return;
                     }
                     if (!restart_if(invoke_mods(*this, mods_))) [[unlikely]] {
@@ -909,6 +1207,16 @@ export namespace fs8 {
             return invoke_mods(ctx, mods_, start);
         }
 
+        /// Pass-through a flush to the mods.
+        context_action operator()(Context auto &ctx, flush_tag) noexcept {
+            return invoke_mods(ctx, mods_, flush_output);
+        }
+
+        /// Pass-through the timers to the mods.
+        context_action operator()(Context auto &ctx, timer_tag) noexcept {
+            return invoke_mods(ctx, mods_, timer_expired);
+        }
+
         /// Pass-through with extra arguments (e.g. a device_query pushed by the router on start).
         /// The trailing argument is expected to be a tag.
         template <typename... Args>
@@ -1061,6 +1369,8 @@ export namespace fs8 {
             case dynamic_tag::next_event: return fork_mod<Index>(ctx, ctx.get_mods(), default_action, next_event);
             case dynamic_tag::toggle_on: return fork_mod<Index>(ctx, ctx.get_mods(), default_action, toggle_on);
             case dynamic_tag::toggle_off: return fork_mod<Index>(ctx, ctx.get_mods(), default_action, toggle_off);
+            case dynamic_tag::flush: return fork_mod<Index>(ctx, ctx.get_mods(), default_action, flush_output);
+            case dynamic_tag::timer: return fork_mod<Index>(ctx, ctx.get_mods(), default_action, timer_expired);
             default: return fork_mod<Index>(ctx, ctx.get_mods(), default_action);
         }
     }
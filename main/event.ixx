@@ -398,4 +398,9 @@ export namespace fs8 {
     [[nodiscard]] constexpr bool is_syn(user_event const& event) noexcept {
         return event.type == EV_SYN;
     }
+
+    /// The end of a frame (`EV_SYN`/`SYN_REPORT`); unlike `is_syn`, not the other `EV_SYN` codes.
+    [[nodiscard]] constexpr bool is_syn_report(event_type const& event) noexcept {
+        return event.type() == EV_SYN && event.code() == SYN_REPORT;
+    }
 } // namespace fs8
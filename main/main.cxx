@@ -418,19 +418,13 @@ Options:
         // Reuse the same search engine the `typed` mod uses, so patterns behave
         // identically to library pipelines: `<...>`/`[...]`/`<<...>>`/`[[...]]`
         // and plain text.
-        fs8::basic_search_engine    engine;
-        std::vector<std::uint16_t>  trigger_ids;
-        std::vector<fs8::aho_state> states;
+        fs8::basic_search_engine   engine;
+        std::vector<std::uint16_t> trigger_ids;
         trigger_ids.reserve(patterns.size());
-        states.reserve(patterns.size());
         for (auto const& pattern : patterns) {
             trigger_ids.emplace_back(engine.emplace_pattern(pattern));
-            states.emplace_back(fs8::aho_state{0u});
         }
 
-        fs8::xkb::basic_state keyboard_state;
-        keyboard_state.initialize(fs8::xkb::get_default_keymap());
-
         bool        matched_any = false;
         std::string line;
         while (std::getline(std::cin, line)) {
@@ -439,8 +433,9 @@ Options:
                 continue;
             }
             fs8::event_type const event{parsed.event};
+            engine.scan(event); // once for all the patterns
             for (std::size_t index = 0; index < trigger_ids.size(); ++index) {
-                if (engine.search(event, trigger_ids[index], keyboard_state, states[index])) {
+                if (engine.matched(trigger_ids[index])) {
                     if (echo_events) {
                         println("{}", line);
                     }
@@ -467,7 +462,12 @@ Options:
             }
             case intercept: {
                 static constinit auto pipeline =
-                  fs8::context | fs8::io_manager | fs8::intercept | fs8::input_manager | fs8::stopper | fs8::output;
+                  fs8::context
+                  | fs8::io_manager
+                  | fs8::intercept
+                  | fs8::input_manager
+                  | fs8::stopper
+                  | fs8::output[fs8::io_buffering::batched][fs8::io_transport::shared_memory];
 
                 auto& sig_stopper = pipeline.mod(fs8::stopper);
                 auto& inpor       = pipeline.mod(fs8::intercept);
@@ -485,7 +485,11 @@ Options:
                     throw std::invalid_argument("Only pass one query for redirect.");
                 }
 
-                static constinit auto pipeline = fs8::context | fs8::stopper | fs8::from_input | fs8::uinput;
+                static constinit auto pipeline =
+                  fs8::context
+                  | fs8::stopper
+                  | fs8::from_input[fs8::io_buffering::batched][fs8::io_transport::shared_memory]
+                  | fs8::uinput;
 
                 auto& out         = pipeline.mod(fs8::uinput);
                 auto& sig_stopper = pipeline.mod(fs8::stopper);
@@ -96,6 +96,7 @@ export namespace fs8 {
     constexpr struct [[nodiscard]] basic_abs2rel : consteval_copyable {
         using consteval_copyable::consteval_copyable;
 
+        static constexpr bool handles_frames = true;
 
         using code_type  = event_type::code_type;
         using value_type = event_type::value_type;
@@ -183,6 +184,17 @@ export namespace fs8 {
             return operator()(ctx.event());
         }
 
+        /// Frame form: converts the frame in place and drops the events the
+        /// per-event form would have ignored.
+        template <Context CtxT>
+        context_action operator()(CtxT&, event_frame frame, frame_tag) noexcept {
+            static_assert(has_mod<basic_ignore_adjacent_repeats, CtxT>, "You need to ignore syn repeats.");
+            frame.erase_if([this](event_type& event) noexcept {
+                return this->operator()(event) == context_action::ignore_event;
+            });
+            return frame.empty() ? context_action::ignore_event : context_action::next;
+        }
+
     } abs2rel;
 
 } // namespace fs8
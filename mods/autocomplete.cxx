@@ -1,12 +1,15 @@
 // Created by moisrex on 8/16/26.
 
 module;
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <linux/input-event-codes.h>
 #include <string>
 #include <string_view>
+#include <vector>
 module fs8.mods;
+import fs8.lib.dictionary;
 import fs8.lib.mod_parser;
 import fs8.log;
 
@@ -53,14 +56,78 @@ struct fs8::pimpl_idiom<fs8::basic_autocomplete>::impl {
     std::string           completion; // raw COMPLETION of the pattern (tags intact)
     event_type::code_type trigger_code = KEY_MAX;
     bool                  valid        = false;
+
+    dictionary         words; // with `from(path)`
+    dictionary::cursor cursor;
+
+    /// Follow the word being typed in the dictionary.
+    context_action on_word(key_event key, code32_t code, bool pass_trigger, std::function_ref<void(std::string_view)> inp_emit);
 };
 
+fs8::context_action fs8::pimpl_idiom<fs8::basic_autocomplete>::impl::on_word(
+  key_event const                                 key,
+  code32_t const                                  code,
+  bool const                                      pass_trigger,
+  std::function_ref<void(std::string_view)> const inp_emit) {
+    using enum context_action;
+    if (key.code == KEY_BACKSPACE) {
+        words.pop(cursor);
+        return next;
+    }
+
+    // type the rest of the best word that's longer than what's typed, and
+    // carry on from the end of it; a complete word lets the trigger through
+    if (key.code == trigger_code) {
+        auto const completions = words.completions(cursor);
+        auto const best        = std::ranges::find_if(completions, [this](dictionary::entry_id const id) noexcept {
+            return words.word(id).size() > cursor.typed.size();
+        });
+        if (best != completions.end()) {
+            auto const rest = words.word(*best).substr(cursor.typed.size());
+            inp_emit(rest);
+            for (auto const completed : to_u32(rest)) {
+                words.push(cursor, completed);
+            }
+            return pass_trigger ? next : ignore_event;
+        }
+    }
+
+    if (is_modifier_key(key.code)) {
+        return next;
+    }
+
+    // a space may go on with a phrase; the dictionary starts a new word if it doesn't
+    if (code != U' ' && is_reset_code(code)) {
+        dictionary::reset(cursor);
+        return next;
+    }
+    words.push(cursor, code);
+    return next;
+}
+
 fs8::context_action fs8::basic_autocomplete::on_start() noexcept try {
     if (pimpl.get() == nullptr) [[unlikely]] {
         init_impl();
     }
     pimpl->valid = false;
 
+    // the dictionary is loaded once; a restart only starts a new word
+    if (!path.empty()) {
+        dictionary::reset(pimpl->cursor);
+        if (!pimpl->words.is_open()) {
+            if (!pimpl->words.open(path, top_k)) {
+                log("autocomplete: can't load the dictionary '{}'.", path);
+                return context_action::next;
+            }
+            log("autocomplete: {} words loaded from '{}'.", pimpl->words.size(), path);
+        }
+        if (pattern.empty()) {
+            pimpl->trigger_code = KEY_TAB;
+            pimpl->valid        = true;
+            return context_action::next;
+        }
+    }
+
     // the first modifier tag in the pattern is the trigger/separator
     std::size_t begin = 0;
     std::size_t end   = 0;
@@ -120,6 +187,15 @@ fs8::context_action fs8::basic_autocomplete::on_event(event_type const&
         return next; // only track keydowns
     }
 
+    if (!path.empty()) {
+        try {
+            return pimpl->on_word(key, code, pass_trigger, inp_emit);
+        } catch (...) {
+            dictionary::reset(pimpl->cursor);
+            return next;
+        }
+    }
+
     if (key.code == KEY_BACKSPACE) {
         if (!pimpl->buffer.empty()) {
             pimpl->buffer.pop_back();
@@ -157,3 +233,14 @@ fs8::context_action fs8::basic_autocomplete::on_event(event_type const&
     }
     return next;
 }
+
+std::vector<std::string_view> fs8::basic_autocomplete::completions() const {
+    std::vector<std::string_view> result;
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return result;
+    }
+    for (auto const id : pimpl->words.completions(pimpl->cursor)) {
+        result.push_back(pimpl->words.word(id));
+    }
+    return result;
+}
@@ -1,11 +1,14 @@
 // Created by moisrex on 8/16/26.
 
 module;
+#include <cstddef>
 #include <functional>
 #include <string_view>
+#include <vector>
 export module fs8.mods:autocomplete;
 import fs8.context;
 import fs8.event;
+import fs8.lib.dictionary;
 import fs8.lib.xkb;
 import fs8.lib.mod_parser;
 import :typer;
@@ -34,6 +37,14 @@ namespace fs8 {
      * `auto_mode`) the tag is only a separator and the completion is emitted as
      * soon as PREFIX is fully typed.
      *
+     * With a dictionary (`autocomplete.from(path)`, see `dictionary` for the
+     * file) it completes any of its words instead: the trigger (Tab, or the
+     * tag of the pattern, e.g. `autocomplete["<right>"].from(path)`) types the
+     * rest of the most frequent word that starts with the one being typed.
+     * Every keystroke is a step in the dictionary's trie, and the best `top`
+     * completions of each node are worked out when it's loaded, so completing
+     * doesn't get slower with the size of the list. Auto mode doesn't apply.
+     *
      * The current word being typed is tracked through `unicode_encoded_event`
      * over an internal xkb state, so no `search_engine` is required in the pipeline.
      */
@@ -42,6 +53,8 @@ namespace fs8 {
 
       private:
         std::string_view pattern;        // pattern string
+        std::string_view path;           // the dictionary, if any
+        std::size_t      top_k = dictionary::default_top;
         xkb::basic_state keyboard_state; // the state of the modifier keys and what not
         bool             auto_mode    = false;
         bool             pass_trigger = false;
@@ -57,27 +70,46 @@ namespace fs8 {
 
         /// Return a new autocomplete that matches the specified pattern.
         consteval basic_autocomplete operator[](std::string_view const inp_pattern) const noexcept {
-            return basic_autocomplete{inp_pattern};
+            auto new_mod    = *this;
+            new_mod.pattern = inp_pattern;
+            return new_mod;
         }
 
         consteval basic_autocomplete operator()(std::string_view const inp_pattern) const noexcept {
-            return basic_autocomplete{inp_pattern};
+            return (*this)[inp_pattern];
         }
 
         /// Emit the completion automatically once the prefix is fully typed.
         consteval basic_autocomplete operator[](basic_auto_mode_tag) const noexcept {
-            auto new_mod      = basic_autocomplete{pattern};
+            auto new_mod      = *this;
             new_mod.auto_mode = true;
             return new_mod;
         }
 
         /// Don't swallow the trigger keypress when a completion fires.
         consteval basic_autocomplete operator[](basic_pass_trigger_tag) const noexcept {
-            auto new_mod         = basic_autocomplete{pattern};
+            auto new_mod         = *this;
             new_mod.pass_trigger = true;
             return new_mod;
         }
 
+        /// Complete the words of a dictionary file, loaded at the start.
+        consteval basic_autocomplete from(std::string_view const inp_path) const noexcept {
+            auto new_mod = *this;
+            new_mod.path = inp_path;
+            return new_mod;
+        }
+
+        /// How many completions the dictionary keeps for each prefix.
+        consteval basic_autocomplete top(std::size_t const inp_top) const noexcept {
+            auto new_mod  = *this;
+            new_mod.top_k = inp_top;
+            return new_mod;
+        }
+
+        /// The best completions of the word being typed, the best first; only with a dictionary.
+        [[nodiscard]] std::vector<std::string_view> completions() const;
+
         /// Initialize the keyboard state and parse the pattern.
         context_action operator()([[maybe_unused]] Context auto& ctx, start_tag) noexcept {
             keyboard_state.initialize(xkb::get_default_keymap());
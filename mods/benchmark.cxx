@@ -1,7 +1,11 @@
 // Created by moisrex on 8/22/26.
 
 module;
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 module fs8.mods;
 import fs8.pimpl;
 
@@ -10,22 +14,38 @@ using fs8::benchmark_stats;
 
 template <>
 struct fs8::pimpl_idiom<basic_benchmark_counter>::impl {
+    static constexpr auto slices_count = basic_benchmark_counter::window_slices;
+
     benchmark_stats stats;
+
+    /// The window, a quarter per slot; `slice_ids` tells which quarter of
+    /// time a slot holds, so the stale ones are skipped and reused.
+    std::array<benchmark_stats, slices_count> slices{};
+    std::array<std::int64_t, slices_count>    slice_ids{};
+
+    [[nodiscard]] static std::int64_t slice_of(basic_benchmark_counter::clock::time_point const at,
+                                               benchmark_stats::duration const                 window) noexcept {
+        auto const slice_length = window / static_cast<std::int64_t>(slices_count);
+        auto const since_epoch  = std::chrono::duration_cast<benchmark_stats::duration>(at.time_since_epoch());
+        // Anything before the clock's epoch (it's the boot for a steady clock)
+        // is as old as it gets; +1: a zero id marks a slot that was never used.
+        return std::max<std::int64_t>(since_epoch / slice_length, 0) + 1;
+    }
 };
 
-void basic_benchmark_counter::record(benchmark_stats::duration const elapsed) noexcept {
+void basic_benchmark_counter::record(benchmark_stats::duration const elapsed, clock::time_point const at) noexcept {
     if (pimpl.get() == nullptr) {
         init_impl();
     }
-    auto& stats = pimpl->stats;
-    ++stats.calls;
-    stats.total += elapsed;
-    if (elapsed < stats.min) {
-        stats.min = elapsed;
-    }
-    if (elapsed > stats.max) {
-        stats.max = elapsed;
+    pimpl->stats.record(elapsed);
+
+    auto const id   = impl::slice_of(at, window_length);
+    auto const slot = static_cast<std::size_t>(id % static_cast<std::int64_t>(impl::slices_count));
+    if (pimpl->slice_ids[slot] != id) {
+        pimpl->slice_ids[slot] = id;
+        pimpl->slices[slot]    = {};
     }
+    pimpl->slices[slot].record(elapsed);
 }
 
 benchmark_stats basic_benchmark_counter::result() const noexcept {
@@ -35,8 +55,24 @@ benchmark_stats basic_benchmark_counter::result() const noexcept {
     return pimpl->stats;
 }
 
+benchmark_stats basic_benchmark_counter::window_result() const noexcept {
+    benchmark_stats res{};
+    if (pimpl.get() == nullptr) {
+        return res;
+    }
+    auto const now = impl::slice_of(clock::now(), window_length);
+    for (std::size_t slot = 0; slot < impl::slices_count; ++slot) {
+        if (auto const id = pimpl->slice_ids[slot]; id != 0 && id > now - static_cast<std::int64_t>(impl::slices_count)) {
+            res.merge(pimpl->slices[slot]);
+        }
+    }
+    return res;
+}
+
 void basic_benchmark_counter::clear() noexcept {
     if (pimpl.get() != nullptr) {
-        pimpl->stats = {};
+        pimpl->stats     = {};
+        pimpl->slices    = {};
+        pimpl->slice_ids = {};
     }
 }
@@ -1,7 +1,12 @@
 // Created by moisrex on 8/22/26.
 
 module;
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <tuple>
@@ -13,25 +18,144 @@ import fs8.traits;
 
 namespace fs8 {
 
+    /**
+     * Log-bucketed latency histogram, HDR-style: exact below 64ns, then 32
+     * buckets per power of two, so any value is known to within ~3%. Up to
+     * 2^48ns (~78h); longer ones land in the last bucket. The buckets are a
+     * fixed array, so recording never allocates.
+     */
+    export struct [[nodiscard]] latency_histogram {
+        using duration = std::chrono::nanoseconds;
+
+        static constexpr std::size_t   sub_bits     = 5;
+        static constexpr std::uint64_t sub_count    = std::uint64_t{1} << sub_bits;
+        static constexpr std::size_t   max_bits     = 48;
+        static constexpr std::size_t   bucket_count = (2 * sub_count) + ((max_bits - sub_bits - 1) * sub_count);
+
+      private:
+        std::array<std::uint64_t, bucket_count> counts{};
+        std::uint64_t                           total_count = 0;
+
+        [[nodiscard]] static constexpr std::size_t index_of(std::uint64_t const value) noexcept {
+            if (value < 2 * sub_count) {
+                return static_cast<std::size_t>(value);
+            }
+            auto const top   = static_cast<std::size_t>(std::bit_width(value)) - 1;
+            auto const shift = std::min(top, max_bits - 1) - sub_bits;
+            auto const sub   = std::min(value >> shift, (2 * sub_count) - 1) - sub_count;
+            return static_cast<std::size_t>((2 * sub_count) + ((shift - 1) * sub_count) + sub);
+        }
+
+        /// The highest value that lands in bucket `index`.
+        [[nodiscard]] static constexpr std::uint64_t highest_of(std::size_t const index) noexcept {
+            if (index < 2 * sub_count) {
+                return index;
+            }
+            auto const rest  = index - (2 * sub_count);
+            auto const shift = (rest / sub_count) + 1;
+            auto const sub   = (rest % sub_count) + sub_count;
+            return ((sub + 1) << shift) - 1;
+        }
+
+      public:
+        constexpr void record(duration const elapsed) noexcept {
+            ++counts[index_of(static_cast<std::uint64_t>(std::max<std::int64_t>(elapsed.count(), 0)))];
+            ++total_count;
+        }
+
+        constexpr void merge(latency_histogram const& other) noexcept {
+            for (std::size_t index = 0; index < bucket_count; ++index) {
+                counts[index] += other.counts[index];
+            }
+            total_count += other.total_count;
+        }
+
+        [[nodiscard]] constexpr std::uint64_t count() const noexcept {
+            return total_count;
+        }
+
+        /// The value `percent`% of the recordings are at or below, e.g. 99.9;
+        /// rounded up to the top of its bucket.
+        [[nodiscard]] constexpr duration percentile(double const percent) const noexcept {
+            if (total_count == 0) {
+                return {};
+            }
+            // The epsilon keeps e.g. 99.9% of 1000 at rank 999: in double, it's a hair over.
+            auto const rank   = std::clamp(percent, 0.0, 100.0) / 100.0 * static_cast<double>(total_count);
+            auto const wanted = std::clamp<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(rank - 1e-6)), 1, total_count);
+            std::uint64_t seen = 0;
+            for (std::size_t index = 0; index < bucket_count; ++index) {
+                seen += counts[index];
+                if (seen >= wanted) {
+                    return duration{static_cast<std::int64_t>(highest_of(index))};
+                }
+            }
+            return duration{static_cast<std::int64_t>(highest_of(bucket_count - 1))};
+        }
+    };
+
     export struct [[nodiscard]] benchmark_stats {
         using duration = std::chrono::nanoseconds;
 
-        std::uint64_t calls = 0;
-        duration      total{};
-        duration      min{duration::max()};
-        duration      max{};
+        std::uint64_t     calls = 0;
+        duration          total{};
+        duration          min{duration::max()};
+        duration          max{};
+        latency_histogram histogram{};
 
         [[nodiscard]] constexpr duration average() const noexcept {
             return calls == 0 ? duration{} : total / static_cast<std::int64_t>(calls);
         }
+
+        /// The latency `percent`% of the calls stayed within, e.g. `percentile(99)`.
+        [[nodiscard]] constexpr duration percentile(double const percent) const noexcept {
+            return calls == 0 ? duration{} : std::min(histogram.percentile(percent), max);
+        }
+
+        constexpr void record(duration const elapsed) noexcept {
+            ++calls;
+            total += elapsed;
+            min    = std::min(min, elapsed);
+            max    = std::max(max, elapsed);
+            histogram.record(elapsed);
+        }
+
+        constexpr void merge(benchmark_stats const& other) noexcept {
+            calls += other.calls;
+            total += other.total;
+            min    = std::min(min, other.min);
+            max    = std::max(max, other.max);
+            histogram.merge(other.histogram);
+        }
     };
 
+    /**
+     * Times the calls it's told about: lifetime totals, and the same stats over
+     * a sliding window of the last `window()` (default 10s), kept in quarters
+     * of it, so the window actually covers between 3/4 and all of that time.
+     */
     export struct [[nodiscard]] basic_benchmark_counter : pimpl_idiom<basic_benchmark_counter> {
         using pimpl_idiom::pimpl_idiom;
+        using clock = std::chrono::steady_clock;
+
+        static constexpr std::size_t          window_slices = 4;
+        static constexpr std::chrono::seconds default_window{10};
 
-        void                          record(benchmark_stats::duration elapsed) noexcept;
+        void                          record(benchmark_stats::duration elapsed, clock::time_point at) noexcept;
         [[nodiscard]] benchmark_stats result() const noexcept;
+        [[nodiscard]] benchmark_stats window_result() const noexcept;
         void                          clear() noexcept;
+
+        constexpr void window(benchmark_stats::duration const inp_window) noexcept {
+            window_length = std::max(inp_window, benchmark_stats::duration{window_slices});
+        }
+
+        [[nodiscard]] constexpr benchmark_stats::duration window() const noexcept {
+            return window_length;
+        }
+
+      private:
+        benchmark_stats::duration window_length = default_window;
     };
 
     export template <Modifier... Funcs>
@@ -47,11 +171,20 @@ namespace fs8 {
       public:
         explicit constexpr basic_benchmark(std::remove_cvref_t<Funcs>... inp_funcs) noexcept : funcs{inp_funcs...} {}
 
+        /// benchmark[context | ...].window(5s): the span of `window_result()`.
+        template <typename DurT>
+        consteval basic_benchmark window(DurT const& dur) const noexcept {
+            auto result{*this};
+            result.counter.window(std::chrono::duration_cast<benchmark_stats::duration>(dur));
+            return result;
+        }
+
         template <Context CtxT>
         context_action operator()(CtxT& ctx) noexcept {
             auto const started = clock::now();
             auto const action  = invoke_mods(ctx, funcs);
-            counter.record(std::chrono::duration_cast<benchmark_stats::duration>(clock::now() - started));
+            auto const ended   = clock::now();
+            counter.record(std::chrono::duration_cast<benchmark_stats::duration>(ended - started), ended);
             return action;
         }
 
@@ -77,6 +210,15 @@ namespace fs8 {
             return counter.result();
         }
 
+        /// The stats of the last `window`.
+        [[nodiscard]] benchmark_stats window_result() const noexcept {
+            return counter.window_result();
+        }
+
+        [[nodiscard]] benchmark_stats::duration window() const noexcept {
+            return counter.window();
+        }
+
         void clear() noexcept {
             counter.clear();
         }
@@ -97,7 +239,7 @@ namespace fs8 {
         template <typename ModT, typename FnT>
         void for_each_benchmark(ModT& mod, FnT& fn) noexcept {
             if constexpr (requires { mod.result(); }) {
-                fn(mod.result());
+                fn(mod);
             }
             if constexpr (requires { mod.sub_mods(); }) {
                 std::apply(
@@ -120,13 +262,28 @@ namespace fs8 {
         explicit constexpr basic_benchmark_result(SinkT inp_sink) noexcept : sink{std::move(inp_sink)} {}
 
         void operator()(Context auto& ctx) noexcept {
-            auto emit = [&](benchmark_stats const& stats) noexcept {
-                sink("benchmark: calls={} total={}ns average={}ns min={}ns max={}ns",
+            auto emit = [&](auto const& bench) noexcept {
+                auto const stats = bench.result();
+                sink("benchmark: calls={} total={}ns average={}ns min={}ns max={}ns p50={}ns p90={}ns p99={}ns p99.9={}ns",
                      stats.calls,
                      stats.total.count(),
                      stats.average().count(),
                      stats.calls == 0 ? 0 : stats.min.count(),
-                     stats.max.count());
+                     stats.max.count(),
+                     stats.percentile(50).count(),
+                     stats.percentile(90).count(),
+                     stats.percentile(99).count(),
+                     stats.percentile(99.9).count());
+                auto const recent = bench.window_result();
+                sink("benchmark window: calls={} average={}ns max={}ns p50={}ns p90={}ns p99={}ns p99.9={}ns over the last {}s",
+                     recent.calls,
+                     recent.average().count(),
+                     recent.max.count(),
+                     recent.percentile(50).count(),
+                     recent.percentile(90).count(),
+                     recent.percentile(99).count(),
+                     recent.percentile(99.9).count(),
+                     std::chrono::duration<double>(bench.window()).count());
             };
             std::apply(
               [&](auto&... mod) noexcept {
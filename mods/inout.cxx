@@ -1,42 +1,548 @@
 // Created by moisrex on 8/17/26.
 
 module;
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <linux/uinput.h>
+#include <poll.h>
+#include <span>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
 #include <unistd.h>
 module fs8.mods;
 import fs8.event;
 import fs8.context;
+import fs8.nullable_indirect;
+import fs8.shm_ring;
 
 using fs8::context_action;
 using fs8::event_type;
 
-bool fs8::basic_output::emit(event_type const& event) const noexcept {
-    return write(file_descriptor, &event.native(), sizeof(input_event)) == sizeof(input_event);
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    /// Events the shared ring holds; the writer waits for the reader when it's full.
+    constexpr std::size_t ring_capacity = 4096;
+
+    /// How long the two ends look for each other, counted from the first write
+    /// (the writer) or the first read (the reader).
+    constexpr auto negotiation_window = std::chrono::seconds{2};
+    constexpr auto probe_interval     = std::chrono::milliseconds{100};
+
+    constexpr std::uint32_t offer_magic   = 0x66'73'38'6F; // "fs8o"
+    constexpr std::uint32_t offer_version = 2;
+    constexpr char          accepted      = 'y';
+    constexpr char          refused       = 'n';
+
+    /// What the writer sends over the socket, along with the memfd and the two
+    /// eventfds: the reader's doorbell, and the one that tells the writer there's room.
+    struct ring_offer {
+        std::uint32_t magic   = offer_magic;
+        std::uint32_t version = offer_version;
+    };
+
+    // The record the writer puts in the pipe right before it switches over to
+    // the ring; it's only ever sent to a reader that accepted the ring.
+    constexpr std::uint16_t marker_type  = EV_MAX;
+    constexpr std::uint16_t marker_code  = 0x0F58;
+    constexpr std::int32_t  marker_value = 0x66'73'38'72;
+
+    [[nodiscard]] input_event switch_marker() noexcept {
+        input_event marker{};
+        marker.type  = marker_type;
+        marker.code  = marker_code;
+        marker.value = marker_value;
+        return marker;
+    }
+
+    [[nodiscard]] bool is_switch_marker(input_event const& event) noexcept {
+        return event.type == marker_type && event.code == marker_code && event.value == marker_value;
+    }
+
+    /// Write all of `size` bytes, unless the fd fails.
+    bool write_all(int const file_descriptor, void const* const data, std::size_t size) noexcept {
+        auto const* cur = static_cast<char const*>(data);
+        while (size > 0) {
+            auto const written = ::write(file_descriptor, cur, size);
+            if (written < 0) [[unlikely]] {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            cur  += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    /// The abstract socket the reader of this pipe listens on; false when it's not a pipe.
+    [[nodiscard]] bool ring_address(int const pipe_fd, sockaddr_un& addr, socklen_t& addr_len) noexcept {
+        struct stat info{};
+        if (::fstat(pipe_fd, &info) != 0 || !S_ISFIFO(info.st_mode)) {
+            return false;
+        }
+        addr            = {};
+        addr.sun_family = AF_UNIX;
+        // sun_path[0] stays '\0': abstract, so nothing is left on the disk.
+        auto const len = std::snprintf(
+          addr.sun_path + 1,
+          sizeof(addr.sun_path) - 1,
+          "fs8-ring-%llx-%llx",
+          static_cast<unsigned long long>(info.st_dev),
+          static_cast<unsigned long long>(info.st_ino));
+        if (len <= 0) [[unlikely]] {
+            return false;
+        }
+        addr_len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + static_cast<std::size_t>(len));
+        return true;
+    }
+
+    void close_fd(int& file_descriptor) noexcept {
+        if (file_descriptor >= 0) {
+            ::close(file_descriptor);
+            file_descriptor = -1;
+        }
+    }
+
+    [[nodiscard]] bool send_offer(int const sock, int const memfd, int const doorbell, int const room) noexcept {
+        ring_offer offer{};
+        iovec      iov{.iov_base = &offer, .iov_len = sizeof(offer)};
+
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(3 * sizeof(int))> control{};
+
+        msghdr msg{};
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control.data();
+        msg.msg_controllen = control.size();
+
+        cmsghdr* const cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level    = SOL_SOCKET;
+        cmsg->cmsg_type     = SCM_RIGHTS;
+        cmsg->cmsg_len      = CMSG_LEN(3 * sizeof(int));
+        std::array<int, 3> const fds{memfd, doorbell, room};
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(fds));
+
+        return ::sendmsg(sock, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(offer));
+    }
+
+    enum struct offer_status : std::uint8_t { received, not_yet, broken };
+
+    /// Receive the offer and its three fds; on `received` the caller owns them.
+    [[nodiscard]] offer_status receive_offer(int const sock, ring_offer& offer, std::array<int, 3>& fds) noexcept {
+        iovec iov{.iov_base = &offer, .iov_len = sizeof(offer)};
+
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(3 * sizeof(int))> control{};
+
+        msghdr msg{};
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control.data();
+        msg.msg_controllen = control.size();
+
+        auto const res = ::recvmsg(sock, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return offer_status::not_yet;
+        }
+
+        std::size_t received_fds = 0;
+        if (res >= 0) {
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+                    continue;
+                }
+                auto const count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (std::size_t i = 0; i < count; ++i) {
+                    int cur = -1;
+                    std::memcpy(&cur, CMSG_DATA(cmsg) + (i * sizeof(int)), sizeof(int));
+                    if (received_fds < fds.size()) {
+                        fds[received_fds++] = cur;
+                    } else {
+                        ::close(cur);
+                    }
+                }
+            }
+        }
+        bool const valid = res == static_cast<ssize_t>(sizeof(offer))
+                           && (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) == 0
+                           && received_fds == fds.size()
+                           && offer.magic == offer_magic
+                           && offer.version == offer_version;
+        if (!valid) {
+            for (std::size_t i = 0; i < received_fds; ++i) {
+                ::close(fds[i]);
+            }
+            return offer_status::broken;
+        }
+        return offer_status::received;
+    }
+
+    void ring_doorbell(int const doorbell) noexcept {
+        std::uint64_t const one = 1;
+        static_cast<void>(::write(doorbell, &one, sizeof(one)));
+    }
+} // namespace
+
+namespace fs8::detail {
+
+    /// The writing end of a shared ring, offered to the reader of the pipe.
+    struct ring_writer {
+        enum struct phase : std::uint8_t {
+            probing,  // looking for a foresight reader on the other end
+            offered,  // sent the ring, waiting for the answer
+            attached, // the events go through the ring
+        };
+
+        phase                  state = phase::probing;
+        sockaddr_un            addr{};
+        socklen_t              addr_len = 0;
+        int                    sock     = -1;
+        int                    doorbell = -1;
+        int                    room     = -1; // the reader rings it when it made room for us
+        shm_ring<input_event>  ring;
+        clock_type::time_point next_probe{};
+        clock_type::time_point give_up_at{};
+
+        ring_writer()                              = default;
+        ring_writer(ring_writer const&)            = delete;
+        ring_writer& operator=(ring_writer const&) = delete;
+
+        ~ring_writer() noexcept {
+            close_fd(sock);
+            close_fd(doorbell);
+            close_fd(room);
+        }
+    };
+
+    /// The reading end: listens for the writer of the pipe to offer a ring.
+    struct ring_reader {
+        enum struct phase : std::uint8_t {
+            listening, // waiting for a writer to offer a ring
+            attached,  // got the ring, the pipe is read until the writer's switch marker
+            switched,  // the events come through the ring
+        };
+
+        phase                  state    = phase::listening;
+        int                    listener = -1;
+        int                    conn     = -1;
+        int                    doorbell = -1;
+        int                    room     = -1;    // rung when the writer waits for room and we made some
+        bool                   hung_up  = false; // the writer closed the pipe
+        shm_ring<input_event>  ring;
+        clock_type::time_point give_up_at{};
+
+        ring_reader()                              = default;
+        ring_reader(ring_reader const&)            = delete;
+        ring_reader& operator=(ring_reader const&) = delete;
+
+        ~ring_reader() noexcept {
+            close_fd(listener);
+            close_fd(conn);
+            close_fd(doorbell);
+            close_fd(room);
+        }
+    };
+
+} // namespace fs8::detail
+
+namespace {
+    using fs8::detail::ring_reader;
+    using fs8::detail::ring_writer;
+
+    /// One step of finding the reader and handing it the ring; false when
+    /// there's no point in trying anymore.
+    [[nodiscard]] bool negotiate(ring_writer& link, int const pipe_fd) noexcept {
+        using enum ring_writer::phase;
+        auto const now = clock_type::now();
+        if (link.give_up_at == clock_type::time_point{}) {
+            link.give_up_at = now + negotiation_window;
+        }
+        if (link.state == probing) {
+            if (now < link.next_probe) {
+                return true;
+            }
+            if (now > link.give_up_at) {
+                return false;
+            }
+            link.next_probe = now + probe_interval;
+            int const sock  = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+            if (sock < 0) [[unlikely]] {
+                return false;
+            }
+            if (::connect(sock, reinterpret_cast<sockaddr const*>(&link.addr), link.addr_len) != 0) {
+                // Not a foresight reader, or it's not listening yet.
+                ::close(sock);
+                return true;
+            }
+            link.ring     = fs8::shm_ring<input_event>::create(ring_capacity);
+            link.doorbell = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            link.room     = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (!link.ring.is_ok()
+                || link.doorbell < 0
+                || link.room < 0
+                || !send_offer(sock, link.ring.native_handle(), link.doorbell, link.room))
+            {
+                ::close(sock);
+                return false;
+            }
+            link.sock  = sock;
+            link.state = offered;
+            return true;
+        }
+        if (link.state == offered) {
+            char       answer = refused;
+            auto const res    = ::recv(link.sock, &answer, 1, MSG_DONTWAIT);
+            if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                return now <= link.give_up_at;
+            }
+            close_fd(link.sock);
+            if (res != 1 || answer != accepted) {
+                return false;
+            }
+            // Whatever went before the marker is in the pipe, the rest is in the ring.
+            auto const marker = switch_marker();
+            if (!write_all(pipe_fd, &marker, sizeof(marker))) [[unlikely]] {
+                return false;
+            }
+            link.state = attached;
+        }
+        return true;
+    }
+
+    /// Push the events to the ring, waiting for the reader when it's full.
+    [[nodiscard]] bool push_events(ring_writer& link, std::span<input_event const> const events, int const pipe_fd) noexcept {
+        while (!link.ring.try_push(events)) {
+            if (!link.ring.prepare_sleep_for_room(events.size())) {
+                continue;
+            }
+            // The reader rings when it made room, and the pipe errors out when it's gone.
+            std::array<pollfd, 2> fds{
+              {{.fd = link.room, .events = POLLIN, .revents = 0}, {.fd = pipe_fd, .events = 0, .revents = 0}}
+            };
+            auto const res = ::poll(fds.data(), fds.size(), -1);
+            link.ring.woke_up_for_room();
+            if (res < 0) [[unlikely]] {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if ((fds[0].revents & POLLIN) != 0) {
+                std::uint64_t count = 0;
+                static_cast<void>(::read(link.room, &count, sizeof(count)));
+            }
+            if ((fds[1].revents & (POLLERR | POLLHUP)) != 0) [[unlikely]] {
+                return false;
+            }
+        }
+        if (link.ring.consumer_sleeping()) {
+            ring_doorbell(link.doorbell);
+        }
+        return true;
+    }
+
+    /// Take the writer's offer; the connection is accepted first, the offer comes next.
+    void answer_writer(ring_reader& link) noexcept {
+        if (link.conn < 0) {
+            int const conn = ::accept4(link.listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (conn < 0) {
+                return;
+            }
+            ucred     cred{};
+            socklen_t cred_len = sizeof(cred);
+            if (::getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) != 0 || cred.uid != ::geteuid()) {
+                ::close(conn);
+                return;
+            }
+            link.conn = conn;
+            return;
+        }
+
+        ring_offer         offer{};
+        std::array<int, 3> fds{-1, -1, -1};
+        switch (receive_offer(link.conn, offer, fds)) {
+            case offer_status::not_yet: return;
+            case offer_status::broken: close_fd(link.conn); return;
+            case offer_status::received: break;
+        }
+        link.ring     = fs8::shm_ring<input_event>::attach(fds[0]);
+        link.doorbell = fds[1];
+        link.room     = fds[2];
+        bool const ok = link.ring.is_ok();
+        char const answer = ok ? accepted : refused;
+        static_cast<void>(::send(link.conn, &answer, 1, MSG_NOSIGNAL));
+        close_fd(link.conn);
+        if (!ok) {
+            close_fd(link.doorbell);
+            close_fd(link.room);
+            return;
+        }
+        close_fd(link.listener);
+        link.state = ring_reader::phase::attached;
+    }
+} // namespace
+
+// --- output ---
+
+bool fs8::basic_output::send(std::span<input_event const> const events) noexcept {
+    if (transport == io_transport::shared_memory) {
+        if (ring.get() == nullptr) {
+            try {
+                ring = nullable_indirect<detail::ring_writer>::make();
+            } catch (...) {
+                transport = io_transport::pipe;
+            }
+            if (ring.get() != nullptr && !ring_address(file_descriptor, ring->addr, ring->addr_len)) {
+                ring.reset();
+                transport = io_transport::pipe;
+            }
+        }
+        if (ring.get() != nullptr) {
+            if (ring->state != detail::ring_writer::phase::attached && !negotiate(*ring, file_descriptor)) {
+                // Not a foresight reader; stick to the pipe.
+                ring.reset();
+                transport = io_transport::pipe;
+            } else if (ring->state == detail::ring_writer::phase::attached) {
+                return push_events(*ring, events, file_descriptor);
+            }
+        }
+    }
+    return write_all(file_descriptor, events.data(), events.size_bytes());
+}
+
+bool fs8::basic_output::write_out(input_event const& event) noexcept {
+    if (buffering == io_buffering::per_event) {
+        bool const ok = send(std::span{&event, 1});
+        if (ok && is_tracing()) [[unlikely]] {
+            trace_egress(this, "output");
+        }
+        return ok;
+    }
+    if (is_tracing()) [[unlikely]] {
+        try {
+            if (pending_triggers.get() == nullptr) {
+                pending_triggers = nullable_indirect<std::array<trace_trigger, io_batch_size>>::make();
+            }
+            (*pending_triggers)[traced_count++] = *basic_traced_event::instance();
+        } catch (...) {
+            // The event still goes out, untraced.
+        }
+    }
+    pending[pending_count++] = event;
+    if (pending_count == pending.size() || (event.type == EV_SYN && event.code == SYN_REPORT)) {
+        return flush();
+    }
+    return true;
+}
+
+bool fs8::basic_output::flush() noexcept {
+    if (pending_count == 0) {
+        return true;
+    }
+    bool const ok = send(std::span{pending.data(), pending_count});
+    if (ok && traced_count != 0) [[unlikely]] {
+        for (auto const& trigger : std::span{pending_triggers->data(), traced_count}) {
+            trace_egress(trigger, this, "output");
+        }
+    }
+    pending_count = 0;
+    traced_count  = 0;
+    return ok;
+}
+
+bool fs8::basic_output::shares_memory() const noexcept {
+    return ring.get() != nullptr && ring->state == detail::ring_writer::phase::attached;
 }
 
-bool fs8::basic_output::emit(input_event const& event) const noexcept {
-    return write(file_descriptor, &event, sizeof(input_event)) == sizeof(input_event);
+bool fs8::basic_output::emit(event_type const& event) noexcept {
+    return write_out(event.native());
 }
 
-bool fs8::basic_output::emit(ev_type const type, code_type const code, value_type const value) const noexcept {
+bool fs8::basic_output::emit(input_event const& event) noexcept {
+    return write_out(event);
+}
+
+bool fs8::basic_output::emit(ev_type const type, code_type const code, value_type const value) noexcept {
     input_event event{};
     gettimeofday(&event.time, nullptr);
     event.type  = type;
     event.code  = code;
     event.value = value;
-    return write(file_descriptor, &event, sizeof(input_event)) == sizeof(input_event);
+    return write_out(event);
 }
 
-bool fs8::basic_output::emit_syn() const noexcept {
+bool fs8::basic_output::emit_syn() noexcept {
     return emit(EV_SYN, SYN_REPORT, 0);
 }
 
-bool fs8::basic_output::operator()(event_type& event) const noexcept {
-    return write(file_descriptor, &event.native(), sizeof(input_event)) == sizeof(input_event);
+bool fs8::basic_output::operator()(event_type& event) noexcept {
+    return write_out(event.native());
+}
+
+// --- from_input ---
+
+bool fs8::basic_from_input::shares_memory() const noexcept {
+    return ring.get() != nullptr && ring->state == detail::ring_reader::phase::switched;
 }
 
-context_action fs8::basic_from_input::operator()(event_type& event, load_event_tag) const noexcept {
+context_action fs8::basic_from_input::wait_for_pipe() noexcept {
     using enum context_action;
+    if (ring.get() == nullptr || ring->state != detail::ring_reader::phase::listening) {
+        return next;
+    }
+    auto& link = *ring;
+    for (;;) {
+        auto const now = clock_type::now();
+        if (link.give_up_at != clock_type::time_point{} && now > link.give_up_at) {
+            // No foresight writer showed up (in time).
+            ring.reset();
+            transport = io_transport::pipe;
+            return next;
+        }
+
+        int timeout = -1;
+        if (link.give_up_at != clock_type::time_point{}) {
+            auto const left = std::chrono::ceil<std::chrono::milliseconds>(link.give_up_at - now);
+            timeout         = static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+        }
+        std::array<pollfd, 2> fds{
+          {{.fd = file_descriptor, .events = POLLIN, .revents = 0},
+           {.fd = link.conn >= 0 ? link.conn : link.listener, .events = POLLIN, .revents = 0}}
+        };
+        auto const res = ::poll(fds.data(), fds.size(), timeout);
+        if (res < 0) [[unlikely]] {
+            return errno == EINTR ? ignore_event : next;
+        }
+        if (fds[1].revents != 0) {
+            answer_writer(link);
+            if (link.state != detail::ring_reader::phase::listening) {
+                return next;
+            }
+        }
+        if (fds[0].revents != 0) {
+            if (link.give_up_at == clock_type::time_point{}) {
+                link.give_up_at = now + negotiation_window;
+            }
+            return next;
+        }
+    }
+}
+
+context_action fs8::basic_from_input::load_one(event_type& event) noexcept {
+    using enum context_action;
+    if (auto const action = wait_for_pipe(); action != next) [[unlikely]] {
+        return action;
+    }
     auto const res = read(file_descriptor, &event.native(), sizeof(input_event));
     if (res == 0) [[unlikely]] {
         return exit;
@@ -47,3 +553,127 @@ context_action fs8::basic_from_input::operator()(event_type& event, load_event_t
     event.source(device_id::stdin);
     return next;
 }
+
+context_action fs8::basic_from_input::load_batched(event_type& event) noexcept {
+    using enum context_action;
+    constexpr std::size_t record_size = sizeof(input_event);
+
+    auto const complete = filled_bytes / record_size;
+    if (head == complete) {
+        // Served them all; keep the partial trailing record, and read some more.
+        auto const partial = filled_bytes % record_size;
+        auto*      bytes   = reinterpret_cast<char*>(buffer.data());
+        std::memmove(bytes, bytes + complete * record_size, partial);
+        head         = 0;
+        filled_bytes = partial;
+
+        if (auto const action = wait_for_pipe(); action != next) [[unlikely]] {
+            return action;
+        }
+        auto const res = read(file_descriptor, bytes + filled_bytes, sizeof(buffer) - filled_bytes);
+        if (res == 0) [[unlikely]] {
+            return exit; // a trailing partial record can't be completed anymore
+        }
+        if (res < 0) [[unlikely]] {
+            return ignore_event;
+        }
+        filled_bytes += static_cast<std::size_t>(res);
+        if (filled_bytes < record_size) {
+            return ignore_event; // not even one whole event yet
+        }
+    }
+    event.native() = buffer[head++];
+    event.source(device_id::stdin);
+    return next;
+}
+
+context_action fs8::basic_from_input::load_from_ring(event_type& event) noexcept {
+    using enum context_action;
+    constexpr std::size_t record_size = sizeof(input_event);
+
+    auto& link = *ring;
+    for (;;) {
+        if (head < filled_bytes / record_size) {
+            event.native() = buffer[head++];
+            event.source(device_id::stdin);
+            return next;
+        }
+        if (auto const count = link.ring.pop(buffer); count != 0) {
+            if (link.ring.producer_sleeping()) {
+                ring_doorbell(link.room);
+            }
+            head         = 0;
+            filled_bytes = count * record_size;
+            continue;
+        }
+        if (link.hung_up) {
+            return exit; // drained what the writer left behind
+        }
+        if (!link.ring.prepare_sleep()) {
+            continue;
+        }
+        // Nothing but the hang-up is coming through the pipe anymore.
+        std::array<pollfd, 2> fds{
+          {{.fd = link.doorbell, .events = POLLIN, .revents = 0}, {.fd = file_descriptor, .events = POLLIN, .revents = 0}}
+        };
+        auto const res = ::poll(fds.data(), fds.size(), -1);
+        link.ring.woke_up();
+        if (res < 0) [[unlikely]] {
+            return errno == EINTR ? ignore_event : exit;
+        }
+        if ((fds[0].revents & POLLIN) != 0) {
+            std::uint64_t count = 0;
+            static_cast<void>(::read(link.doorbell, &count, sizeof(count)));
+        }
+        if (fds[1].revents != 0) {
+            link.hung_up = true;
+        }
+    }
+}
+
+context_action fs8::basic_from_input::operator()(event_type& event, load_event_tag) noexcept {
+    using enum context_action;
+    if (transport == io_transport::shared_memory) {
+        if (ring.get() == nullptr) {
+            try {
+                ring = nullable_indirect<detail::ring_reader>::make();
+            } catch (...) {
+                transport = io_transport::pipe;
+            }
+            if (ring.get() != nullptr) {
+                sockaddr_un addr{};
+                socklen_t   addr_len = 0;
+                int const   sock     = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+                if (!ring_address(file_descriptor, addr, addr_len)
+                    || sock < 0
+                    || ::bind(sock, reinterpret_cast<sockaddr const*>(&addr), addr_len) != 0
+                    || ::listen(sock, 1) != 0)
+                {
+                    // Not a pipe, or somebody else is reading it already.
+                    if (sock >= 0) {
+                        ::close(sock);
+                    }
+                    ring.reset();
+                    transport = io_transport::pipe;
+                } else {
+                    ring->listener = sock;
+                }
+            }
+        } else if (ring->state == detail::ring_reader::phase::switched) {
+            return load_from_ring(event);
+        }
+    }
+
+    auto const action = buffering == io_buffering::batched ? load_batched(event) : load_one(event);
+    if (action == next && ring.get() != nullptr && is_switch_marker(event.native())) {
+        if (ring->state != detail::ring_reader::phase::attached) [[unlikely]] {
+            return ignore_event;
+        }
+        // The writer won't put anything else in the pipe.
+        ring->state  = detail::ring_reader::phase::switched;
+        head         = 0;
+        filled_bytes = 0;
+        return ignore_event;
+    }
+    return action;
+}
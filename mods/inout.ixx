@@ -1,16 +1,57 @@
 // Created by moisrex on 6/9/25.
 
 module;
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
 #include <linux/uinput.h>
+#include <span>
 #include <unistd.h>
 export module fs8.mods:inout;
 import fs8.context;
 import fs8.event;
+import fs8.nullable_indirect;
 import fs8.traits;
+import :latency_trace;
+
+namespace fs8::detail {
+    // The shared-memory links live in `mods/inout.cxx`; they own fds and a mapping.
+    struct ring_writer;
+    struct ring_reader;
+} // namespace fs8::detail
 
 export namespace fs8 {
 
+    /// How `output` and `from_input` talk to their file descriptor.
+    enum struct [[nodiscard]] io_buffering : std::uint8_t {
+        per_event, // one read/write per event
+        batched,   // as many events per read/write as possible
+    };
+
+    /// The number of events `output` and `from_input` hold in the batched mode.
+    constexpr std::size_t io_batch_size = 128;
+
+    /// What carries the events between `output` and `from_input` of two processes.
+    enum struct [[nodiscard]] io_transport : std::uint8_t {
+        pipe,          // the file descriptor itself
+        shared_memory, // a shared ring, when the other end is a foresight process too; the pipe otherwise
+    };
+
+    /**
+     * Writes the events to a file descriptor (stdout by default).
+     *
+     * With `output[io_buffering::batched]` the events are held back and written
+     * together on `SYN_REPORT`, when the buffer fills up, or when the pipeline
+     * flushes its outputs (right before it blocks, and when it exits).
+     *
+     * With `output[io_transport::shared_memory]`, when the fd is a pipe whose
+     * reader is a `from_input[io_transport::shared_memory]`, the two ends agree
+     * on a memfd-backed ring and an eventfd doorbell over a unix socket, and the
+     * events stop going through the pipe; the pipe is used when they can't.
+     * When the ring is full, the writer sleeps on a second eventfd until the
+     * reader has made room.
+     */
     constexpr struct [[nodiscard]] basic_output : consteval_copyable {
         using consteval_copyable::consteval_copyable;
 
@@ -19,42 +60,121 @@ export namespace fs8 {
         using value_type = event_type::value_type;
 
       private:
-        int file_descriptor = STDOUT_FILENO;
+        int          file_descriptor = STDOUT_FILENO;
+        io_buffering buffering       = io_buffering::per_event;
+
+        io_transport transport       = io_transport::pipe;
+
+        std::array<input_event, io_batch_size> pending{};
+        std::size_t                            pending_count = 0;
+
+        // the triggers of the held events; allocated once something's traced
+        nullable_indirect<std::array<trace_trigger, io_batch_size>> pending_triggers{};
+        std::size_t                                                 traced_count = 0;
+
+        nullable_indirect<detail::ring_writer> ring{};
+
+        bool write_out(input_event const& event) noexcept;
+        bool send(std::span<input_event const> events) noexcept;
 
       public:
         constexpr explicit basic_output(int const inp_fd) noexcept : file_descriptor(inp_fd) {}
 
+        consteval basic_output operator[](io_buffering const inp_buffering) const noexcept {
+            auto res{*this};
+            res.buffering = inp_buffering;
+            return res;
+        }
+
+        consteval basic_output operator[](io_transport const inp_transport) const noexcept {
+            auto res{*this};
+            res.transport = inp_transport;
+            return res;
+        }
+
         constexpr void set_output(int const inp_fd) noexcept {
             file_descriptor = inp_fd;
         }
 
         // NOLINTNEXTLINE(*-use-nodiscard)
-        bool emit(event_type const& event) const noexcept;
+        bool emit(event_type const& event) noexcept;
+
+        // NOLINTNEXTLINE(*-use-nodiscard)
+        bool emit(input_event const& event) noexcept;
 
         // NOLINTNEXTLINE(*-use-nodiscard)
-        bool emit(input_event const& event) const noexcept;
+        bool emit(ev_type type, code_type code, value_type value) noexcept;
 
         // NOLINTNEXTLINE(*-use-nodiscard)
-        bool emit(ev_type type, code_type code, value_type value) const noexcept;
+        bool emit_syn() noexcept;
 
+        /// Write out the events held back in the batched mode.
         // NOLINTNEXTLINE(*-use-nodiscard)
-        bool emit_syn() const noexcept;
+        bool flush() noexcept;
+
+        /// Whether the events go through a shared ring instead of the fd.
+        [[nodiscard]] bool shares_memory() const noexcept;
 
         // NOLINTNEXTLINE(*-use-nodiscard)
-        bool operator()(event_type& event) const noexcept;
+        bool operator()(event_type& event) noexcept;
+
+        void operator()(flush_tag) noexcept {
+            static_cast<void>(flush());
+        }
     } output;
 
     static_assert(OutputModifier<basic_output>, "Must be a output modifier.");
 
+    /**
+     * Loads the events from a file descriptor (stdin by default).
+     *
+     * With `from_input[io_buffering::batched]` each `read` takes as many whole
+     * events as are available, and they're served from the buffer one by one;
+     * a record split across two reads is put back together.
+     *
+     * With `from_input[io_transport::shared_memory]` it offers a foresight
+     * writer on the other end of the pipe to switch to a shared ring (see
+     * `output`); everything written to the pipe before the switch is still
+     * read first.
+     */
     constexpr struct [[nodiscard]] basic_from_input : consteval_copyable {
         using consteval_copyable::consteval_copyable;
 
       private:
-        int file_descriptor = STDIN_FILENO;
+        int          file_descriptor = STDIN_FILENO;
+        io_buffering buffering       = io_buffering::per_event;
+
+        io_transport transport       = io_transport::pipe;
+
+        std::array<input_event, io_batch_size> buffer{};
+        std::size_t                            head         = 0; // the next event to serve
+        std::size_t                            filled_bytes = 0; // bytes read into the buffer
+
+        nullable_indirect<detail::ring_reader> ring{};
+
+        context_action load_one(event_type& event) noexcept;
+        context_action load_batched(event_type& event) noexcept;
+        context_action load_from_ring(event_type& event) noexcept;
+        context_action wait_for_pipe() noexcept;
 
       public:
         constexpr explicit basic_from_input(int const inp_fd) noexcept : file_descriptor(inp_fd) {}
 
-        context_action operator()(event_type& event, load_event_tag) const noexcept;
+        consteval basic_from_input operator[](io_buffering const inp_buffering) const noexcept {
+            auto res{*this};
+            res.buffering = inp_buffering;
+            return res;
+        }
+
+        consteval basic_from_input operator[](io_transport const inp_transport) const noexcept {
+            auto res{*this};
+            res.transport = inp_transport;
+            return res;
+        }
+
+        /// Whether the events come through a shared ring instead of the fd.
+        [[nodiscard]] bool shares_memory() const noexcept;
+
+        context_action operator()(event_type& event, load_event_tag) noexcept;
     } from_input;
 } // namespace fs8
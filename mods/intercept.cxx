@@ -2,17 +2,34 @@
 
 module;
 #include <algorithm>
-#include <deque>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fcntl.h>
+#include <linux/input.h>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <span>
+#include <stop_token>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
 #include <sys/poll.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 module fs8.mods;
 import fs8.devices.evdev;
 import fs8.context;
 import fs8.log;
+import fs8.spsc_ring;
 import :io_manager;
 import :input_manager;
 
@@ -20,18 +37,643 @@ using fs8::basic_interceptor;
 using fs8::context_action;
 using fs8::device_query;
 using fs8::event_type;
+using fs8::intercept_mode;
+using fs8::intercept_stats;
 using fs8::io_event;
 using fs8::io_fd;
 using fs8::provider_handle;
 
+namespace {
+    using fs8::device_id;
+
+    /// How many events the ring holds before its first growth; a few full
+    /// kernel evdev buffers' worth, so a burst never reallocates in practice.
+    constexpr std::size_t initial_ring_capacity = 512;
+
+    /// The queue between the device reads and `next_event`: a power-of-two
+    /// ring of raw `input_event`s that `read(2)` fills in place, with the
+    /// source of each event in a parallel ring. Grows (doubling) only when
+    /// the consumer falls a whole ring behind.
+    struct event_ring {
+        std::vector<input_event> events;
+        std::vector<device_id>   sources;
+        std::size_t              head = 0; // next to pop; monotonic
+        std::size_t              tail = 0; // next to push; monotonic
+        std::size_t              high_water = 0;
+
+        [[nodiscard]] bool empty() const noexcept {
+            return head == tail;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return tail - head;
+        }
+
+        [[nodiscard]] std::size_t mask() const noexcept {
+            return events.size() - 1;
+        }
+
+        /// The free space right after `tail` that doesn't wrap around.
+        [[nodiscard]] std::span<input_event> writable() {
+            if (size() == events.size()) [[unlikely]] {
+                grow();
+            }
+            auto const start = tail & mask();
+            auto const len   = std::min(events.size() - start, events.size() - size());
+            return std::span{events}.subspan(start, len);
+        }
+
+        /// Publish the first `count` events of the last `writable()` span.
+        void commit(std::size_t const count, device_id const source) noexcept {
+            for (std::size_t i = 0; i < count; ++i) {
+                sources[(tail + i) & mask()] = source;
+            }
+            tail       += count;
+            high_water  = std::max(high_water, size());
+        }
+
+        /// False only when growing the ring ran out of memory.
+        bool push(input_event const& ev, device_id const source) noexcept try {
+            auto const space = writable();
+            space.front()    = ev;
+            commit(1, source);
+            return true;
+        } catch (...) {
+            return false;
+        }
+
+        [[nodiscard]] event_type pop() noexcept {
+            auto const at = head++ & mask();
+            event_type ev{events[at]};
+            ev.source(sources[at]);
+            return ev;
+        }
+
+      private:
+        void grow() {
+            auto const cap = events.empty() ? initial_ring_capacity : events.size() * 2;
+            std::vector<input_event> new_events(std::bit_ceil(cap));
+            std::vector<device_id>   new_sources(new_events.size());
+            auto const               count = size();
+            for (std::size_t i = 0; i < count; ++i) {
+                new_events[i]  = events[(head + i) & mask()];
+                new_sources[i] = sources[(head + i) & mask()];
+            }
+            events  = std::move(new_events);
+            sources = std::move(new_sources);
+            head    = 0;
+            tail    = count;
+        }
+    };
+
+    [[nodiscard]] bool is_syn_dropped(input_event const& ev) noexcept {
+        return ev.type == EV_SYN && ev.code == SYN_DROPPED;
+    }
+
+    [[nodiscard]] bool is_syn_report(input_event const& ev) noexcept {
+        return ev.type == EV_SYN && ev.code == SYN_REPORT;
+    }
+
+    /// Pull everything `dev` has queued into `ring`, a whole buffer per
+    /// `read(2)`. A `SYN_DROPPED` cuts the batch short: the events after it
+    /// are incomplete, so libevdev resyncs and its state differences are
+    /// queued in their place.
+    void drain_into(fs8::evdev& dev, event_ring& ring, device_id const source, std::size_t& syn_dropped) {
+        for (;;) {
+            auto const space = ring.writable();
+            auto const got   = dev.read_events(space);
+            if (got.empty()) {
+                return;
+            }
+            auto const dropped = std::ranges::find_if(got, is_syn_dropped);
+            ring.commit(static_cast<std::size_t>(dropped - got.begin()), source);
+            if (dropped != got.end()) [[unlikely]] {
+                ++syn_dropped;
+                dev.resync([&](input_event const& ev) {
+                    ring.push(ev, source);
+                });
+                continue;
+            }
+            if (got.size() < space.size()) {
+                return; // the kernel buffer is empty
+            }
+        }
+    }
+
+    /// An event on its way from the reader thread; `watch` is the serial the
+    /// device was watched with on the pipeline side, to find its `evdev`
+    /// again (fd numbers get reused after an unplug).
+    struct queued_event {
+        input_event   ev{};
+        device_id     source{};
+        std::uint32_t watch = 0;
+    };
+
+    [[nodiscard]] input_event event_at(timeval const time, std::uint16_t const type, unsigned const code, std::int32_t const value) noexcept {
+        input_event ev{};
+        ev.time  = time;
+        ev.type  = type;
+        ev.code  = static_cast<std::uint16_t>(code);
+        ev.value = value;
+        return ev;
+    }
+
+    /// The reader thread's own view of a device's key/led/switch/abs state,
+    /// read with the `EVIOCG*` ioctls and kept up to date with the frames it
+    /// queues; it's what a `SYN_DROPPED` is resynced against, without
+    /// libevdev. Multitouch slots aren't tracked, like `evdev::mirror`.
+    struct device_mirror {
+        std::array<unsigned char, (KEY_MAX / 8) + 1> keys{};
+        std::array<unsigned char, (LED_MAX / 8) + 1> leds{};
+        std::array<unsigned char, (SW_MAX / 8) + 1>  switches{};
+        std::array<std::int32_t, ABS_MT_SLOT>        abs{};
+        std::uint64_t                                axes = 0; // the axes below ABS_MT_SLOT the device has
+
+        [[nodiscard]] static bool bit(std::span<unsigned char const> const bits, unsigned const code) noexcept {
+            return code / 8 < bits.size() && (bits[code / 8] & (1U << (code % 8))) != 0;
+        }
+
+        static void set_bit(std::span<unsigned char> const bits, unsigned const code, bool const on) noexcept {
+            if (code / 8 < bits.size()) {
+                auto const mask = static_cast<unsigned char>(1U << (code % 8));
+                bits[code / 8]  = static_cast<unsigned char>(on ? bits[code / 8] | mask : bits[code / 8] & ~mask);
+            }
+        }
+
+        /// Read the state of the device; false if it's gone.
+        [[nodiscard]] bool query(int const fd) noexcept {
+            std::array<unsigned char, (ABS_MAX / 8) + 1> abs_bits{};
+            if (::ioctl(fd, EVIOCGBIT(EV_ABS, abs_bits.size()), abs_bits.data()) < 0
+                || ::ioctl(fd, EVIOCGKEY(keys.size()), keys.data()) < 0
+                || ::ioctl(fd, EVIOCGLED(leds.size()), leds.data()) < 0
+                || ::ioctl(fd, EVIOCGSW(switches.size()), switches.data()) < 0)
+            {
+                return false;
+            }
+            axes = 0;
+            for (unsigned axis = 0; axis < abs.size(); ++axis) {
+                input_absinfo info{};
+                if (bit(abs_bits, axis) && ::ioctl(fd, EVIOCGABS(axis), &info) == 0) {
+                    axes      |= std::uint64_t{1} << axis;
+                    abs[axis]  = info.value;
+                }
+            }
+            return true;
+        }
+
+        /// Does `ev` change the state? After a resync, the events that were
+        /// still in the kernel's buffer are in the state already. The events
+        /// of a frame go in one by one, as they're taken, or a press and its
+        /// release in the same frame would lose the release.
+        [[nodiscard]] bool changes(input_event const& ev) const noexcept {
+            switch (ev.type) {
+                case EV_KEY: return ev.value == 2 || bit(keys, ev.code) != (ev.value != 0);
+                case EV_LED: return bit(leds, ev.code) != (ev.value != 0);
+                case EV_SW: return bit(switches, ev.code) != (ev.value != 0);
+                case EV_ABS: return ev.code >= ABS_MT_SLOT || abs[ev.code] != ev.value;
+                default: return true;
+            }
+        }
+
+        void apply(input_event const& ev) noexcept {
+            switch (ev.type) {
+                case EV_KEY: set_bit(keys, ev.code, ev.value != 0); break;
+                case EV_LED: set_bit(leds, ev.code, ev.value != 0); break;
+                case EV_SW: set_bit(switches, ev.code, ev.value != 0); break;
+                case EV_ABS:
+                    if (ev.code < ABS_MT_SLOT) {
+                        abs[ev.code] = ev.value;
+                    }
+                    break;
+                default: break;
+            }
+        }
+
+        /// The events that take this state to `now`, each stamped `time`.
+        void diff(device_mirror const& now, timeval const time, std::vector<input_event>& out) const {
+            auto const bits = [&](std::uint16_t const type, auto const& before, auto const& after, unsigned const count) {
+                for (unsigned code = 0; code < count; ++code) {
+                    if (bit(before, code) != bit(after, code)) {
+                        out.push_back(event_at(time, type, code, bit(after, code) ? 1 : 0));
+                    }
+                }
+            };
+            bits(EV_KEY, keys, now.keys, KEY_MAX + 1);
+            bits(EV_LED, leds, now.leds, LED_MAX + 1);
+            bits(EV_SW, switches, now.switches, SW_MAX + 1);
+            for (unsigned axis = 0; axis < abs.size(); ++axis) {
+                if ((now.axes & (std::uint64_t{1} << axis)) != 0 && abs[axis] != now.abs[axis]) {
+                    out.push_back(event_at(time, EV_ABS, axis, now.abs[axis]));
+                }
+            }
+        }
+    };
+
+    /// Events the reader thread can get ahead of the pipeline by.
+    constexpr std::size_t reader_queue_capacity = 4096;
+
+    /// Reads the watched devices on a thread of its own and hands complete
+    /// frames (up to and including their `SYN_REPORT`) to the pipeline thread
+    /// through an SPSC ring, ringing `doorbell` so `io_manager` wakes up.
+    ///
+    /// The reader only `read(2)`s from its own `dup` of each device fd and
+    /// never touches libevdev, which isn't thread-safe; the pipeline thread
+    /// never reads those fds. A frame that doesn't fit in the queue is
+    /// dropped whole. After that, or a `SYN_DROPPED`, the reader resyncs the
+    /// device itself (see `device_mirror`) and queues a `SYN_DROPPED` marker
+    /// with the differences as one frame, in order with the rest.
+    struct device_reader {
+        device_reader() {
+            doorbell = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            control  = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (doorbell < 0 || control < 0) [[unlikely]] {
+                close_fds();
+                throw std::system_error(errno, std::system_category(), "eventfd");
+            }
+            try {
+                thread = std::jthread{[this](std::stop_token const stop) noexcept {
+                    run(stop);
+                }};
+            } catch (...) {
+                close_fds();
+                throw;
+            }
+        }
+
+        device_reader(device_reader const&)            = delete;
+        device_reader(device_reader&&)                 = delete;
+        device_reader& operator=(device_reader const&) = delete;
+        device_reader& operator=(device_reader&&)      = delete;
+
+        ~device_reader() {
+            thread.request_stop();
+            ring(control);
+            thread.join();
+            if (auto const frames = overflowed_frames.load(); frames > 0) {
+                fs8::log("The device reader dropped {} frames ({} events) on a full queue (high-water mark: {} of {} events).",
+                    frames,
+                    overflowed_events.load(),
+                    queue.high_water(),
+                    queue.capacity());
+            }
+            for (auto const& dev : devs) {
+                ::close(dev.fd);
+            }
+            for (auto const& watch : watches) {
+                if (std::ranges::none_of(devs, [&](device_state const& dev) noexcept {
+                        return dev.fd == watch.fd;
+                    }))
+                {
+                    ::close(watch.fd);
+                }
+            }
+            close_fds();
+        }
+
+        /// Pipeline thread: start reading `origin` (through a dup of it); its
+        /// events come back tagged with `serial`.
+        [[nodiscard]] bool watch(int const origin, device_id const source, std::uint32_t const serial) {
+            int const fd = ::fcntl(origin, F_DUPFD_CLOEXEC, 0);
+            if (fd < 0) [[unlikely]] {
+                return false;
+            }
+            {
+                std::scoped_lock const guard{lock};
+                try {
+                    watches.push_back({.serial = serial, .fd = fd, .source = source});
+                } catch (...) {
+                    ::close(fd);
+                    throw;
+                }
+            }
+            ring(control);
+            return true;
+        }
+
+        /// Pipeline thread: stop reading the device watched as `serial`; the
+        /// reader closes its dup.
+        void unwatch(std::uint32_t const serial) noexcept {
+            {
+                std::scoped_lock const guard{lock};
+                std::erase_if(watches, [serial](shared_watch const& watch) noexcept {
+                    return watch.serial == serial;
+                });
+            }
+            ring(control);
+        }
+
+        [[nodiscard]] int doorbell_fd() const noexcept {
+            return doorbell;
+        }
+
+        void clear_doorbell() const noexcept {
+            clear(doorbell);
+        }
+
+        [[nodiscard]] std::optional<queued_event> pop() noexcept {
+            return queue.try_pop();
+        }
+
+        void stats(intercept_stats& out) const noexcept {
+            out.queue_capacity     = queue.capacity();
+            out.high_water         = queue.high_water();
+            out.queued            += queue.size();
+            out.overflowed_frames += overflowed_frames.load(std::memory_order_relaxed);
+            out.overflowed_events += overflowed_events.load(std::memory_order_relaxed);
+            out.syn_dropped       += syn_dropped.load(std::memory_order_relaxed);
+        }
+
+      private:
+        struct shared_watch {
+            std::uint32_t serial = 0;
+            int           fd     = -1;
+            device_id     source{};
+        };
+
+        struct device_state {
+            std::uint32_t             serial = 0;
+            int                       fd     = -1;
+            device_id                 source{};
+            bool                      dropping = false; // skipping to the next SYN_REPORT
+            bool                      resync   = false; // the differences since the last queued frame are owed
+            bool                      broken   = false; // hung up; wait for the unwatch
+            device_mirror             state;            // as of the last queued frame
+            device_mirror             seen;             // and the events of `frame` on top of it
+            std::vector<queued_event> frame;
+        };
+
+        static void ring(int const fd) noexcept {
+            std::uint64_t const one = 1;
+            [[maybe_unused]] auto const res = ::write(fd, &one, sizeof(one));
+        }
+
+        static void clear(int const fd) noexcept {
+            std::uint64_t               count = 0;
+            [[maybe_unused]] auto const res   = ::read(fd, &count, sizeof(count));
+        }
+
+        void close_fds() noexcept {
+            for (int const fd : {doorbell, control}) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+            doorbell = control = -1;
+        }
+
+        /// Reader thread: catch up with the watch list of the pipeline thread.
+        void adopt() {
+            std::scoped_lock const guard{lock};
+            std::erase_if(devs, [this](device_state const& dev) noexcept {
+                bool const gone = std::ranges::none_of(watches, [&](shared_watch const& watch) noexcept {
+                    return watch.fd == dev.fd;
+                });
+                if (gone) {
+                    ::close(dev.fd);
+                }
+                return gone;
+            });
+            for (auto const& watch : watches) {
+                if (std::ranges::any_of(devs, [&](device_state const& dev) noexcept {
+                        return dev.fd == watch.fd;
+                    }))
+                {
+                    continue;
+                }
+                auto& dev  = devs.emplace_back();
+                dev.serial = watch.serial;
+                dev.fd     = watch.fd;
+                dev.source = watch.source;
+                dev.broken = !dev.state.query(dev.fd);
+                dev.seen   = dev.state;
+                dev.frame.reserve(64);
+            }
+        }
+
+        /// Reader thread: queue `dev.frame` as a unit; false (and counted)
+        /// if it didn't fit, and then the differences are owed.
+        bool publish(device_state& dev) noexcept {
+            if (queue.try_push(std::span<queued_event const>{dev.frame})) [[likely]] {
+                for (auto const& item : dev.frame) {
+                    dev.state.apply(item.ev);
+                }
+                return true;
+            }
+            overflowed_frames.fetch_add(1, std::memory_order_relaxed);
+            overflowed_events.fetch_add(dev.frame.size(), std::memory_order_relaxed);
+            dev.seen   = dev.state;
+            dev.resync = true;
+            return false;
+        }
+
+        /// Reader thread: at the `SYN_REPORT` at `time`, read the device's
+        /// state again and queue a `SYN_DROPPED` marker and the differences
+        /// since the last queued frame, as one frame. The events still in the
+        /// kernel's buffer are in that state already; `device_mirror::changes`
+        /// drops them as they come. False if it didn't fit; it's tried again
+        /// at the next `SYN_REPORT` then.
+        bool publish_resync(device_state& dev, timeval const time) noexcept try {
+            dev.seen = dev.state; // the frame is dropped either way
+            device_mirror now;
+            if (!now.query(dev.fd)) [[unlikely]] {
+                dev.broken = true;
+                return false;
+            }
+            deltas.clear();
+            deltas.push_back(event_at(time, EV_SYN, SYN_DROPPED, 0));
+            dev.state.diff(now, time, deltas);
+            deltas.push_back(event_at(time, EV_SYN, SYN_REPORT, 0));
+
+            dev.frame.clear();
+            for (auto const& ev : deltas) {
+                dev.frame.push_back({.ev = ev, .source = dev.source, .watch = dev.serial});
+            }
+            bool const queued = queue.try_push(std::span<queued_event const>{dev.frame});
+            dev.frame.clear();
+            if (!queued) [[unlikely]] {
+                overflowed_frames.fetch_add(1, std::memory_order_relaxed);
+                overflowed_events.fetch_add(deltas.size(), std::memory_order_relaxed);
+                return false;
+            }
+            dev.state  = now;
+            dev.seen   = now;
+            dev.resync = false;
+            return true;
+        } catch (...) {
+            dev.frame.clear();
+            return false;
+        }
+
+        /// Reader thread: read everything `dev` has; true if anything was queued.
+        bool drain(device_state& dev) noexcept {
+            std::array<input_event, 64> buf{};
+            bool                        queued = false;
+            for (;;) {
+                auto const res = ::read(dev.fd, buf.data(), sizeof(buf));
+                if (res <= 0) {
+                    if (res == 0 || (errno != EAGAIN && errno != EINTR)) {
+                        dev.broken = true;
+                    }
+                    return queued;
+                }
+                for (auto const& ev : std::span{buf}.first(static_cast<std::size_t>(res) / sizeof(input_event))) {
+                    if (is_syn_dropped(ev)) [[unlikely]] {
+                        syn_dropped.fetch_add(1, std::memory_order_relaxed);
+                        dev.frame.clear();
+                        dev.seen = dev.state;
+                        dev.dropping = true;
+                        dev.resync   = true;
+                        continue;
+                    }
+                    if (dev.dropping) [[unlikely]] {
+                        dev.dropping = !is_syn_report(ev);
+                        if (!dev.dropping) {
+                            queued |= publish_resync(dev, ev.time);
+                        }
+                        continue;
+                    }
+                    if (is_syn_report(ev)) {
+                        if (dev.resync) [[unlikely]] {
+                            // this frame is in the device's state already
+                            queued |= publish_resync(dev, ev.time);
+                            continue;
+                        }
+                    } else if (!dev.seen.changes(ev)) {
+                        continue;
+                    }
+                    try {
+                        dev.frame.push_back({.ev = ev, .source = dev.source, .watch = dev.serial});
+                    } catch (...) {
+                        dev.frame.clear();
+                        dev.seen     = dev.state;
+                        dev.dropping = true;
+                        dev.resync   = true;
+                        continue;
+                    }
+                    dev.seen.apply(ev);
+                    if (is_syn_report(ev)) {
+                        queued |= publish(dev);
+                        dev.frame.clear();
+                    }
+                }
+                if (static_cast<std::size_t>(res) < sizeof(buf)) {
+                    return queued;
+                }
+            }
+        }
+
+        void run(std::stop_token const stop) noexcept try {
+            std::vector<pollfd> fds;
+            while (!stop.stop_requested()) {
+                fds.clear();
+                fds.push_back({.fd = control, .events = POLLIN, .revents = 0});
+                for (auto const& dev : devs) {
+                    // a hung-up fd would report POLLHUP on every pass; poll
+                    // skips negative ones
+                    fds.push_back({.fd = dev.broken ? -1 : dev.fd, .events = POLLIN, .revents = 0});
+                }
+                if (::poll(fds.data(), fds.size(), -1) < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return;
+                }
+
+                bool queued = false;
+                for (std::size_t i = 1; i < fds.size(); ++i) {
+                    auto& dev = devs[i - 1];
+                    if ((fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0) [[unlikely]] {
+                        dev.broken = true;
+                    } else if ((fds[i].revents & POLLIN) != 0) {
+                        queued |= drain(dev);
+                    }
+                }
+                if (queued) {
+                    ring(doorbell);
+                }
+
+                if ((fds.front().revents & POLLIN) != 0) {
+                    clear(control);
+                    adopt();
+                }
+            }
+        } catch (...) {
+            // Out of memory while adopting; the pipeline keeps its eventfd
+            // and just stops hearing from the devices.
+        }
+
+        fs8::spsc_ring<queued_event> queue{reader_queue_capacity};
+        int                          doorbell = -1; // reader -> pipeline
+        int                          control  = -1; // pipeline -> reader
+
+        std::mutex                lock;
+        std::vector<shared_watch> watches; // guarded by `lock`
+        std::vector<device_state> devs;    // the reader thread's own
+        std::vector<input_event>  deltas;  // the reader thread's own
+
+        std::atomic<std::size_t> overflowed_frames{0};
+        std::atomic<std::size_t> overflowed_events{0};
+        std::atomic<std::size_t> syn_dropped{0};
+
+        std::jthread thread; // last: everything above is ready before it starts
+    };
+} // namespace
+
 template <>
 struct fs8::pimpl_idiom<basic_interceptor>::impl {
-    basic_input_manager*   im = nullptr;
-    std::list<evdev>       manual_devs;
-    std::deque<event_type> pending;
-    std::vector<int>       watched_fds;
+    basic_input_manager* im = nullptr;
+    std::list<evdev>     manual_devs;
+    event_ring           pending;
+    std::size_t          syn_dropped = 0;
+    /// The fds we watch in `io_manager` (or hand to the reader thread), with
+    /// the device they belonged to when watched: a replugged device can get
+    /// the fd number of a removed one, and must be re-watched (epoll drops
+    /// closed fds on its own). The serial is what the reader thread tags
+    /// their events with; it's never reused.
+    struct watched_device {
+        int           fd     = -1;
+        evdev*        dev    = nullptr;
+        std::uint32_t serial = 0;
+    };
+    std::vector<watched_device> watched_fds;
+    std::uint32_t               next_serial = 0;
+    /// Only in `intercept_mode::reader_thread`.
+    std::unique_ptr<device_reader> reader;
+
+    [[nodiscard]] watched_device const* watched(int const fd) const noexcept {
+        auto const it = std::ranges::find(watched_fds, fd, &watched_device::fd);
+        return it == watched_fds.end() ? nullptr : &*it;
+    }
+
+    [[nodiscard]] evdev* device_of(std::uint32_t const serial) const noexcept {
+        auto const it = std::ranges::find(watched_fds, serial, &watched_device::serial);
+        return it == watched_fds.end() ? nullptr : it->dev;
+    }
+
+    void unwatch(basic_io_manager& io, watched_device const& watch) const noexcept {
+        if (reader) {
+            reader->unwatch(watch.serial);
+        } else {
+            io.unwatch(watch.fd);
+        }
+    }
 };
 
+intercept_stats basic_interceptor::stats() const noexcept {
+    intercept_stats out{};
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return out;
+    }
+    out.queue_capacity = pimpl->pending.events.size();
+    out.high_water     = pimpl->pending.high_water;
+    out.queued         = pimpl->pending.size();
+    out.syn_dropped    = pimpl->syn_dropped;
+    if (pimpl->reader) {
+        pimpl->reader->stats(out);
+    }
+    return out;
+}
+
 void basic_interceptor::add(evdev&& dev) noexcept {
     if (pimpl.get() == nullptr) [[unlikely]] {
         init_impl();
@@ -83,6 +725,31 @@ context_action basic_interceptor::do_start(basic_input_manager& im, basic_io_man
     }
     pimpl->manual_devs.clear();
 
+    // Start over with the watches; `do_pop` sets them up again in the mode
+    // asked for now.
+    for (auto const& watch : pimpl->watched_fds) {
+        pimpl->unwatch(io, watch);
+    }
+    pimpl->watched_fds.clear();
+    if (requested == intercept_mode::reader_thread) {
+        if (!pimpl->reader) {
+            try {
+                pimpl->reader = std::make_unique<device_reader>();
+            } catch (std::exception const& ex) {
+                log("Cannot start the device reader thread ({}); reading on the pipeline thread instead.", ex.what());
+            }
+        }
+        if (pimpl->reader && !io.is_watched(pimpl->reader->doorbell_fd())) {
+            if (!io.watch(io_fd{.fd = pimpl->reader->doorbell_fd(), .events = io_event::in}, *this)) [[unlikely]] {
+                log("Cannot watch the device reader's eventfd; reading on the pipeline thread instead.");
+                pimpl->reader.reset();
+            }
+        }
+    } else if (pimpl->reader) {
+        io.unwatch(pimpl->reader->doorbell_fd());
+        pimpl->reader.reset();
+    }
+
     return im.start(io);
 } catch (...) {
     return context_action::exit;
@@ -93,6 +760,11 @@ context_action basic_interceptor::operator()(io_fd const& fd) noexcept try {
     if (pimpl.get() == nullptr || pimpl->im == nullptr) [[unlikely]] {
         return next;
     }
+    if (pimpl->reader && fd.fd == pimpl->reader->doorbell_fd()) {
+        // The events themselves are popped by `do_pop`.
+        pimpl->reader->clear_doorbell();
+        return next;
+    }
     for (auto& dev : pimpl->im->devices()) {
         if (dev.native_handle() != fd.fd) {
             continue;
@@ -106,8 +778,13 @@ context_action basic_interceptor::operator()(io_fd const& fd) noexcept try {
         // or another process's foresight virtual device is answered later by
         // input_manager (`is_owned` / `is_chained`).
         auto const source = pimpl->im->device_id_of(dev);
-        while (auto const ev = dev.next()) {
-            pimpl->pending.emplace_back(*ev).source(source);
+        if (dev.has_event_code(EV_ABS, ABS_MT_SLOT)) [[unlikely]] {
+            // libevdev tracks the multitouch slots for us; keep it in the loop.
+            while (auto const ev = dev.next()) {
+                pimpl->pending.push(*ev, source);
+            }
+        } else {
+            drain_into(dev, pimpl->pending, source, pimpl->syn_dropped);
         }
         break;
     }
@@ -123,11 +800,11 @@ std::optional<event_type> basic_interceptor::do_pop(basic_input_manager& im, bas
 
     // Unwatch fds whose devices are gone (hotplug removals).
     for (auto it = pimpl->watched_fds.begin(); it != pimpl->watched_fds.end();) {
-        bool const found = std::ranges::any_of(im.devices(), [fd = *it](evdev const& dev) noexcept {
-            return dev.native_handle() == fd;
+        bool const found = std::ranges::any_of(im.devices(), [&](evdev const& dev) noexcept {
+            return dev.native_handle() == it->fd && &dev == it->dev;
         });
         if (!found) {
-            io.unwatch(*it);
+            pimpl->unwatch(io, *it);
             it = pimpl->watched_fds.erase(it);
         } else {
             ++it;
@@ -137,20 +814,48 @@ std::optional<event_type> basic_interceptor::do_pop(basic_input_manager& im, bas
     // Watch any device that is not watched yet (startup + hotplug adds).
     for (auto& dev : im.devices()) {
         int const fd = dev.native_handle();
+        if (pimpl->reader) {
+            if (auto const* const watch = pimpl->watched(fd); watch != nullptr && watch->dev == &dev) {
+                continue;
+            }
+            auto const serial = pimpl->next_serial++;
+            if (pimpl->reader->watch(fd, im.device_id_of(dev), serial)) {
+                pimpl->watched_fds.push_back({.fd = fd, .dev = &dev, .serial = serial});
+            }
+            continue;
+        }
         if (io.is_watched(fd)) {
             continue;
         }
         if (io.watch(io_fd{.fd = fd, .events = io_event::in}, *this)) {
-            pimpl->watched_fds.push_back(fd);
+            pimpl->watched_fds.push_back({.fd = fd, .dev = &dev, .serial = pimpl->next_serial++});
         }
     }
 
-    if (pimpl->pending.empty()) [[likely]] {
+    // Inline reads queue everything here; the reader thread queues its own
+    // resyncs, in order with its frames.
+    if (!pimpl->pending.empty()) {
+        return pimpl->pending.pop();
+    }
+    if (!pimpl->reader) [[likely]] {
         return std::nullopt;
     }
-    auto const ev = pimpl->pending.front();
-    pimpl->pending.pop_front();
-    return ev;
+
+    while (auto const item = pimpl->reader->pop()) {
+        if (is_syn_dropped(item->ev)) [[unlikely]] {
+            continue; // the differences the reader resynced come right after it
+        }
+        // Keep libevdev's view of the device current (LEDs, keys, ...), as
+        // the inline reads do; its fd is the reader's, so no `resync` here.
+        auto* const dev = pimpl->device_of(item->watch);
+        if (dev != nullptr) {
+            dev->mirror(item->ev);
+        }
+        event_type ev{item->ev};
+        ev.source(item->source);
+        return ev;
+    }
+    return std::nullopt;
 } catch (...) {
     return std::nullopt;
 }
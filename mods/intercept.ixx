@@ -3,6 +3,8 @@
 module;
 #include <array>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <ranges>
 #include <span>
@@ -16,6 +18,23 @@ import fs8.pimpl;
 
 export namespace fs8 {
 
+    /// Which thread reads the intercepted devices.
+    enum struct [[nodiscard]] intercept_mode : std::uint8_t {
+        inline_reads,  ///< the pipeline thread, whenever io_manager wakes up for a device (default).
+        reader_thread, ///< a dedicated thread, through a bounded lock-free queue drained by `next_event`.
+    };
+
+    /// Queue health of an interceptor; the overflow counters stay zero for
+    /// `intercept_mode::inline_reads`, whose queue grows instead.
+    struct [[nodiscard]] intercept_stats {
+        std::size_t queue_capacity    = 0; ///< events the queue holds
+        std::size_t queued            = 0; ///< events waiting in it right now
+        std::size_t high_water        = 0; ///< most events queued at once
+        std::size_t overflowed_frames = 0; ///< whole frames dropped because the queue was full
+        std::size_t overflowed_events = 0; ///< events in those frames
+        std::size_t syn_dropped       = 0; ///< kernel buffer overruns (`SYN_DROPPED`)
+    };
+
     /**
      * Query-driven event provider.
      *
@@ -23,6 +42,11 @@ export namespace fs8 {
      * ready devices through `io_manager`. Blocking readiness is provided by
      * `io_manager` (the `load_event` provider) and events are delivered as a
      * `next_event` provider.
+     *
+     * With `intercept[...][intercept_mode::reader_thread]` the devices are read
+     * on a thread of their own, so a slow mod further down the pipeline can't
+     * hold up the kernel's buffers; complete frames reach the pipeline thread
+     * through a lock-free queue, and an eventfd in `io_manager` wakes it up.
      */
     constexpr struct [[nodiscard]] basic_interceptor : pimpl_idiom<basic_interceptor> {
         using pimpl_idiom::pimpl_idiom;
@@ -34,6 +58,25 @@ export namespace fs8 {
             return basic_interceptor{qs...};
         }
 
+        /// Pipeline form: intercept[keyboard][intercept_mode::reader_thread]
+        consteval basic_interceptor operator[](intercept_mode const inp_mode) const noexcept {
+            auto result      = *this;
+            result.requested = inp_mode;
+            return result;
+        }
+
+        /// Takes effect on the next `start`.
+        constexpr void mode(intercept_mode const inp_mode) noexcept {
+            requested = inp_mode;
+        }
+
+        [[nodiscard]] constexpr intercept_mode mode() const noexcept {
+            return requested;
+        }
+
+        /// Safe to call from the pipeline thread while the reader is running.
+        [[nodiscard]] intercept_stats stats() const noexcept;
+
         /// Runtime additions
         void add(device_query const& q) noexcept; // udev-query based
         void add(owned_query const& q) noexcept;  // udev-query based
@@ -58,7 +101,8 @@ export namespace fs8 {
             return do_start(ctx.mod(input_manager), ctx.mod(io_manager));
         }
 
-        /// io_manager handler: drain a readable device fd into the pending queue.
+        /// io_manager handler: drain a readable device fd into the pending queue
+        /// (or clear the reader thread's doorbell).
         context_action operator()(io_fd const& fd) noexcept;
 
         /// next_event provider: reconcile watches, pop one event, else ignore_event.
@@ -86,6 +130,7 @@ export namespace fs8 {
 
         std::array<owned_query, 16>  owned_queries{}; // consteval-copyable part
         std::size_t                  queries_count = 0;
+        intercept_mode               requested     = intercept_mode::inline_reads;
         std::array<device_query, 16> query_cache{};   // span source for queries()
     } intercept;
 
@@ -3,62 +3,452 @@
 module;
 #include <algorithm>
 #include <cerrno>
+#include <chrono>
+#include <cstdint>
 #include <cstring>
+#include <ctime>
 #include <functional>
-#include <iterator>
+#include <limits>
+#include <optional>
+#include <span>
+#include <sys/epoll.h>
 #include <sys/poll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 #include <utility>
 #include <vector>
+#include "io/liburing.ixx"
 module fs8.mods;
 import fs8.log;
 
 using fs8::basic_io_manager;
 using fs8::context_action;
+using fs8::io_backend;
 using fs8::io_event;
 using fs8::io_fd;
+using fs8::timer_clock;
+
+namespace {
+
+    /// Submission queue size of the io_uring backend. One multishot poll per
+    /// watched fd stays armed in the kernel, so this only bounds how many
+    /// (re-)arms/removals can be queued between two `io_uring_enter` calls.
+    constexpr unsigned uring_entries = 64U;
+
+    /// How many ready fds/completions are reaped per wakeup before they're dispatched.
+    constexpr std::size_t batch_size = 64U;
+
+    /// user_data of the io_uring poll-removal requests; their completions are ignored.
+    constexpr std::uint64_t ignored_token = ~std::uint64_t{0};
+
+    /// Marks an fd that has no slot.
+    constexpr std::uint32_t no_slot = std::numeric_limits<std::uint32_t>::max();
+
+    /// The kernel-side id of a registration (epoll data / io_uring user_data):
+    /// its slot index and the generation of the slot, so events of a stale
+    /// registration (an fd that was unwatched, or re-watched with a different
+    /// handler/mask, maybe in the same batch) are never dispatched.
+    [[nodiscard]] constexpr std::uint64_t make_token(std::uint32_t const slot, std::uint32_t const gen) noexcept {
+        return (std::uint64_t{gen} << 32U) | slot;
+    }
+
+    [[nodiscard]] constexpr std::uint32_t token_slot(std::uint64_t const token) noexcept {
+        return static_cast<std::uint32_t>(token);
+    }
+
+    [[nodiscard]] constexpr std::uint32_t token_generation(std::uint64_t const token) noexcept {
+        return static_cast<std::uint32_t>(token >> 32U);
+    }
+
+} // namespace
 
 template <>
 struct fs8::pimpl_idiom<basic_io_manager>::impl {
+    // Registrations live in stable slots (parallel vectors). An unwatched slot
+    // keeps its place with `fd = -1`, which `::poll` ignores, and is reused by
+    // the next `watch`; so the slot index can be handed to the kernel as the
+    // handler id, and watch/unwatch never shift the other registrations.
     std::vector<pollfd>                                          fds;
     std::vector<std::function_ref<context_action(io_fd const&)>> callbacks;
+    std::vector<std::uint32_t>                                   generations;
+    std::vector<std::uint32_t>                                   free_slots;
+    std::vector<std::uint32_t>                                   slot_of_fd; // indexed by fd
+    std::size_t                                                  live            = 0;
+    std::uint32_t                                                last_generation = 0;
+    io_backend                                                   active          = io_backend::poll;
+
+    int                      epoll_fd = -1;
+    std::vector<epoll_event> ready_events; // reused for each epoll_wait
+
+#ifdef FS8_HAS_LIBURING
+    io_uring ring{};
+    bool     ring_ready  = false;
+    bool     ring_failed = false; // don't retry a kernel that has no io_uring
+
+    /// Reaped completions of the current wakeup.
+    struct completion {
+        std::uint64_t token;
+        int           res;
+        unsigned      flags;
+    };
+
+    std::vector<completion> reaped;
+#endif
+
+    /// The timers: a min-heap of deadlines behind one timerfd, armed for the
+    /// earliest of them.
+    int                                  timer_fd = -1;
+    std::vector<timer_clock::time_point> deadlines;
+
+    /// The io handler of `timer_fd`.
+    struct timer_wakeup {
+        impl* self;
+
+        context_action operator()(io_fd const&) const noexcept {
+            self->expire();
+            return context_action::next;
+        }
+    } on_timer{this};
+
+    impl() noexcept                  = default;
+    impl(impl const&)                = delete;
+    impl(impl&&) noexcept            = delete;
+    impl& operator=(impl const&)     = delete;
+    impl& operator=(impl&&) noexcept = delete;
+
+    ~impl() noexcept {
+        if (epoll_fd >= 0) {
+            ::close(epoll_fd);
+        }
+        if (timer_fd >= 0) {
+            ::close(timer_fd);
+        }
+#ifdef FS8_HAS_LIBURING
+        if (ring_ready) {
+            io_uring_queue_exit(&ring);
+        }
+#endif
+    }
+
+    /// The slot of a watched fd, or `no_slot`.
+    [[nodiscard]] std::uint32_t slot_of(int const fd) const noexcept {
+        if (fd < 0 || static_cast<std::size_t>(fd) >= slot_of_fd.size()) {
+            return no_slot;
+        }
+        return slot_of_fd[static_cast<std::size_t>(fd)];
+    }
+
+    [[nodiscard]] std::uint64_t token_of(std::uint32_t const slot) const noexcept {
+        return make_token(slot, generations[slot]);
+    }
+
+    /// Whether `token` still names a live registration.
+    [[nodiscard]] bool is_current(std::uint64_t const token) const noexcept {
+        auto const slot = token_slot(token);
+        return slot < fds.size() && fds[slot].fd >= 0 && generations[slot] == token_generation(token);
+    }
+
+    /// Claim a slot for `fd` (reusing an unwatched one if there is). Throws
+    /// only on allocation failure, leaving everything as it was.
+    [[nodiscard]] std::uint32_t claim(int const fd) {
+        if (static_cast<std::size_t>(fd) >= slot_of_fd.size()) {
+            slot_of_fd.resize(static_cast<std::size_t>(fd) + 1U, no_slot);
+        }
+        if (!free_slots.empty()) {
+            auto const slot = free_slots.back();
+            free_slots.pop_back();
+            return slot;
+        }
+        if (free_slots.capacity() <= fds.size()) {
+            // `release` must not throw, so make room for every slot up front.
+            free_slots.reserve(fds.size() * 2U + 1U);
+        }
+        fds.emplace_back(pollfd{-1, 0, 0});
+        try {
+            callbacks.emplace_back(noop_callback);
+            try {
+                generations.push_back(0);
+            } catch (...) {
+                callbacks.pop_back();
+                throw;
+            }
+        } catch (...) {
+            fds.pop_back();
+            throw;
+        }
+        return static_cast<std::uint32_t>(fds.size() - 1U);
+    }
+
+    /// Placeholder handler of unclaimed slots; never called.
+    static context_action noop_callback(io_fd const&) noexcept {
+        return context_action::next;
+    }
+
+    void release(std::uint32_t const slot) noexcept {
+        slot_of_fd[static_cast<std::size_t>(fds[slot].fd)] = no_slot;
+        fds[slot].fd                                       = -1;
+        fds[slot].revents                                  = 0;
+        ++generations[slot];
+        --live;
+        free_slots.push_back(slot); // room is reserved by `claim`
+    }
+
+    /// Switch to the requested backend, falling back to `poll` when the kernel
+    /// (or a seccomp/sysctl policy) doesn't let us use it.
+    void select(io_backend const requested) {
+        if (requested == active) {
+            return;
+        }
+
+        // Drop whatever the previous backend has armed in the kernel.
+        for (std::uint32_t slot = 0; slot < fds.size(); ++slot) {
+            if (fds[slot].fd >= 0) {
+                on_remove(slot);
+            }
+        }
+        flush();
+        active = io_backend::poll;
+
+        if (requested == io_backend::epoll) {
+            if (epoll_fd < 0) {
+                epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            }
+            if (epoll_fd < 0) [[unlikely]] {
+                log("io_manager: epoll is not available ({}), falling back to poll.", std::strerror(errno));
+                return;
+            }
+            ready_events.resize(batch_size);
+            active = io_backend::epoll;
+        } else if (requested == io_backend::uring) {
+#ifdef FS8_HAS_LIBURING
+            if (!ring_ready && !ring_failed) {
+                if (auto const res = io_uring_queue_init(uring_entries, &ring, 0); res < 0) [[unlikely]] {
+                    log("io_manager: io_uring is not available ({}), falling back to poll.", std::strerror(-res));
+                    ring_failed = true;
+                } else {
+                    ring_ready = true;
+                    reaped.reserve(batch_size);
+                }
+            }
+            if (!ring_ready) [[unlikely]] {
+                return;
+            }
+            active = io_backend::uring;
+#else
+            log("io_manager: built without io_uring support, falling back to poll.");
+            return;
+#endif
+        } else {
+            return;
+        }
+
+        // Registrations made under the previous backend have nothing armed yet.
+        for (std::uint32_t slot = 0; slot < fds.size(); ++slot) {
+            if (fds[slot].fd >= 0 && !on_add(slot)) [[unlikely]] {
+                log("io_manager: cannot watch fd {}: {}", fds[slot].fd, std::strerror(errno));
+            }
+        }
+        flush();
+    }
+
+#ifdef FS8_HAS_LIBURING
+    [[nodiscard]] io_uring_sqe* next_sqe() noexcept {
+        auto* sqe = io_uring_get_sqe(&ring);
+        if (sqe == nullptr) [[unlikely]] {
+            // The submission queue is full; flush it and try again.
+            io_uring_submit(&ring);
+            sqe = io_uring_get_sqe(&ring);
+        }
+        return sqe;
+    }
+
+    /// Arm a multishot poll for `slot`; it stays armed across wakeups until
+    /// it's removed, or the kernel terminates it.
+    void arm(std::uint32_t const slot) noexcept {
+        auto* const sqe = next_sqe();
+        if (sqe == nullptr) [[unlikely]] {
+            return;
+        }
+        io_uring_prep_poll_multishot(sqe, fds[slot].fd, static_cast<unsigned>(static_cast<unsigned short>(fds[slot].events)));
+#    ifdef IORING_POLL_ADD_LEVEL
+        // Level-triggered, like `::poll`: a handler that doesn't drain its fd
+        // gets called again on the next wakeup.
+        sqe->len |= IORING_POLL_ADD_LEVEL;
+#    endif
+        io_uring_sqe_set_data64(sqe, token_of(slot));
+    }
+
+    /// Cancel the armed request of `slot`.
+    void disarm(std::uint32_t const slot) noexcept {
+        auto* const sqe = next_sqe();
+        if (sqe == nullptr) [[unlikely]] {
+            return;
+        }
+        io_uring_prep_poll_remove(sqe, token_of(slot));
+        io_uring_sqe_set_data64(sqe, ignored_token);
+    }
+#endif
+
+    /// The registration at `slot` is about to go away (or be replaced).
+    void on_remove(std::uint32_t const slot) noexcept {
+        switch (active) {
+            case io_backend::epoll:
+                // Fails harmlessly when the fd was already closed (the kernel
+                // dropped it from the interest list then).
+                ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fds[slot].fd, nullptr);
+                break;
+            case io_backend::uring:
+#ifdef FS8_HAS_LIBURING
+                disarm(slot);
+#endif
+                break;
+            default: break;
+        }
+    }
+
+    /// The registration at `slot` is new (or replaced); returns false if the
+    /// backend refused it.
+    [[nodiscard]] bool on_add(std::uint32_t const slot) noexcept {
+        switch (active) {
+            case io_backend::epoll: {
+                epoll_event event{};
+                event.events   = static_cast<std::uint32_t>(static_cast<unsigned short>(fds[slot].events));
+                event.data.u64 = token_of(slot);
+                return ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[slot].fd, &event) == 0;
+            }
+            case io_backend::uring:
+#ifdef FS8_HAS_LIBURING
+                arm(slot);
+#endif
+                return true;
+            default: return true;
+        }
+    }
+
+    void flush() noexcept {
+#ifdef FS8_HAS_LIBURING
+        if (active == io_backend::uring) {
+            io_uring_submit(&ring);
+        }
+#endif
+    }
+
+    /// Arm `timer_fd` for the earliest deadline, or disarm it when there's none.
+    void rearm() const noexcept {
+        itimerspec spec{};
+        if (!deadlines.empty()) {
+            auto const since = std::chrono::duration_cast<std::chrono::nanoseconds>(deadlines.front().time_since_epoch());
+            auto const secs  = std::chrono::duration_cast<std::chrono::seconds>(since);
+            spec.it_value.tv_sec  = static_cast<std::time_t>(secs.count());
+            spec.it_value.tv_nsec = static_cast<long>((since - secs).count());
+            if (spec.it_value.tv_sec <= 0 && spec.it_value.tv_nsec == 0) [[unlikely]] {
+                spec.it_value.tv_nsec = 1; // all zeros would disarm it
+            }
+        }
+        ::timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    /// `timer_fd` went off: drop the deadlines that passed and arm for the next one.
+    void expire() noexcept {
+        std::uint64_t expirations = 0;
+        std::ignore               = ::read(timer_fd, &expirations, sizeof(expirations));
+        auto const now            = timer_clock::now();
+        while (!deadlines.empty() && deadlines.front() <= now) {
+            std::ranges::pop_heap(deadlines, std::ranges::greater{});
+            deadlines.pop_back();
+        }
+        rearm();
+    }
+
+    [[nodiscard]] context_action dispatch(std::uint32_t const slot, io_event const revents) noexcept {
+        // Copy the handler out: it may watch new fds, which can grow the vectors.
+        auto const callback = callbacks[slot];
+        return callback(io_fd{.fd = fds[slot].fd, .events = static_cast<io_event>(fds[slot].events), .revents = revents});
+    }
 };
 
 void basic_io_manager::clear() noexcept {
     if (pimpl.get() == nullptr) [[unlikely]] {
         return;
     }
+    for (std::uint32_t slot = 0; slot < pimpl->fds.size(); ++slot) {
+        if (pimpl->fds[slot].fd >= 0) {
+            pimpl->on_remove(slot);
+        }
+    }
+    pimpl->flush();
     pimpl->fds.clear();
     pimpl->callbacks.clear();
+    pimpl->generations.clear();
+    pimpl->free_slots.clear();
+    pimpl->slot_of_fd.clear();
+    pimpl->live = 0;
 }
 
 bool basic_io_manager::is_watched(int const fd) const noexcept {
     if (pimpl.get() == nullptr) [[unlikely]] {
         return false;
     }
-    return std::ranges::any_of(pimpl->fds, [fd](pollfd const& pfd) noexcept {
-        return pfd.fd == fd;
-    });
+    return pimpl->slot_of(fd) != no_slot;
 }
 
 bool basic_io_manager::empty() const noexcept {
-    return pimpl.get() == nullptr || pimpl->fds.empty();
+    return pimpl.get() == nullptr || pimpl->live == 0;
 }
 
 std::size_t basic_io_manager::size() const noexcept {
-    return pimpl.get() == nullptr ? 0 : pimpl->fds.size();
+    return pimpl.get() == nullptr ? 0 : pimpl->live;
+}
+
+io_backend basic_io_manager::active_backend() const noexcept {
+    return pimpl.get() == nullptr ? io_backend::poll : pimpl->active;
+}
+
+bool basic_io_manager::wake_at(timer_clock::time_point const deadline) noexcept try {
+    if (pimpl.get() == nullptr) {
+        init_impl();
+        pimpl->select(requested);
+    }
+    auto& self = *pimpl;
+    if (self.timer_fd < 0) {
+        self.timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (self.timer_fd < 0) [[unlikely]] {
+            log("io_manager: cannot create the timerfd: {}", std::strerror(errno));
+            return false;
+        }
+    }
+    // A restart drops every registration, the timerfd's too.
+    if (!is_watched(self.timer_fd) && !watch(io_fd{.fd = self.timer_fd, .events = io_event::in}, io_callback{self.on_timer})) [[unlikely]] {
+        return false;
+    }
+    self.deadlines.push_back(deadline);
+    std::ranges::push_heap(self.deadlines, std::ranges::greater{});
+    if (self.deadlines.front() == deadline) {
+        self.rearm();
+    }
+    return true;
+} catch (...) {
+    return false;
+}
+
+std::optional<timer_clock::time_point> basic_io_manager::next_deadline() const noexcept {
+    if (pimpl.get() == nullptr || pimpl->deadlines.empty()) {
+        return std::nullopt;
+    }
+    return pimpl->deadlines.front();
 }
 
 void basic_io_manager::unwatch(int const fd) noexcept {
     if (pimpl.get() == nullptr) [[unlikely]] {
         return;
     }
-    for (std::size_t i = 0; i < pimpl->fds.size(); ++i) {
-        if (pimpl->fds[i].fd == fd) {
-            pimpl->fds.erase(pimpl->fds.begin() + static_cast<std::ptrdiff_t>(i));
-            pimpl->callbacks.erase(pimpl->callbacks.begin() + static_cast<std::ptrdiff_t>(i));
-            return;
-        }
+    auto const slot = pimpl->slot_of(fd);
+    if (slot == no_slot) {
+        return;
     }
+    pimpl->on_remove(slot);
+    pimpl->flush();
+    pimpl->release(slot);
 }
 
 bool basic_io_manager::watch(io_fd const& fd, io_callback const& cb) noexcept try {
@@ -67,28 +457,30 @@ bool basic_io_manager::watch(io_fd const& fd, io_callback const& cb) noexcept tr
     }
     if (pimpl.get() == nullptr) {
         init_impl();
+        pimpl->select(requested);
     }
 
     // Re-registering an already-watched fd replaces it in place, so a pipeline
     // restart that re-watches the same fds won't accumulate duplicates.
-    for (std::size_t i = 0; i < pimpl->fds.size(); ++i) {
-        if (pimpl->fds[i].fd == fd.fd) {
-            pimpl->fds[i].events  = std::to_underlying(fd.events);
-            pimpl->fds[i].revents = 0;
-            pimpl->callbacks[i]   = cb;
-            return true;
-        }
+    auto slot = pimpl->slot_of(fd.fd);
+    if (slot != no_slot) {
+        pimpl->on_remove(slot);
+        ++pimpl->generations[slot];
+    } else {
+        slot                                               = pimpl->claim(fd.fd);
+        pimpl->slot_of_fd[static_cast<std::size_t>(fd.fd)] = slot;
+        pimpl->fds[slot].fd                                = fd.fd;
+        ++pimpl->live;
     }
-
-    // `push_back` only throws on allocation failure; each vector is kept
-    // consistent here and the outer function-try-block turns it into `false`.
-    pimpl->fds.emplace_back(pollfd{fd.fd, std::to_underlying(fd.events), 0});
-    try {
-        pimpl->callbacks.push_back(cb);
-    } catch (...) {
-        pimpl->fds.pop_back();
-        throw;
+    pimpl->fds[slot].events  = std::to_underlying(fd.events);
+    pimpl->fds[slot].revents = 0;
+    pimpl->callbacks[slot]   = cb;
+    if (!pimpl->on_add(slot)) [[unlikely]] {
+        log("io_manager: cannot watch fd {}: {}", fd.fd, std::strerror(errno));
+        pimpl->release(slot);
+        return false;
     }
+    pimpl->flush();
     return true;
 } catch (...) {
     return false;
@@ -102,52 +494,158 @@ context_action basic_io_manager::operator()(start_tag) noexcept try {
     if (pimpl.get() == nullptr) {
         init_impl();
     }
+    pimpl->select(requested);
+    // The deadlines of the previous run are of no use to the new one.
+    if (pimpl->timer_fd >= 0) {
+        pimpl->deadlines.clear();
+        pimpl->rearm();
+    }
     return next;
 } catch (...) {
     return context_action::exit;
 }
 
+namespace {
+
+    context_action poll_once(auto& self) noexcept {
+        using enum context_action;
+        int ready = 0;
+        do {
+            ready = ::poll(self.fds.data(), static_cast<nfds_t>(self.fds.size()), -1);
+        } while (ready < 0 && errno == EINTR);
+
+        if (ready < 0) [[unlikely]] {
+            fs8::log("io_manager: poll failed: {}", std::strerror(errno));
+            return exit;
+        }
+
+        // Slots are stable, so one forward pass is enough. Handlers are free to
+        // watch/unwatch: an unwatched slot has its `revents` cleared so it's
+        // skipped, and new/replaced registrations start with no `revents`.
+        auto action = next;
+        for (std::uint32_t slot = 0; slot < self.fds.size() && ready > 0; ++slot) {
+            if (self.fds[slot].revents == 0) {
+                continue;
+            }
+            --ready;
+            auto const revents     = static_cast<io_event>(self.fds[slot].revents);
+            self.fds[slot].revents = 0;
+            auto const result      = self.dispatch(slot, revents);
+            if (result == exit) [[unlikely]] {
+                return exit;
+            }
+            if (result == idle) [[unlikely]] {
+                action = idle;
+            }
+        }
+        return action;
+    }
+
+    context_action epoll_once(auto& self) noexcept {
+        using enum context_action;
+        int ready = 0;
+        do {
+            ready = ::epoll_wait(self.epoll_fd, self.ready_events.data(), static_cast<int>(self.ready_events.size()), -1);
+        } while (ready < 0 && errno == EINTR);
+
+        if (ready < 0) [[unlikely]] {
+            fs8::log("io_manager: epoll_wait failed: {}", std::strerror(errno));
+            return exit;
+        }
+
+        // Only the ready fds are visited; the slot comes straight from the
+        // event's data.
+        auto action = next;
+        for (auto const& event : std::span{self.ready_events.data(), static_cast<std::size_t>(ready)}) {
+            auto const token = event.data.u64;
+            if (!self.is_current(token)) {
+                continue; // unwatched/replaced by an earlier handler of this batch
+            }
+            auto const result = self.dispatch(token_slot(token), static_cast<io_event>(static_cast<short>(event.events)));
+            if (result == exit) [[unlikely]] {
+                return exit;
+            }
+            if (result == idle) [[unlikely]] {
+                action = idle;
+            }
+        }
+        return action;
+    }
+
+#ifdef FS8_HAS_LIBURING
+    context_action uring_once(auto& self) noexcept {
+        using enum context_action;
+
+        // A single io_uring_enter both flushes the pending (re-)arms/removals and
+        // waits for at least one completion.
+        int res = 0;
+        do {
+            res = io_uring_submit_and_wait(&self.ring, 1);
+        } while (res == -EINTR);
+        if (res < 0) [[unlikely]] {
+            fs8::log("io_manager: io_uring wait failed: {}", std::strerror(-res));
+            return exit;
+        }
+
+        // Reap everything that's ready in one go, and release the CQ ring
+        // before dispatching so the handlers are free to watch/unwatch.
+        self.reaped.clear();
+        unsigned      head  = 0;
+        unsigned      count = 0;
+        io_uring_cqe* cqe   = nullptr;
+        io_uring_for_each_cqe(&self.ring, head, cqe) {
+            if (cqe->user_data != ignored_token) {
+                if (self.reaped.size() == self.reaped.capacity()) [[unlikely]] {
+                    break; // the rest stays in the CQ ring for the next wakeup
+                }
+                self.reaped.push_back({.token = cqe->user_data, .res = cqe->res, .flags = cqe->flags});
+            }
+            ++count;
+        }
+        io_uring_cq_advance(&self.ring, count);
+
+        auto action = next;
+        for (auto const& [token, cqe_res, flags] : self.reaped) {
+            if (!self.is_current(token)) {
+                continue; // unwatched/replaced by an earlier handler of this batch
+            }
+            auto const slot = token_slot(token);
+            if ((flags & IORING_CQE_F_MORE) == 0U) {
+                // The kernel terminated the multishot request (e.g. on overflow);
+                // re-arm it, it gets submitted with the next wait.
+                self.arm(slot);
+            }
+            if (cqe_res == -ECANCELED) [[unlikely]] {
+                continue;
+            }
+            auto const revents = cqe_res < 0 ? io_event::err : static_cast<io_event>(static_cast<short>(cqe_res));
+            auto const result  = self.dispatch(slot, revents);
+            if (result == exit) [[unlikely]] {
+                return exit;
+            }
+            if (result == idle) [[unlikely]] {
+                action = idle;
+            }
+        }
+        return action;
+    }
+#endif
+
+} // namespace
+
 context_action basic_io_manager::operator()(load_event_tag) noexcept {
     using enum context_action;
     // Nothing watched is not fatal: the mods may not have re-registered their
     // fds yet after a restart, so fall through and let the pipeline re-poll.
-    if (pimpl.get() == nullptr || pimpl->fds.empty()) [[unlikely]] {
+    if (pimpl.get() == nullptr || pimpl->live == 0) [[unlikely]] {
         return next;
     }
 
-    int ready = 0;
-    do {
-        ready = ::poll(pimpl->fds.data(), static_cast<nfds_t>(pimpl->fds.size()), -1);
-    } while (ready < 0 && errno == EINTR);
-
-    if (ready < 0) [[unlikely]] {
-        log("io_manager: poll failed: {}", std::strerror(errno));
-        return exit;
-    }
-
-    // Dispatch the ready fds one at a time, re-scanning from the front on each
-    // iteration. There's no snapshot to allocate, and handlers are free to
-    // watch/unwatch: the fd this round is cleared before its handler runs, and
-    // `it` is never used again afterwards.
-    auto action = next;
-    while (true) {
-        auto const it = std::ranges::find_if(pimpl->fds, [](pollfd const& pfd) noexcept {
-            return pfd.revents != 0;
-        });
-        if (it == pimpl->fds.end()) [[unlikely]] {
-            break;
-        }
-        auto const fd      = it->fd;
-        auto const revents = static_cast<io_event>(it->revents);
-        it->revents        = 0;
-        auto const index   = static_cast<std::size_t>(std::distance(pimpl->fds.begin(), it));
-        auto const result  = pimpl->callbacks[index](io_fd{.fd = fd, .events = static_cast<io_event>(it->events), .revents = revents});
-        if (result == exit) [[unlikely]] {
-            return exit;
-        }
-        if (result == idle) [[unlikely]] {
-            action = idle;
-        }
+    switch (pimpl->active) {
+        case io_backend::epoll: return epoll_once(*pimpl);
+#ifdef FS8_HAS_LIBURING
+        case io_backend::uring: return uring_once(*pimpl);
+#endif
+        default: return poll_once(*pimpl);
     }
-    return action;
 }
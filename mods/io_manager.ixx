@@ -1,7 +1,10 @@
 // Created by moisrex on 8/8/26.
 
 module;
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <optional>
 #include <sys/poll.h>
 #include <type_traits>
 #include <utility>
@@ -48,6 +51,16 @@ export namespace fs8 {
         io_event revents = io_event::none; // filled by the manager before dispatching
     };
 
+    /// How `io_manager` waits for readiness.
+    enum struct [[nodiscard]] io_backend : std::uint8_t {
+        poll,  ///< one `::poll` over every watched fd per wakeup (default).
+        uring, ///< multishot polls kept armed in an io_uring, reaped in batches; falls back to `poll`.
+        epoll, ///< an epoll interest list; only the ready fds are visited; falls back to `poll`.
+    };
+
+    /// The clock of `io_manager`'s timers (`CLOCK_MONOTONIC`).
+    using timer_clock = std::chrono::steady_clock;
+
     template <typename T>
     concept io_handler = !Context<T> && std::is_nothrow_invocable_r_v<context_action, T&, io_fd const&>;
 
@@ -56,15 +69,48 @@ export namespace fs8 {
      * each ready file descriptor to its registered handler.
      * The handlers are bound by reference, so their lifetime must be as long as this
      * manager's (e.g. mods living in the same pipeline).
+     *
+     * It also keeps the pipeline's timers: `wake_at` makes the wait return by
+     * a deadline (all of them share one `timerfd`), and the pipeline then sends
+     * `timer_expired` to the mods, which check their own deadlines.
      */
     constexpr struct [[nodiscard]] basic_io_manager : pimpl_idiom<basic_io_manager> {
         using io_callback = std::function_ref<context_action(io_fd const&)>;
 
+        /// Pipeline form: io_manager[io_backend::uring]
+        consteval basic_io_manager operator[](io_backend const inp_backend) const noexcept {
+            auto result      = *this;
+            result.requested = inp_backend;
+            return result;
+        }
+
+        /// Change the requested backend at runtime; takes effect on the next `start`.
+        constexpr void backend(io_backend const inp_backend) noexcept {
+            requested = inp_backend;
+        }
+
+        /// The requested backend.
+        [[nodiscard]] constexpr io_backend backend() const noexcept {
+            return requested;
+        }
+
+        /// The backend actually in use; differs from `backend()` when the kernel
+        /// doesn't support the requested one and we fell back to `poll`.
+        [[nodiscard]] io_backend active_backend() const noexcept;
+
         template <io_handler HandlerT>
         [[nodiscard]] bool watch(io_fd const& fd, HandlerT& handler) noexcept {
             return watch(fd, io_callback{handler});
         }
 
+        /// Wake the pipeline up at `deadline` at the latest. Deadlines can't be
+        /// cancelled; one that's no longer needed only costs a spurious wakeup.
+        /// They are dropped on `start`. False when no timerfd is available.
+        [[nodiscard]] bool wake_at(timer_clock::time_point deadline) noexcept;
+
+        /// The earliest deadline that hasn't passed yet.
+        [[nodiscard]] std::optional<timer_clock::time_point> next_deadline() const noexcept;
+
         void                      unwatch(int fd) noexcept;
         void                      clear() noexcept;
         [[nodiscard]] bool        is_watched(int fd) const noexcept;
@@ -76,6 +122,8 @@ export namespace fs8 {
 
       private:
         [[nodiscard]] bool watch(io_fd const& fd, io_callback const& cb) noexcept;
+
+        io_backend requested = io_backend::poll;
     } io_manager;
 
 } // namespace fs8
@@ -0,0 +1,133 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+module fs8.mods;
+import fs8.pimpl;
+
+using fs8::basic_latency_recorder;
+using fs8::benchmark_stats;
+using fs8::trace_trigger;
+
+namespace {
+    struct device_latencies {
+        fs8::device_id  device;
+        std::string     name;
+        benchmark_stats kernel_to_read;
+        benchmark_stats kernel_to_out;
+    };
+
+    struct route_latencies {
+        void const*     route;
+        std::string     name;
+        benchmark_stats kernel_to_out;
+        benchmark_stats read_to_out;
+    };
+
+    [[nodiscard]] benchmark_stats::duration since(trace_trigger::time_point const from, trace_trigger::time_point const to) noexcept {
+        return std::chrono::duration_cast<benchmark_stats::duration>(to - from);
+    }
+} // namespace
+
+template <>
+struct fs8::pimpl_idiom<basic_latency_recorder>::impl {
+    // There's a handful of each, a linear search beats hashing here.
+    std::vector<device_latencies> devices;
+    std::vector<route_latencies>  routes;
+
+    device_latencies* device_of(device_id const device) noexcept try {
+        for (auto& entry : devices) {
+            if (entry.device == device) {
+                return &entry;
+            }
+        }
+        return &devices.emplace_back(device_latencies{.device = device, .name = std::string{to_string(device)}});
+    } catch (...) {
+        return nullptr;
+    }
+
+    route_latencies* route_of(void const* const route, std::string_view const route_name) noexcept try {
+        for (auto& entry : routes) {
+            if (entry.route == route) {
+                return &entry;
+            }
+        }
+        return &routes.emplace_back(route_latencies{.route = route, .name = std::string{route_name}});
+    } catch (...) {
+        return nullptr;
+    }
+};
+
+trace_trigger basic_latency_recorder::ingress(event_type const& event) noexcept {
+    if (pimpl.get() == nullptr) {
+        init_impl();
+    }
+    trace_trigger const trigger{
+      .recorder    = this,
+      .device      = event.source(),
+      .kernel_time = trace_trigger::time_point{std::chrono::duration_cast<trace_trigger::time_point::duration>(event.micro_time())},
+      .read_time   = std::chrono::system_clock::now(),
+    };
+    if (auto* const entry = pimpl->device_of(trigger.device); entry != nullptr) [[likely]] {
+        entry->kernel_to_read.record(since(trigger.kernel_time, trigger.read_time));
+    }
+    return trigger;
+}
+
+void basic_latency_recorder::egress(trace_trigger const& trigger, void const* const route, std::string_view const route_name) noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return;
+    }
+    auto const now = std::chrono::system_clock::now();
+    if (auto* const entry = pimpl->device_of(trigger.device); entry != nullptr) [[likely]] {
+        entry->kernel_to_out.record(since(trigger.kernel_time, now));
+    }
+    if (auto* const entry = pimpl->route_of(route, route_name); entry != nullptr) [[likely]] {
+        entry->kernel_to_out.record(since(trigger.kernel_time, now));
+        entry->read_to_out.record(since(trigger.read_time, now));
+    }
+}
+
+void basic_latency_recorder::for_each_device(std::function_ref<void(latency_entry const&, latency_entry const&)> const fn) const noexcept {
+    if (pimpl.get() == nullptr) {
+        return;
+    }
+    for (auto const& entry : pimpl->devices) {
+        fn(latency_entry{entry.name, entry.kernel_to_read}, latency_entry{entry.name, entry.kernel_to_out});
+    }
+}
+
+void basic_latency_recorder::for_each_route(std::function_ref<void(latency_entry const&, latency_entry const&)> const fn) const noexcept {
+    if (pimpl.get() == nullptr) {
+        return;
+    }
+    for (auto const& entry : pimpl->routes) {
+        fn(latency_entry{entry.name, entry.kernel_to_out}, latency_entry{entry.name, entry.read_to_out});
+    }
+}
+
+void basic_latency_recorder::clear() noexcept {
+    if (pimpl.get() != nullptr) {
+        pimpl->devices.clear();
+        pimpl->routes.clear();
+    }
+}
+
+void fs8::trace_egress(void const* const route, std::string_view const route_name) noexcept {
+    auto const* const trigger = basic_traced_event::instance();
+    if (trigger == nullptr) [[likely]] {
+        return;
+    }
+    trace_egress(*trigger, route, route_name);
+}
+
+void fs8::trace_egress(trace_trigger const& trigger, void const* const route, std::string_view const route_name) noexcept {
+    if (trigger.recorder == nullptr) [[unlikely]] {
+        return;
+    }
+    trigger.recorder->egress(trigger, route, route_name);
+}
@@ -0,0 +1,221 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+export module fs8.mods:latency_trace;
+import dynamic_scoping;
+import fs8.context;
+import fs8.pimpl;
+import fs8.traits;
+import :benchmark;
+
+namespace fs8 {
+    export struct basic_latency_recorder;
+
+    /// The event a traced pipeline is busy with; whatever leaves through an
+    /// output meanwhile, the events it `fork_emit`s included, is charged to it.
+    export struct [[nodiscard]] trace_trigger {
+        using time_point = std::chrono::system_clock::time_point;
+
+        basic_latency_recorder* recorder = nullptr;
+        device_id               device   = device_id::none;
+        time_point              kernel_time{}; // the `input_event::time` of it
+        time_point              read_time{};   // when the trace got hold of it
+    };
+
+    /// Where the outputs find the trigger of the events they're writing.
+    export constexpr struct [[nodiscard]] basic_traced_event : thread_binding<trace_trigger> {
+    } traced_event;
+
+    /// Whether a `latency_trace` is running on this thread.
+    export [[nodiscard]] inline bool is_tracing() noexcept {
+        return basic_traced_event::instance() != nullptr;
+    }
+
+    /// The outputs (`uinput`, `output`) call it for every event they write,
+    /// when `is_tracing()`; `route` identifies the output.
+    export void trace_egress(void const* route, std::string_view route_name) noexcept;
+
+    /// The same for an event the output held back: charged to `trigger`, the
+    /// event it was emitted for, once it's actually written.
+    export void trace_egress(trace_trigger const& trigger, void const* route, std::string_view route_name) noexcept;
+
+    /// A latency distribution: the `benchmark_stats` of it.
+    export struct [[nodiscard]] latency_entry {
+        std::string_view name;
+        benchmark_stats const& stats;
+    };
+
+    /**
+     * The latencies a `latency_trace` collected:
+     *   - per device: kernel -> read (the time the event waited to be read),
+     *     and kernel -> out (the whole trip);
+     *   - per route (the output device): kernel -> out, and read -> out (the
+     *     time spent in foresight).
+     * A new device or route costs an allocation the first time it shows up;
+     * recording never allocates after that.
+     */
+    export struct [[nodiscard]] basic_latency_recorder : pimpl_idiom<basic_latency_recorder> {
+        using pimpl_idiom::pimpl_idiom;
+
+        [[nodiscard]] trace_trigger ingress(event_type const& event) noexcept;
+        void                        egress(trace_trigger const& trigger, void const* route, std::string_view route_name) noexcept;
+
+        /// fn(latency_entry kernel_to_read, latency_entry kernel_to_out) for each device.
+        void for_each_device(std::function_ref<void(latency_entry const&, latency_entry const&)> fn) const noexcept;
+
+        /// fn(latency_entry kernel_to_out, latency_entry read_to_out) for each route.
+        void for_each_route(std::function_ref<void(latency_entry const&, latency_entry const&)> fn) const noexcept;
+
+        void clear() noexcept;
+    };
+
+    /**
+     * Opt-in end-to-end latency tracing: `latency_trace[context | ...]` stamps
+     * each event as it enters the wrapped pipeline, and the outputs inside it
+     * stamp what they write. See `basic_latency_recorder` for what's kept, and
+     * `latency_report` for printing it.
+     *
+     * The kernel time is `CLOCK_REALTIME`, which is what evdev uses unless told
+     * otherwise; it survives `foresight intercept | foresight ...` chains too.
+     * Events the mods write out on their own time (timers) are not traced,
+     * they have no trigger; the ones an output holds back are stamped when
+     * they're written, for the events they were emitted for.
+     */
+    export template <Modifier... Funcs>
+    struct [[nodiscard]] basic_latency_trace : consteval_copyable {
+        using consteval_copyable::consteval_copyable;
+        using mods_type = std::tuple<std::remove_cvref_t<Funcs>...>;
+
+      private:
+        mods_type              funcs{};
+        basic_latency_recorder recorder{};
+
+      public:
+        explicit constexpr basic_latency_trace(std::remove_cvref_t<Funcs>... inp_funcs) noexcept : funcs{inp_funcs...} {}
+
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx) noexcept {
+            auto          trigger = recorder.ingress(ctx.event());
+            dynamic_scope scope{traced_event, trigger};
+            return invoke_mods(ctx, funcs);
+        }
+
+        template <Context CtxT, Tag TagT>
+            requires(!std::same_as<std::remove_cvref_t<TagT>, load_event_tag>
+                  && !std::same_as<std::remove_cvref_t<TagT>, next_event_tag>)
+        context_action operator()(CtxT& ctx, TagT tag) noexcept {
+            return invoke_mods(ctx, funcs, tag);
+        }
+
+        template <Context CtxT, typename... Args>
+            requires(sizeof...(Args) >= 2)
+        context_action operator()(CtxT& ctx, Args const&... args) noexcept {
+            return invoke_mods(ctx, funcs, args...);
+        }
+
+        template <typename Self>
+        [[nodiscard]] constexpr decltype(auto) sub_mods(this Self&& self) noexcept {
+            return std::forward_like<Self>(self.funcs);
+        }
+
+        [[nodiscard]] basic_latency_recorder const& latencies() const noexcept {
+            return recorder;
+        }
+
+        void clear() noexcept {
+            recorder.clear();
+        }
+    };
+
+    export struct [[nodiscard]] basic_latency_trace_factory {
+        template <Context CtxT>
+        [[nodiscard]] consteval auto operator[](CtxT const& ctx) const noexcept {
+            return std::apply(
+              []<typename... ModT>(ModT const&... mods) constexpr noexcept {
+                  return basic_latency_trace<std::remove_cvref_t<ModT>...>{mods...};
+              },
+              ctx.get_mods());
+        }
+    };
+
+    namespace latency_detail {
+        template <typename ModT, typename FnT>
+        void for_each_trace(ModT& mod, FnT& fn) noexcept {
+            if constexpr (requires { mod.latencies(); }) {
+                fn(mod.latencies());
+            }
+            if constexpr (requires { mod.sub_mods(); }) {
+                std::apply(
+                  [&](auto&... sub) noexcept {
+                      (for_each_trace(sub, fn), ...);
+                  },
+                  mod.sub_mods());
+            }
+        }
+    } // namespace latency_detail
+
+    /// Report what the `latency_trace`s of the pipeline collected, a line per
+    /// device and per route, e.g. `on[keyup[KEY_F12], latency_report[sink]]`.
+    export template <typename SinkT>
+    struct [[nodiscard]] basic_latency_report : consteval_copyable {
+        using consteval_copyable::consteval_copyable;
+
+      private:
+        [[no_unique_address]] SinkT sink;
+
+      public:
+        explicit constexpr basic_latency_report(SinkT inp_sink) noexcept : sink{std::move(inp_sink)} {}
+
+        void operator()(Context auto& ctx) noexcept {
+            auto emit = [&](basic_latency_recorder const& recorder) noexcept {
+                recorder.for_each_device([&](latency_entry const& read, latency_entry const& out) noexcept {
+                    sink("latency of {}: events={} kernel->read p50={}us p99={}us kernel->out p50={}us p99={}us p99.9={}us max={}us",
+                         read.name,
+                         read.stats.calls,
+                         std::chrono::duration_cast<std::chrono::microseconds>(read.stats.percentile(50)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(read.stats.percentile(99)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(out.stats.percentile(50)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(out.stats.percentile(99)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(out.stats.percentile(99.9)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(out.stats.max).count());
+                });
+                recorder.for_each_route([&](latency_entry const& out, latency_entry const& inside) noexcept {
+                    sink("latency to {}: events={} kernel->out p50={}us p99={}us p99.9={}us read->out p50={}us p99={}us max={}us",
+                         out.name,
+                         out.stats.calls,
+                         std::chrono::duration_cast<std::chrono::microseconds>(out.stats.percentile(50)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(out.stats.percentile(99)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(out.stats.percentile(99.9)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(inside.stats.percentile(50)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(inside.stats.percentile(99)).count(),
+                         std::chrono::duration_cast<std::chrono::microseconds>(inside.stats.max).count());
+                });
+            };
+            std::apply(
+              [&](auto&... mod) noexcept {
+                  (latency_detail::for_each_trace(mod, emit), ...);
+              },
+              ctx.get_mods());
+        }
+    };
+
+    export struct [[nodiscard]] basic_latency_report_factory {
+        template <typename SinkT>
+        [[nodiscard]] consteval auto operator[](SinkT sink) const noexcept {
+            return basic_latency_report<std::remove_cvref_t<SinkT>>{std::move(sink)};
+        }
+    };
+
+    export constexpr basic_latency_trace_factory  latency_trace;
+    export constexpr basic_latency_report_factory latency_report;
+
+    static_assert(Modifier<basic_latency_trace<>>);
+
+} // namespace fs8
@@ -0,0 +1,146 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <linux/input-event-codes.h>
+#include <utility>
+export module fs8.mods:long_press;
+import fs8.context;
+import fs8.traits;
+import :io_manager;
+
+export namespace fs8 {
+
+    /**
+     * Turn a long press of a key/button into a click of another one, e.g. a
+     * long left click into a right click: `long_press[BTN_LEFT, BTN_RIGHT]`.
+     *
+     * Once `from` has been held for `.hold(dur)` (default 500ms) without the
+     * pointer moving more than `.tolerance(px)` on either axis, `from` is
+     * released, `to` is clicked, and the rest of the press is swallowed.
+     *
+     * With `io_manager` in the pipeline the deadline is armed as a timer, so it
+     * fires on time even if the user keeps perfectly still; without it, it's
+     * noticed on the next event that comes in.
+     */
+    constexpr struct [[nodiscard]] basic_long_press : consteval_copyable {
+        using consteval_copyable::consteval_copyable;
+        using code_type  = event_type::code_type;
+        using value_type = event_type::value_type;
+
+        static constexpr std::chrono::milliseconds default_hold{500};
+        static constexpr value_type                default_tolerance = 5;
+
+      private:
+        code_type                 from         = BTN_LEFT;
+        code_type                 to           = BTN_RIGHT;
+        std::chrono::microseconds hold_time    = default_hold;
+        value_type                tolerance_px = default_tolerance;
+
+        timer_clock::time_point deadline{};
+        value_type              dx    = 0;
+        value_type              dy    = 0;
+        bool                    armed = false; // `from` is down, and the deadline is ahead
+        bool                    fired = false; // swallow the rest of this press
+
+        template <Context CtxT>
+        context_action fire(CtxT& ctx) noexcept {
+            using enum context_action;
+            armed = false;
+            fired = true;
+            for (auto const& event : std::array{
+                   event_type{EV_KEY, from, 0},
+                   event_type{EV_SYN, SYN_REPORT, 0},
+                   event_type{EV_KEY, to, 1},
+                   event_type{EV_SYN, SYN_REPORT, 0},
+                   event_type{EV_KEY, to, 0},
+                   event_type{EV_SYN, SYN_REPORT, 0},
+                 })
+            {
+                if (auto const action = ctx.fork_emit(event); is_exiting(action)) [[unlikely]] {
+                    return action;
+                }
+            }
+            return next;
+        }
+
+        template <Context CtxT>
+        context_action fire_if_due(CtxT& ctx) noexcept {
+            if (armed && timer_clock::now() >= deadline) {
+                return fire(ctx);
+            }
+            return context_action::next;
+        }
+
+      public:
+        constexpr basic_long_press(code_type const inp_from, code_type const inp_to) noexcept : from{inp_from}, to{inp_to} {}
+
+        /// long_press[BTN_LEFT, BTN_RIGHT]
+        consteval basic_long_press operator[](code_type const inp_from, code_type const inp_to) const noexcept {
+            return basic_long_press{inp_from, inp_to};
+        }
+
+        /// How long `from` must be held (default 500ms).
+        template <typename DurT>
+        consteval basic_long_press hold(DurT const& dur) const noexcept {
+            auto result{*this};
+            result.hold_time = dur;
+            return result;
+        }
+
+        /// How far the pointer may travel, per axis, while held (default 5).
+        consteval basic_long_press tolerance(value_type const px) const noexcept {
+            auto result{*this};
+            result.tolerance_px = px;
+            return result;
+        }
+
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx, timer_tag) noexcept {
+            return fire_if_due(ctx);
+        }
+
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx) noexcept {
+            using enum context_action;
+            if (auto const action = fire_if_due(ctx); is_exiting(action)) [[unlikely]] {
+                return action;
+            }
+
+            auto const& event = ctx.event();
+            if (event.is(EV_KEY, from)) {
+                switch (event.value()) {
+                    case 1:
+                        armed    = true;
+                        fired    = false;
+                        dx       = 0;
+                        dy       = 0;
+                        deadline = timer_clock::now() + hold_time;
+                        if constexpr (requires { ctx.mod(io_manager); }) {
+                            std::ignore = ctx.mod(io_manager).wake_at(deadline);
+                        }
+                        return next;
+                    case 0: armed = false; return std::exchange(fired, false) ? ignore_event : next;
+                    default: return fired ? ignore_event : next;
+                }
+            }
+
+            if (armed && event.type() == EV_REL) {
+                switch (event.code()) {
+                    case REL_X: dx += event.value(); break;
+                    case REL_Y: dy += event.value(); break;
+                    default: break;
+                }
+                if (std::abs(dx) > tolerance_px || std::abs(dy) > tolerance_px) {
+                    armed = false; // it's a drag
+                }
+            }
+            return next;
+        }
+    } long_press{BTN_LEFT, BTN_RIGHT};
+
+    static_assert(Modifier<basic_long_press>);
+
+} // namespace fs8
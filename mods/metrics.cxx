@@ -0,0 +1,304 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+module fs8.mods;
+import fs8.event;
+import fs8.log;
+import fs8.metrics;
+import fs8.pimpl;
+
+using fs8::basic_metrics;
+using fs8::context_action;
+using fs8::device_id;
+
+namespace {
+    /// The `sanitizer_issue`s, as labels; `none` isn't an issue.
+    constexpr std::array<std::pair<fs8::sanitizer_issue, std::string_view>, 5> sanitizer_issues{{
+      {fs8::sanitizer_issue::adjacent_syn, "adjacent_syn"},
+      {fs8::sanitizer_issue::orphan_release, "orphan_release"},
+      {fs8::sanitizer_issue::late_syn, "late_syn"},
+      {fs8::sanitizer_issue::out_of_resolution, "out_of_resolution"},
+      {fs8::sanitizer_issue::big_jump, "big_jump"},
+    }};
+
+    /// Prometheus label values escape the backslash, the quote and the newline.
+    void append_label(std::string& out, std::string_view const value) {
+        for (char const chr : value) {
+            switch (chr) {
+                case '\\': out += R"(\\)"; break;
+                case '"': out += R"(\")"; break;
+                case '\n': out += R"(\n)"; break;
+                default: out += chr; break;
+            }
+        }
+    }
+
+    void append_header(std::string& out, std::string_view const name, std::string_view const type, std::string_view const help) {
+        std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+    }
+
+    /// `name{label="value"} number`
+    template <typename T>
+    void append_sample(std::string& out, std::string_view const name, std::string_view const label, std::string_view const value, T const number) {
+        out += name;
+        out += '{';
+        out += label;
+        out += "=\"";
+        append_label(out, value);
+        std::format_to(std::back_inserter(out), "\"}} {}\n", number);
+    }
+} // namespace
+
+template <>
+struct fs8::pimpl_idiom<basic_metrics>::impl {
+    using clock = std::chrono::steady_clock;
+
+    struct device_counts {
+        device_id     id       = device_id::none;
+        std::uint64_t events   = 0;
+        std::uint64_t reported = 0; // `events` at the last snapshot
+    };
+
+    std::vector<device_counts> devices;
+    std::size_t                last_device = 0; // the events mostly come in runs of the same device
+    clock::time_point          last_snapshot = clock::now();
+
+    basic_input_manager const* names = nullptr;
+    int                        fd    = -1;
+    std::string                path; // to unlink; empty for the abstract ones
+
+    impl() noexcept = default;
+
+    impl(impl const&)            = delete;
+    impl(impl&&)                 = delete;
+    impl& operator=(impl const&) = delete;
+    impl& operator=(impl&&)      = delete;
+
+    ~impl() noexcept {
+        if (fd != -1) {
+            ::close(fd);
+        }
+        if (!path.empty()) {
+            ::unlink(path.c_str());
+        }
+    }
+
+    [[nodiscard]] bool listen(std::string_view const inp_path) noexcept try {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (inp_path.empty() || inp_path.size() >= sizeof(addr.sun_path)) [[unlikely]] {
+            log("metrics: socket path '{}' is not usable.", inp_path);
+            return false;
+        }
+        bool const abstract = inp_path.front() == '@';
+        std::ranges::copy(inp_path, std::begin(addr.sun_path));
+        if (abstract) {
+            addr.sun_path[0] = '\0';
+        } else {
+            path = inp_path;
+            ::unlink(path.c_str()); // left behind by an earlier run
+        }
+        auto const len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + inp_path.size() + (abstract ? 0 : 1));
+
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd == -1) [[unlikely]] {
+            log("metrics: can't create a socket: {}", std::strerror(errno));
+            return false;
+        }
+        if (::bind(fd, reinterpret_cast<sockaddr const*>(&addr), len) == -1 || ::listen(fd, 8) == -1) [[unlikely]] {
+            log("metrics: can't listen on '{}': {}", inp_path, std::strerror(errno));
+            ::close(fd);
+            fd = -1;
+            path.clear();
+            return false;
+        }
+        return true;
+    } catch (...) {
+        return false;
+    }
+
+    [[nodiscard]] std::string name_of(device_id const id) const {
+        if (names != nullptr) {
+            if (auto sysname = names->sysname_of(id); !sysname.empty()) {
+                return sysname;
+            }
+        }
+        return std::string{to_string(id)};
+    }
+
+    void append_devices(std::string& out) {
+        auto const now     = clock::now();
+        auto const seconds = std::chrono::duration<double>(now - last_snapshot).count();
+        last_snapshot      = now;
+
+        append_header(out, "foresight_events_total", "counter", "Events read, by source device.");
+        for (auto const& dev : devices) {
+            append_sample(out, "foresight_events_total", "device", name_of(dev.id), dev.events);
+        }
+        append_header(out, "foresight_events_per_second", "gauge", "Events read per second since the last request, by source device.");
+        for (auto& dev : devices) {
+            double const rate = seconds > 0 ? static_cast<double>(dev.events - dev.reported) / seconds : 0.0;
+            append_sample(out, "foresight_events_per_second", "device", name_of(dev.id), rate);
+            dev.reported = dev.events;
+        }
+    }
+};
+
+namespace {
+    void append_dropped(std::string& out) {
+        // The names don't have template arguments, so a few mods may share one.
+        std::vector<std::pair<std::string_view, std::uint64_t>> mods;
+        for (auto const* counter = fs8::named_counter::first(); counter != nullptr; counter = counter->next) {
+            auto const it = std::ranges::find(mods, counter->name, &std::pair<std::string_view, std::uint64_t>::first);
+            if (it == mods.end()) {
+                mods.emplace_back(counter->name, counter->count.load());
+            } else {
+                it->second += counter->count.load();
+            }
+        }
+        append_header(out, "foresight_dropped_events_total", "counter", "Events a mod dropped, by mod.");
+        for (auto const& [name, count] : mods) {
+            append_sample(out, "foresight_dropped_events_total", "mod", name, count);
+        }
+    }
+
+    void append_sanitizer(std::string& out) {
+        append_header(out, "foresight_sanitizer_issues_total", "counter", "Issues the sanitizers found, by issue.");
+        for (auto const& [issue, name] : sanitizer_issues) {
+            append_sample(out, "foresight_sanitizer_issues_total", "issue", name, fs8::sanitizer_issue_count(issue));
+        }
+    }
+
+    void append_pipeline(std::string& out) {
+        if (!fs8::dynamic_context.bound()) {
+            return; // not from inside a running pipeline
+        }
+        fs8::intercept_stats total{};
+        for (fs8::basic_interceptor const& interceptor : fs8::dynamic_context.rmods(fs8::intercept)) {
+            auto const stats         = interceptor.stats();
+            total.queue_capacity    += stats.queue_capacity;
+            total.queued            += stats.queued;
+            total.high_water         = std::max(total.high_water, stats.high_water);
+            total.overflowed_frames += stats.overflowed_frames;
+            total.overflowed_events += stats.overflowed_events;
+            total.syn_dropped       += stats.syn_dropped;
+        }
+        append_header(out, "foresight_intercept_queue_depth", "gauge", "Events waiting in the intercept queues.");
+        std::format_to(std::back_inserter(out), "foresight_intercept_queue_depth {}\n", total.queued);
+        append_header(out, "foresight_intercept_queue_capacity", "gauge", "Events the intercept queues hold.");
+        std::format_to(std::back_inserter(out), "foresight_intercept_queue_capacity {}\n", total.queue_capacity);
+        append_header(out, "foresight_intercept_queue_high_water", "gauge", "Most events queued at once.");
+        std::format_to(std::back_inserter(out), "foresight_intercept_queue_high_water {}\n", total.high_water);
+        append_header(out, "foresight_intercept_overflowed_events_total", "counter", "Events dropped because the queue was full.");
+        std::format_to(std::back_inserter(out), "foresight_intercept_overflowed_events_total {}\n", total.overflowed_events);
+        append_header(out, "foresight_intercept_syn_dropped_total", "counter", "Kernel buffer overruns (SYN_DROPPED).");
+        std::format_to(std::back_inserter(out), "foresight_intercept_syn_dropped_total {}\n", total.syn_dropped);
+
+        append_header(out, "foresight_uinput_write_failures_total", "counter", "Events a uinput device failed to write, by device.");
+        for (fs8::basic_uinput const& dev : fs8::dynamic_context.rmods(fs8::uinput)) {
+            append_sample(out, "foresight_uinput_write_failures_total", "device", dev.devnode(), dev.write_failures());
+        }
+    }
+} // namespace
+
+context_action basic_metrics::start(basic_io_manager* const io, basic_input_manager const* const devices) noexcept {
+    using enum context_action;
+    if (pimpl.get() == nullptr) {
+        init_impl();
+    }
+    pimpl->names = devices;
+    if (io == nullptr) {
+        log("metrics: there's no io_manager to serve '{}' with; only counting.", path);
+        return next;
+    }
+    if (pimpl->fd == -1 && !pimpl->listen(path)) [[unlikely]] {
+        return next; // the pipeline works just as well without it
+    }
+    // `io_manager` clears all registrations on `start`, so this is on every start.
+    if (!io->watch(io_fd{.fd = pimpl->fd, .events = io_event::in}, *this)) [[unlikely]] {
+        log("metrics: can't watch the socket.");
+    }
+    return next;
+}
+
+void basic_metrics::count(device_id const id) noexcept try {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return;
+    }
+    auto& devices = pimpl->devices;
+    if (pimpl->last_device < devices.size() && devices[pimpl->last_device].id == id) [[likely]] {
+        ++devices[pimpl->last_device].events;
+        return;
+    }
+    auto const it      = std::ranges::find(devices, id, &impl::device_counts::id);
+    pimpl->last_device = static_cast<std::size_t>(it - devices.begin());
+    if (it == devices.end()) {
+        devices.push_back({.id = id, .events = 1});
+        return;
+    }
+    ++it->events;
+} catch (...) {
+    // Out of memory; a new device goes uncounted.
+}
+
+std::string basic_metrics::snapshot() noexcept try {
+    std::string out;
+    if (pimpl.get() != nullptr) {
+        pimpl->append_devices(out);
+    }
+    append_dropped(out);
+    append_sanitizer(out);
+    append_pipeline(out);
+    return out;
+} catch (...) {
+    return {};
+}
+
+context_action basic_metrics::operator()(io_fd const& fd) noexcept {
+    using enum context_action;
+    if (pimpl.get() == nullptr || fd.fd != pimpl->fd) [[unlikely]] {
+        return next;
+    }
+    for (;;) {
+        int const client = ::accept4(pimpl->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; // EAGAIN: that was everyone
+        }
+        auto const  text = snapshot();
+        auto const* data = text.data();
+        std::size_t left = text.size();
+        while (left > 0) {
+            // Fits the socket buffer; a reader that can't keep up gets it cut short.
+            auto const sent = ::send(client, data, left, MSG_NOSIGNAL);
+            if (sent <= 0) {
+                if (sent == -1 && errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            data += sent;
+            left -= static_cast<std::size_t>(sent);
+        }
+        ::close(client);
+    }
+    return next;
+}
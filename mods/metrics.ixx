@@ -0,0 +1,92 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <string>
+#include <string_view>
+export module fs8.mods:metrics;
+import fs8.context;
+import fs8.event;
+import fs8.pimpl;
+import :input_manager;
+import :io_manager;
+
+export namespace fs8 {
+
+    /**
+     * Live metrics over a local unix socket: connect to it, and it writes the
+     * counters out, in the Prometheus text format, and closes the connection:
+     *
+     *   socat - UNIX-CONNECT:/run/foresight-metrics.sock
+     *
+     * Served are:
+     *  - the events read and the events per second (since the last request),
+     *    by source device,
+     *  - the events each mod of the pipeline dropped (returned `false` or
+     *    `ignore_event` for),
+     *  - the issues the sanitizers found, by `sanitizer_issue`,
+     *  - the queue depth and the overflows of `intercept`,
+     *  - the events the uinput devices failed to write.
+     *
+     * Put it right after the event provider (`context | intercept[...] | metrics
+     * | ...`) so it sees every event; the mods find it there to count their
+     * drops, and a pipeline without it doesn't count them. The socket is
+     * served by `io_manager`; the counting itself is a few relaxed stores per
+     * event, cheap enough to leave on.
+     */
+    constexpr struct [[nodiscard]] basic_metrics : pimpl_idiom<basic_metrics> {
+        using pimpl_idiom::pimpl_idiom;
+
+        static constexpr std::string_view default_path = "/run/foresight-metrics.sock";
+
+        /// The pipeline counts the drops of its mods only when it has this one.
+        static constexpr bool reports_drops = true;
+
+        /// Where to listen; a leading '@' means the abstract namespace
+        /// (e.g. "@foresight-metrics"), which leaves no file behind.
+        consteval basic_metrics at(std::string_view const inp_path) const noexcept {
+            auto result{*this};
+            result.path = inp_path;
+            return result;
+        }
+
+        [[nodiscard]] constexpr std::string_view socket_path() const noexcept {
+            return path;
+        }
+
+        /// Listen on the socket, and have `io` serve it; `devices` names the
+        /// source devices, if given.
+        context_action start(basic_io_manager* io, basic_input_manager const* devices) noexcept;
+
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx, start_tag) noexcept {
+            basic_input_manager const* devices = nullptr;
+            if constexpr (requires { ctx.mod(input_manager); }) {
+                devices = &ctx.mod(input_manager);
+            }
+            if constexpr (requires { ctx.mod(io_manager); }) {
+                return start(&ctx.mod(io_manager), devices);
+            } else {
+                return start(nullptr, devices);
+            }
+        }
+
+        context_action operator()(event_type const& event) noexcept {
+            count(event.source());
+            return context_action::next;
+        }
+
+        /// io_manager handler: answer everyone waiting on the socket.
+        context_action operator()(io_fd const& fd) noexcept;
+
+        /// The metrics as the socket serves them; restarts the per-second rates.
+        [[nodiscard]] std::string snapshot() noexcept;
+
+      private:
+        void count(device_id id) noexcept;
+
+        std::string_view path = default_path;
+    } metrics;
+
+    static_assert(Modifier<basic_metrics>);
+
+} // namespace fs8
@@ -20,7 +20,10 @@ export import :input_manager;
 export import :intercept;
 export import :io_manager;
 export import :keys_status;
+export import :long_press;
 export import :lambda;
+export import :latency_trace;
+export import :metrics;
 export import :modes;
 export import :momentum;
 export import :mouse_status;
@@ -28,12 +31,14 @@ export import :mouse_to_scroll;
 export import :on;
 export import :quantifier;
 export import :record;
+export import :replay;
 export import :sanitizer;
 export import :replace;
 export import :router;
 export import :scale;
 export import :singleton;
 export import :smooth;
+export import :span_trace;
 export import :stopper;
 export import :timed_typed;
 export import :typed;
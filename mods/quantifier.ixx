@@ -59,7 +59,15 @@ export namespace fs8 {
             return basic_mice_quantifier{steps};
         }
 
+        static constexpr bool handles_frames = true;
+
         void operator()(event_type const& event) noexcept;
+
+        void operator()(event_frame const frame, frame_tag) noexcept {
+            for (auto const& event : frame) {
+                operator()(event);
+            }
+        }
     } mice_quantifier;
 
 
@@ -2,14 +2,27 @@
 
 module;
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
 #include <linux/input-event-codes.h>
 #include <span>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 module fs8.mods;
 import fs8.event;
 import fs8.context;
+import fs8.lib.recording;
+import fs8.log;
 import fs8.pimpl;
 
 using fs8::basic_record;
@@ -17,14 +30,151 @@ using fs8::context_action;
 using fs8::event_type;
 using fs8::user_event;
 
+namespace {
+    // Bumped for every dump asked for; each flight recorder dumps when it moves.
+    std::atomic<std::uint32_t> dump_requests{0}; // NOLINT(*-avoid-non-const-global-variables)
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "It's bumped from a signal handler.");
+
+    extern "C" void request_dump_on_signal(int) {
+        dump_requests.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// The events a flight recorder still keeps, out of the ones it holds.
+    [[nodiscard]] std::span<event_type const> latest(
+      std::span<event_type const>     events,
+      std::size_t const               capacity,
+      std::chrono::microseconds const window) noexcept {
+        if (events.size() > capacity) {
+            events = events.last(capacity);
+        }
+        if (window.count() != 0 && !events.empty()) {
+            auto const since = events.back().micro_time() - window;
+            auto const first = std::ranges::partition_point(events, [since](event_type const& event) noexcept {
+                return event.micro_time() < since;
+            });
+            events = {first, events.end()};
+        }
+        return events;
+    }
+
+    /// Write `events` to `dump_path` (or `/tmp/foresight-<pid>.fs8e`), replacing it.
+    bool write_dump(std::string_view const dump_path, std::span<event_type const> const events) noexcept try {
+        auto const target = dump_path.empty() ? std::format("/tmp/foresight-{}.fs8e", ::getpid()) : std::string{dump_path};
+        ::unlink(target.c_str());
+        fs8::recording_writer writer;
+        if (!writer.open(target)) [[unlikely]] {
+            fs8::log("record: can't write the dump '{}'.", target);
+            return false;
+        }
+        for (auto const& event : events) {
+            if (!writer.write(event)) [[unlikely]] {
+                fs8::log("record: the dump '{}' is cut short.", target);
+                return false;
+            }
+        }
+        fs8::log("record: dumped {} events to '{}'.", events.size(), target);
+        return true;
+    } catch (...) {
+        return false;
+    }
+} // namespace
+
+void fs8::request_record_dump() noexcept {
+    dump_requests.fetch_add(1, std::memory_order_relaxed);
+}
+
 template <>
 struct fs8::pimpl_idiom<basic_record>::impl {
-    std::vector<event_type> events;
+    std::vector<event_type> events;          // everything, or the flight recorder's ring
+    std::size_t             next     = 0;    // the ring's oldest event, where the next one goes
+    std::uint64_t           recorded = 0;    // events put in the ring since the start
+    recording_writer        file;
+    bool                    lost       = false; // logged once per file
+    std::uint32_t           dumps_seen = 0;     // `dump_requests` at the last dump
+
+    mutable std::vector<event_type> ordered;                          // the ring, oldest first, for `events()`
+    mutable std::uint64_t           ordered_at = ~std::uint64_t{0};   // `recorded` when it was ordered
+    std::vector<event_type>         snapshot;                         // what the dump thread writes
+    std::atomic<bool>               dumping{false};
+    std::jthread                    dumper; // last: joined before the snapshot goes
+
+    /// The ring, oldest first, into `out`.
+    void copy_ring(std::vector<event_type>& out) const {
+        auto const held = static_cast<std::ptrdiff_t>(std::min<std::uint64_t>(recorded, events.size()));
+        auto const pos  = static_cast<std::ptrdiff_t>(next);
+        out.clear();
+        if (held < static_cast<std::ptrdiff_t>(events.size())) {
+            out.insert(out.end(), events.begin(), events.begin() + held);
+            return;
+        }
+        out.insert(out.end(), events.begin() + pos, events.end());
+        out.insert(out.end(), events.begin(), events.begin() + pos);
+    }
 };
 
+context_action basic_record::operator()(start_tag) noexcept try {
+    if (ring_capacity != 0) {
+        if (pimpl.get() == nullptr) {
+            init_impl();
+        }
+        // The ring and the dump's snapshot are allocated once, here.
+        if (pimpl->events.size() != ring_capacity) {
+            pimpl->events.assign(ring_capacity, event_type{});
+            pimpl->next     = 0;
+            pimpl->recorded = 0;
+        }
+        pimpl->snapshot.reserve(ring_capacity);
+        pimpl->dumps_seen = dump_requests.load(std::memory_order_relaxed);
+        if (dump_signal != 0) {
+            std::ignore = std::signal(dump_signal, request_dump_on_signal);
+        }
+    }
+    if (path.empty() || (pimpl.get() != nullptr && pimpl->file.is_open())) {
+        return context_action::next; // a restart keeps appending to the same file
+    }
+    if (!open(path)) [[unlikely]] {
+        log("record: can't open the recording '{}'; recording in memory.", path);
+    }
+    return context_action::next;
+} catch (...) {
+    log("record: out of memory for the last {} events.", ring_capacity);
+    return context_action::next;
+}
+
+bool basic_record::open(std::string_view const inp_path) noexcept {
+    if (pimpl.get() == nullptr) {
+        init_impl();
+    }
+    pimpl->lost = false;
+    return pimpl->file.open(inp_path);
+}
+
+void basic_record::close() noexcept {
+    if (pimpl.get() != nullptr) {
+        pimpl->file.close();
+    }
+}
+
+std::uint64_t basic_record::file_size() const noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return 0;
+    }
+    return pimpl->file.size();
+}
+
 context_action basic_record::record_event(event_type const& event) noexcept {
-    if (sink != nullptr) [[unlikely]] {
+    if (pimpl.get() != nullptr && pimpl->file.is_open()) {
+        if (!pimpl->file.write(event) && !std::exchange(pimpl->lost, true)) [[unlikely]] {
+            log("record: the recording can't grow; the events from here on are lost.");
+        }
+    } else if (sink != nullptr) [[unlikely]] {
         sink->push_back(event);
+    } else if (ring_capacity != 0) {
+        if (pimpl.get() == nullptr) [[unlikely]] {
+            init_impl();
+        }
+        record_last(event);
     } else {
         if (pimpl.get() == nullptr) {
             init_impl();
@@ -34,6 +184,52 @@ context_action basic_record::record_event(event_type const& event) noexcept {
     return context_action::next;
 }
 
+void basic_record::record_last(event_type const& event) noexcept {
+    auto& ring = *pimpl;
+    if (ring.events.size() != ring_capacity) [[unlikely]] {
+        try {
+            ring.events.assign(ring_capacity, event_type{});
+        } catch (...) {
+            return;
+        }
+        ring.next     = 0;
+        ring.recorded = 0;
+    }
+    ring.events[ring.next] = event;
+    ring.next              = ring.next + 1 == ring_capacity ? 0 : ring.next + 1;
+    ++ring.recorded;
+
+    // A dump still being written takes the request at a later event.
+    auto const requests = dump_requests.load(std::memory_order_relaxed);
+    if (requests == ring.dumps_seen || ring.dumping.load(std::memory_order_acquire)) [[likely]] {
+        return;
+    }
+    ring.dumps_seen = requests;
+    try {
+        // One copy here; the file's written on a thread of its own.
+        ring.copy_ring(ring.snapshot);
+        auto const kept = latest(ring.snapshot, ring_capacity, ring_window);
+        ring.dumping.store(true, std::memory_order_relaxed);
+        ring.dumper = std::jthread{[target = dump_path, kept, &dumping = ring.dumping]() noexcept {
+            std::ignore = write_dump(target, kept);
+            dumping.store(false, std::memory_order_release);
+        }};
+    } catch (...) {
+        ring.dumping.store(false, std::memory_order_relaxed);
+        log("record: can't start the dump.");
+    }
+}
+
+bool basic_record::dump() const noexcept {
+    return write_dump(dump_path, events());
+}
+
+void basic_record::wait_for_dump() noexcept {
+    if (pimpl.get() != nullptr && pimpl->dumper.joinable()) {
+        pimpl->dumper.join();
+    }
+}
+
 std::span<event_type const> basic_record::events() const noexcept {
     if (sink != nullptr) [[unlikely]] {
         return {*sink};
@@ -41,6 +237,17 @@ std::span<event_type const> basic_record::events() const noexcept {
     if (pimpl.get() == nullptr) [[unlikely]] {
         return {};
     }
+    if (ring_capacity != 0) {
+        if (pimpl->ordered_at != pimpl->recorded) {
+            try {
+                pimpl->copy_ring(pimpl->ordered);
+            } catch (...) {
+                return {};
+            }
+            pimpl->ordered_at = pimpl->recorded;
+        }
+        return latest(pimpl->ordered, ring_capacity, ring_window);
+    }
     return pimpl->events;
 }
 
@@ -55,6 +262,11 @@ bool basic_record::empty() const noexcept {
 void basic_record::clear() noexcept {
     if (sink != nullptr) {
         sink->clear();
+    } else if (pimpl.get() != nullptr && ring_capacity != 0) {
+        pimpl->next     = 0;
+        pimpl->recorded = 0;
+        pimpl->ordered.clear();
+        pimpl->ordered_at = 0;
     } else if (pimpl.get() != nullptr) {
         pimpl->events.clear();
     }
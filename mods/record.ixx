@@ -2,10 +2,15 @@
 
 module;
 #include <algorithm>
+#include <chrono>
 #include <concepts>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <ranges>
 #include <span>
+#include <string_view>
 #include <vector>
 export module fs8.mods:record;
 import fs8.event;
@@ -14,6 +19,10 @@ import fs8.pimpl;
 
 namespace fs8 {
 
+    /// Have every flight recorder (`record.last(...)`) dump its events, at its
+    /// next event. Safe to call from a signal handler.
+    export void request_record_dump() noexcept;
+
     /**
      * Record whatever events pass through it, then examine them.
      *
@@ -22,6 +31,25 @@ namespace fs8 {
      * external buffer (e.g. a global used by a test) via `record[sink]`, which
      * is handy when the record sits inside `on[...]` where it cannot be reached
      * after the pipeline runs.
+     *
+     * With `record.to(path)` the events go to a recording file instead, see
+     * `recording_writer`; read it back with a `recording_reader`. Nothing's
+     * kept in memory then, and `events()` is empty.
+     *
+     * As a flight recorder, `record.last(100'000)` keeps only the latest
+     * events, and `record.last(30s)` only the ones of the last 30 seconds (of
+     * at most `default_ring_capacity`, or `.last(30s).last(count)`). The
+     * ring is allocated once, on start, and recording into it is a store, so
+     * it can stay on all day. It's written to `.dump_to(path)` (default
+     * `/tmp/foresight-<pid>.fs8e`, a recording file; see `replay.from(path)`)
+     * whenever a dump is asked for:
+     *  - the process gets `SIGUSR2` (see `.on_signal(sig)`),
+     *  - `dump_records` runs, e.g. `on[pressed[KEY_LEFTCTRL, KEY_F12], dump_records]`
+     *    or `event_sanitizer.diagnostics()[dump_records]`,
+     *  - or `request_record_dump()` is called.
+     * The ring is copied at the next event that's recorded, that event
+     * included, and the copy is written on a thread of its own (see
+     * `wait_for_dump()`); each dump replaces the last.
      */
     export constexpr struct [[nodiscard]] basic_record : pimpl_idiom<basic_record> {
         using pimpl_idiom::pimpl_idiom;
@@ -33,14 +61,77 @@ namespace fs8 {
             return basic_record{&inp_sink};
         }
 
+        /// Record into a memory-mapped file; it's created, or appended to if
+        /// it's a recording already.
+        consteval basic_record to(std::string_view const inp_path) const noexcept {
+            auto result{*this};
+            result.path = inp_path;
+            return result;
+        }
+
+        /// The ring's size for `last(duration)` alone.
+        static constexpr std::size_t default_ring_capacity = std::size_t{1} << 17U;
+
+        /// Keep only the latest `count` events.
+        consteval basic_record last(std::size_t const count) const noexcept {
+            auto result{*this};
+            result.ring_capacity = count;
+            return result;
+        }
+
+        /// Keep only the events of the last `dur`, going by their timestamps.
+        template <typename Rep, typename Period>
+        consteval basic_record last(std::chrono::duration<Rep, Period> const dur) const noexcept {
+            auto result{*this};
+            result.ring_window = std::chrono::duration_cast<std::chrono::microseconds>(dur);
+            if (result.ring_capacity == 0) {
+                result.ring_capacity = default_ring_capacity;
+            }
+            return result;
+        }
+
+        /// Where the flight recorder dumps to.
+        consteval basic_record dump_to(std::string_view const inp_path) const noexcept {
+            auto result{*this};
+            result.dump_path = inp_path;
+            return result;
+        }
+
+        /// The signal that asks for a dump (default `SIGUSR2`, as `span_trace`
+        /// has `SIGUSR1`); 0 for none.
+        consteval basic_record on_signal(int const inp_signal) const noexcept {
+            auto result{*this};
+            result.dump_signal = inp_signal;
+            return result;
+        }
+
+        /// Opens the file, or allocates the ring, if it's either.
+        context_action operator()(start_tag) noexcept;
+
         /// Pass-through pipeline mod: record the current event and continue.
         context_action operator()(Context auto& ctx) noexcept {
             return record_event(ctx.event());
         }
 
+        /// Start recording into a file at runtime, or switch to another one.
+        [[nodiscard]] bool open(std::string_view inp_path) noexcept;
+
+        /// Close the file, trimming what was allocated ahead; back to recording in memory.
+        void close() noexcept;
+
+        /// The events in the file, zero if it's not recording into one.
+        [[nodiscard]] std::uint64_t file_size() const noexcept;
+
+        /// Write `events()` to the dump file now, replacing it.
+        bool dump() const noexcept;
+
+        /// Wait until the flight recorder's dump that's being written, if any, is in the file.
+        void wait_for_dump() noexcept;
+
         // --- Examination --------------------------------------------------
 
-        /// Read-only view over the recorded events (external sink or internal buffer).
+        /// Read-only view over the recorded events (external sink or internal
+        /// buffer); the ones the flight recorder still keeps, oldest first.
         [[nodiscard]] std::span<event_type const> events() const noexcept;
 
         [[nodiscard]] std::size_t size() const noexcept;
@@ -104,10 +195,28 @@ namespace fs8 {
         explicit consteval basic_record(std::vector<event_type>* inp_sink) noexcept : sink{inp_sink} {}
 
         context_action record_event(event_type const& event) noexcept;
-
-        std::vector<event_type>* sink = nullptr; // null -> internal (pimpl) storage
+        void           record_last(event_type const& event) noexcept;
+
+        std::vector<event_type>*  sink          = nullptr; // null -> internal (pimpl) storage
+        std::string_view          path;                    // empty -> no file
+        std::size_t               ring_capacity = 0;       // 0 -> keep everything
+        std::chrono::microseconds ring_window{0};          // 0 -> no time limit
+        std::string_view          dump_path;               // empty -> /tmp/foresight-<pid>.fs8e
+        int                       dump_signal   = SIGUSR2;
     } record;
 
+    /// Ask the flight recorders for a dump; see `record.last(...)`. Usable
+    /// as an action (`on[..., dump_records]`) and as a sanitizer callback.
+    export constexpr struct [[nodiscard]] basic_dump_records {
+        void operator()() const noexcept {
+            request_record_dump();
+        }
+
+        void operator()(event_type const&) const noexcept {
+            request_record_dump();
+        }
+    } dump_records;
+
     static_assert(Modifier<basic_record>);
 
 } // namespace fs8
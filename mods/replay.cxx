@@ -0,0 +1,124 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+module fs8.mods;
+import fs8.event;
+import fs8.context;
+import fs8.lib.recording;
+import fs8.log;
+import fs8.pimpl;
+
+using fs8::basic_replay;
+using fs8::context_action;
+using fs8::event_type;
+using fs8::timer_clock;
+
+template <>
+struct fs8::pimpl_idiom<basic_replay>::impl {
+    // In memory:
+    std::span<event_type const> events;
+    std::size_t                 index = 0;
+
+    // Or in a file:
+    recording_reader          file;
+    recording_reader::cursor  at{};
+    std::optional<event_type> ahead; // read, not replayed yet
+
+    std::uint64_t replayed = 0;
+
+    // The pacing starts with the first event.
+    std::optional<std::chrono::microseconds> origin;
+    timer_clock::time_point                  started{};
+
+    void rewind() noexcept {
+        index    = 0;
+        at       = {};
+        ahead.reset();
+        replayed = 0;
+        origin.reset();
+    }
+};
+
+context_action basic_replay::operator()(start_tag) noexcept {
+    if (pimpl.get() == nullptr) {
+        init_impl();
+        if (source != nullptr) {
+            pimpl->events = *source;
+        }
+        if (!path.empty() && !pimpl->file.open(path)) [[unlikely]] {
+            log("replay: can't open the recording '{}'.", path);
+            return context_action::exit;
+        }
+    }
+    pimpl->rewind();
+    return context_action::next;
+}
+
+void basic_replay::load(std::span<event_type const> const events) noexcept {
+    if (pimpl.get() == nullptr) {
+        init_impl();
+    }
+    pimpl->file.close();
+    pimpl->events = events;
+    pimpl->rewind();
+}
+
+bool basic_replay::open(std::string_view const inp_path) noexcept {
+    if (pimpl.get() == nullptr) {
+        init_impl();
+    }
+    pimpl->events = {};
+    pimpl->rewind();
+    return pimpl->file.open(inp_path);
+}
+
+std::uint64_t basic_replay::replayed() const noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return 0;
+    }
+    return pimpl->replayed;
+}
+
+event_type const* basic_replay::peek() noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return nullptr; // never started
+    }
+    if (pimpl->file.is_open()) {
+        if (!pimpl->ahead) {
+            pimpl->ahead = pimpl->file.next(pimpl->at);
+        }
+        return pimpl->ahead ? &*pimpl->ahead : nullptr;
+    }
+    if (pimpl->index == pimpl->events.size()) {
+        return nullptr;
+    }
+    return &pimpl->events[pimpl->index];
+}
+
+void basic_replay::pop() noexcept {
+    if (pimpl->file.is_open()) {
+        pimpl->ahead.reset();
+    } else {
+        ++pimpl->index;
+    }
+    ++pimpl->replayed;
+}
+
+timer_clock::time_point basic_replay::due_at(event_type const& event) noexcept {
+    auto const time = event.micro_time();
+    if (!pimpl->origin) {
+        pimpl->origin  = time;
+        pimpl->started = timer_clock::now();
+    }
+    // An event from before the first one is due right away.
+    auto const since = std::chrono::duration<double, std::micro>{std::max(time - *pimpl->origin, std::chrono::microseconds{0})};
+    return pimpl->started + std::chrono::duration_cast<timer_clock::duration>(since / pace);
+}
@@ -0,0 +1,117 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+export module fs8.mods:replay;
+import fs8.context;
+import fs8.event;
+import fs8.pimpl;
+import :io_manager;
+
+export namespace fs8 {
+
+    /**
+     * Play recorded events back into the pipeline, in place of `intercept`:
+     *
+     *   context | replay.from("/tmp/typing.fs8e").real_time() | ... | uinput
+     *
+     * The events come from:
+     *  - a recording file (`replay.from(path)`, see `record.to(path)`), which
+     *    is mapped and read as it goes, not loaded,
+     *  - a buffer at a constant address (`replay[events]`, like `record[sink]`),
+     *  - or any span of events, given at runtime with `load(...)`, e.g. the
+     *    events of another pipeline's `record`.
+     *
+     * By default they go as fast as the pipeline takes them. With
+     * `.real_time()` they keep their recorded timing, and `.speed(2.0)` plays
+     * them twice as fast (`.speed(0.5)` half as fast). The pauses are
+     * `io_manager` timers when there's one in the pipeline, or sleeps
+     * otherwise. The events keep their recorded timestamps and sources.
+     *
+     * The pipeline exits once the last event is out; a restart replays from
+     * the beginning.
+     */
+    constexpr struct [[nodiscard]] basic_replay : pimpl_idiom<basic_replay> {
+        using pimpl_idiom::pimpl_idiom;
+
+        /// Replay the events of a buffer; it must live at a constant address.
+        consteval basic_replay operator[](std::vector<event_type> const& inp_events) const noexcept {
+            auto result{*this};
+            result.source = &inp_events;
+            return result;
+        }
+
+        /// Replay a recording file.
+        consteval basic_replay from(std::string_view const inp_path) const noexcept {
+            auto result{*this};
+            result.path = inp_path;
+            return result;
+        }
+
+        /// Keep the recorded timing.
+        consteval basic_replay real_time() const noexcept {
+            return speed(1.0);
+        }
+
+        /// Scale the recorded timing: 2.0 is twice as fast; 0 is as fast as possible.
+        consteval basic_replay speed(double const inp_speed) const noexcept {
+            auto result{*this};
+            result.pace = inp_speed;
+            return result;
+        }
+
+        /// Replay these events from now on, instead; they must outlive the replay.
+        void load(std::span<event_type const> events) noexcept;
+
+        /// Replay this recording file from now on, instead.
+        [[nodiscard]] bool open(std::string_view inp_path) noexcept;
+
+        /// The events replayed since the start.
+        [[nodiscard]] std::uint64_t replayed() const noexcept;
+
+        /// Back to the first event.
+        context_action operator()(start_tag) noexcept;
+
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx, next_event_tag) noexcept {
+            using enum context_action;
+            auto const* event = peek();
+            if (event == nullptr) [[unlikely]] {
+                return exit;
+            }
+            if (pace > 0) {
+                if (auto const due = due_at(*event); timer_clock::now() < due) {
+                    if constexpr (requires { ctx.mod(io_manager); }) {
+                        if (ctx.mod(io_manager).wake_at(due)) [[likely]] {
+                            return ignore_event; // back here when it's due
+                        }
+                    }
+                    std::this_thread::sleep_until(due);
+                }
+            }
+            ctx.event(*event);
+            pop();
+            return next;
+        }
+
+      private:
+        /// The next event, without moving past it; null at the end.
+        [[nodiscard]] event_type const* peek() noexcept;
+        void                            pop() noexcept;
+
+        /// When `event` is due, going by the first event's time and `pace`.
+        [[nodiscard]] timer_clock::time_point due_at(event_type const& event) noexcept;
+
+        std::vector<event_type> const* source = nullptr;
+        std::string_view               path;
+        double                         pace = 0; // 0 -> as fast as possible
+    } replay;
+
+    static_assert(Modifier<basic_replay>);
+
+} // namespace fs8
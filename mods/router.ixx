@@ -290,6 +290,16 @@ export namespace fs8 {
             return context_action::next;
         }
 
+        /// Let the routes write out what they're holding back.
+        template <Context CtxT>
+        void operator()(CtxT& ctx, flush_tag) noexcept {
+            std::apply(
+              [&](auto&... all_routes) {
+                  (static_cast<void>(invoke_mod(all_routes, ctx, flush_output)), ...);
+              },
+              routes);
+        }
+
         context_action operator()(Context auto& ctx) noexcept {
             auto const& event        = ctx.event();
             auto const  hashed_value = hash(static_cast<event_code>(event));
@@ -1,12 +1,20 @@
 // Created by moisrex on 8/21/26.
 
 module;
+#include <array>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <linux/input-event-codes.h>
 module fs8.mods;
 
 import fs8.event;
+import fs8.metrics;
+
+namespace {
+    // Indexed by sanitizer_issue; only the pipeline thread writes them.
+    std::array<fs8::metric_counter, 6> issue_counts; // NOLINT(*-avoid-non-const-global-variables)
+} // namespace
 
 namespace fs8 {
 
@@ -69,6 +77,17 @@ namespace fs8 {
         return {"<unknown>"};
     }
 
+    std::uint64_t sanitizer_issue_count(sanitizer_issue const issue) noexcept {
+        auto const index = static_cast<std::size_t>(issue);
+        return index < issue_counts.size() ? issue_counts[index].load() : 0;
+    }
+
+    void count_sanitizer_issue(sanitizer_issue const issue) noexcept {
+        if (auto const index = static_cast<std::size_t>(issue); index < issue_counts.size()) {
+            issue_counts[index].add();
+        }
+    }
+
     void event_sanitizer_state::ensure_initialized() noexcept {
         if (pimpl.get() == nullptr) {
             init_impl();
@@ -30,6 +30,12 @@ export namespace fs8 {
 
     [[nodiscard]] std::string_view to_string(sanitizer_issue issue) noexcept;
 
+    /// How many of the `issue` were found, by all the sanitizers of the process.
+    [[nodiscard]] std::uint64_t sanitizer_issue_count(sanitizer_issue issue) noexcept;
+
+    /// Counted for `sanitizer_issue_count`.
+    void count_sanitizer_issue(sanitizer_issue issue) noexcept;
+
     struct [[nodiscard]] event_sanitizer_state : pimpl_idiom<event_sanitizer_state> {
         using pimpl_idiom::pimpl_idiom;
 
@@ -226,6 +232,9 @@ export namespace fs8 {
 
         context_action operator()(event_type const& event) noexcept {
             auto const issue = state.check(event, cfg);
+            if (issue != sanitizer_issue::none) [[unlikely]] {
+                count_sanitizer_issue(issue);
+            }
             invoke_callback(event, issue);
             state.update(event);
             if (diagnostics_only) {
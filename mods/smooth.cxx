@@ -1,13 +1,30 @@
 module;
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <linux/input-event-codes.h>
+#include <optional>
+#include <utility>
 module fs8.mods;
 import fs8.pimpl;
 
 using fs8::basic_kalman_filter;
 using fs8::basic_lerp;
 using fs8::basic_low_pass_filter;
+using fs8::timer_clock;
+
+namespace {
+    using namespace std::chrono_literals; // NOLINT(*-using-namespace)
+
+    /// The frame interval a paced lerp assumes until it has measured one (a 125 Hz mouse).
+    constexpr timer_clock::duration default_frame_interval = 8ms;
+
+    /// Gaps between frames outside of this range are pauses or bursts, not the device's rate.
+    constexpr timer_clock::duration min_frame_interval = 1ms;
+    constexpr timer_clock::duration max_frame_interval = 50ms;
+} // namespace
 
 template <>
 struct fs8::pimpl_idiom<fs8::basic_lerp>::impl {
@@ -40,6 +57,75 @@ struct fs8::pimpl_idiom<fs8::basic_lerp>::impl {
         cur_x = 0;
         cur_y = 0;
     }
+
+    // Paced mode: the movement being spread over time, and how much of it went out.
+    std::int32_t            seg_x     = 0;
+    std::int32_t            seg_y     = 0;
+    std::int32_t            sent_x    = 0;
+    std::int32_t            sent_y    = 0;
+    std::int32_t            steps     = 0;
+    std::int32_t            next_step = 1;
+    timer_clock::time_point seg_start{};
+    timer_clock::time_point last_frame{};
+    timer_clock::duration   period{};
+    timer_clock::duration   interval = default_frame_interval;
+    timer_clock::time_point armed{}; // the last deadline handed to io_manager
+
+    void retarget(timer_clock::time_point const now, std::size_t const max_steps, std::uint32_t const refresh_hz) noexcept {
+        // Keep a running estimate of the device's frame interval.
+        if (auto const gap = now - std::exchange(last_frame, now); gap >= min_frame_interval && gap <= max_frame_interval) {
+            interval = (interval * 3 + gap) / 4;
+        }
+
+        // What's left of the previous frame rides along with this one.
+        seg_x  = seg_x - sent_x + cur_x;
+        seg_y  = seg_y - sent_y + cur_y;
+        sent_x = 0;
+        sent_y = 0;
+        reset();
+
+        auto const mag = std::max(std::abs(seg_x), std::abs(seg_y));
+        if (mag == 0) {
+            steps = 0;
+            return;
+        }
+        std::int64_t count = static_cast<std::int64_t>(max_steps);
+        if (refresh_hz != 0) {
+            count = static_cast<std::int64_t>(std::ceil(std::chrono::duration<double>(interval).count() * refresh_hz));
+        }
+        steps     = static_cast<std::int32_t>(std::clamp<std::int64_t>(count, 1, std::min<std::int64_t>(mag, static_cast<std::int64_t>(max_steps))));
+        next_step = 1;
+        seg_start = now;
+        period    = std::max(interval / steps, timer_clock::duration{1});
+    }
+
+    std::optional<std::pair<basic_lerp::value_type, basic_lerp::value_type>>
+    due_step(timer_clock::time_point const now, float (*const easing)(float)) noexcept {
+        if (next_step > steps || now < seg_start + (next_step - 1) * period) {
+            return std::nullopt;
+        }
+        // Step k is due at `seg_start + (k - 1) * period`; late ones are merged.
+        auto const elapsed = static_cast<std::int32_t>((now - seg_start) / period);
+        auto const step    = std::min(steps, elapsed + 1);
+        auto const t       = step == steps ? 1.f : easing(static_cast<float>(step) / static_cast<float>(steps));
+        auto const out_x   = static_cast<basic_lerp::value_type>(std::round(t * static_cast<float>(seg_x)));
+        auto const out_y   = static_cast<basic_lerp::value_type>(std::round(t * static_cast<float>(seg_y)));
+        std::pair const res{out_x - sent_x, out_y - sent_y};
+        sent_x    = out_x;
+        sent_y    = out_y;
+        next_step = step + 1;
+        if (res.first == 0 && res.second == 0) {
+            return std::nullopt;
+        }
+        return res;
+    }
+
+    [[nodiscard]] std::optional<timer_clock::time_point> next_step_at() const noexcept {
+        if (next_step > steps) {
+            return std::nullopt;
+        }
+        return seg_start + (next_step - 1) * period;
+    }
 };
 
 template <>
@@ -189,6 +275,40 @@ void basic_lerp::reset() noexcept {
     pimpl->reset();
 }
 
+void basic_lerp::retarget(timer_clock::time_point const now) noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        init_impl();
+    }
+    pimpl->retarget(now, max_steps, refresh_hz);
+}
+
+std::optional<std::pair<basic_lerp::value_type, basic_lerp::value_type>> basic_lerp::due_step(timer_clock::time_point const now) noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return std::nullopt;
+    }
+    return pimpl->due_step(now, easing);
+}
+
+std::optional<timer_clock::time_point> basic_lerp::next_step_at() const noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return std::nullopt;
+    }
+    return pimpl->next_step_at();
+}
+
+timer_clock::time_point basic_lerp::armed_deadline() const noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return {};
+    }
+    return pimpl->armed;
+}
+
+void basic_lerp::armed_deadline(timer_clock::time_point const at) noexcept {
+    if (pimpl.get() != nullptr) [[likely]] {
+        pimpl->armed = at;
+    }
+}
+
 // basic_low_pass_filter forwarding
 
 void basic_low_pass_filter::accumulate(std::uint16_t const code, value_type const value) noexcept {
@@ -4,11 +4,14 @@ module;
 #include <cstdint>
 #include <cstdlib>
 #include <linux/input-event-codes.h>
+#include <optional>
+#include <utility>
 export module fs8.mods:smooth;
 import fs8.event;
 import fs8.context;
 import fs8.easings;
 import fs8.pimpl;
+import :io_manager;
 
 export namespace fs8 {
 
@@ -24,11 +27,20 @@ export namespace fs8 {
      * (`max(|dx|, |dy|)`) and capped at `max_steps`. The `easing` function
      * shapes the curve (default `easeOutQuad`).
      *
+     * By default the steps go out all at once. `.paced()` spreads them over
+     * the time until the next frame is expected (the smoothed interval between
+     * frames), and `.paced(144)` emits one step per tick of a 144 Hz display
+     * instead, which is usually far fewer events. A frame that arrives before
+     * the previous one's steps are done takes over what's left of them. Pacing
+     * needs `io_manager` in the pipeline for its timers; without it the steps
+     * go out at once.
+     *
      * @par Example
      * @code
      *   ... | mouse_history | lerp | output
      *   ... | mouse_history | lerp[8] | output
      *   ... | mouse_history | lerp[8, fs8::easeInOutQuad<float>] | output
+     *   ... | io_manager | ... | mouse_history | lerp.paced(144) | output
      * @endcode
      *
      * Requires `mouse_history` placed before this mod in the pipeline.
@@ -38,15 +50,93 @@ export namespace fs8 {
 
         using value_type = event_type::value_type;
 
+        static constexpr bool handles_frames = true;
+
       private:
-        std::size_t max_steps  = 16;
-        float (*easing)(float) = easeOutQuad<float>;
+        std::size_t   max_steps  = 16;
+        float (*easing)(float)   = easeOutQuad<float>;
+        bool          pace       = false;
+        std::uint32_t refresh_hz = 0; // 0: pace by the interval between frames
 
         void                              accumulate(std::uint16_t code, value_type value) noexcept;
         bool                              take_frame() noexcept;
         std::pair<value_type, value_type> position() const noexcept;
         void                              reset() noexcept;
 
+        /// Paced mode: add the accumulated movement to what's left of the
+        /// previous frame's steps, and schedule them from `now`.
+        void retarget(timer_clock::time_point now) noexcept;
+
+        /// Paced mode: the movement of the steps that are due at `now`, merged.
+        std::optional<std::pair<value_type, value_type>> due_step(timer_clock::time_point now) noexcept;
+
+        /// Paced mode: when the next step is due, if there's one left.
+        std::optional<timer_clock::time_point> next_step_at() const noexcept;
+
+        /// Paced mode: the deadline the last timer was armed for; io_manager
+        /// keeps every deadline it's given, the same one twice included.
+        timer_clock::time_point armed_deadline() const noexcept;
+        void                    armed_deadline(timer_clock::time_point at) noexcept;
+
+        /// Hand the due step to `emit`, and arm a timer for the next one,
+        /// unless it's armed already.
+        template <Context CtxT, typename EmitT>
+        void emit_paced(CtxT& ctx, EmitT&& emit) noexcept {
+            if (auto const step = due_step(timer_clock::now())) {
+                emit(event_type{EV_REL, REL_X, step->first});
+                emit(event_type{EV_REL, REL_Y, step->second});
+                emit(syn());
+            }
+            if (auto const at = next_step_at(); at && *at != armed_deadline()) {
+                if (ctx.mod(io_manager).wake_at(*at)) [[likely]] {
+                    armed_deadline(*at);
+                }
+            }
+        }
+
+        /// Whether the steps of this frame are to be paced.
+        template <Context CtxT>
+        [[nodiscard]] constexpr bool paced_in([[maybe_unused]] CtxT& ctx) const noexcept {
+            if constexpr (requires { ctx.mod(io_manager); }) {
+                return pace;
+            } else {
+                return false;
+            }
+        }
+
+        /// Hand the steps of the accumulated movement to `emit`, each as
+        /// `REL_X`, `REL_Y` and `SYN`.
+        template <typename EmitT>
+        void emit_steps(EmitT&& emit) noexcept {
+            auto const [cur_x, cur_y] = position();
+            auto const mag            = std::max(std::abs(cur_x), std::abs(cur_y));
+            if (mag == 0) {
+                reset();
+                return;
+            }
+            std::int32_t const steps = std::min<std::int32_t>(mag, static_cast<std::int32_t>(max_steps));
+
+            value_type prev_x = 0;
+            value_type prev_y = 0;
+            for (std::int32_t step = 1; step <= steps; ++step) {
+                auto const t     = easing(static_cast<float>(step) / static_cast<float>(steps));
+                auto const out_x = static_cast<value_type>(std::round(t * static_cast<float>(cur_x)));
+                auto const out_y = static_cast<value_type>(std::round(t * static_cast<float>(cur_y)));
+                auto const rel_x = out_x - prev_x;
+                auto const rel_y = out_y - prev_y;
+                prev_x           = out_x;
+                prev_y           = out_y;
+                if (rel_x == 0 && rel_y == 0) {
+                    continue;
+                }
+                emit(event_type{EV_REL, REL_X, rel_x});
+                emit(event_type{EV_REL, REL_Y, rel_y});
+                emit(syn());
+            }
+
+            reset();
+        }
+
       public:
         constexpr explicit basic_lerp(std::size_t const inp_max_steps, float (*const inp_easing)(float)) noexcept
           : max_steps{std::max<std::size_t>(1, inp_max_steps)},
@@ -60,6 +150,15 @@ export namespace fs8 {
             return basic_lerp{inp_max_steps, inp_easing};
         }
 
+        /// Spread the steps over time: one per tick of `inp_refresh_hz`, or with
+        /// 0, up to `max_steps` of them over the interval between frames.
+        consteval basic_lerp paced(std::uint32_t const inp_refresh_hz = 0) const noexcept {
+            auto result{*this};
+            result.pace       = true;
+            result.refresh_hz = inp_refresh_hz;
+            return result;
+        }
+
         template <Context CtxT>
         context_action operator()(CtxT& ctx) noexcept {
             using enum context_action;
@@ -73,36 +172,64 @@ export namespace fs8 {
             if (!is_syn(event) || !take_frame()) {
                 return next;
             }
-
-            auto const [cur_x, cur_y] = position();
-            auto const mag            = std::max(std::abs(cur_x), std::abs(cur_y));
-            if (mag == 0) {
-                reset();
-                return next;
+            auto const fork = [&](event_type const& step) noexcept {
+                std::ignore = ctx.fork_emit(step);
+            };
+            if (paced_in(ctx)) {
+                retarget(timer_clock::now());
+                emit_paced(ctx, fork);
+            } else {
+                emit_steps(fork);
             }
-            std::int32_t const steps = std::min<std::int32_t>(mag, static_cast<std::int32_t>(max_steps));
+            return next;
+        }
 
-            value_type prev_x = 0;
-            value_type prev_y = 0;
-            for (std::int32_t step = 1; step <= steps; ++step) {
-                auto const t     = easing(static_cast<float>(step) / static_cast<float>(steps));
-                auto const out_x = static_cast<value_type>(std::round(t * static_cast<float>(cur_x)));
-                auto const out_y = static_cast<value_type>(std::round(t * static_cast<float>(cur_y)));
-                auto const rel_x = out_x - prev_x;
-                auto const rel_y = out_y - prev_y;
-                prev_x           = out_x;
-                prev_y           = out_y;
-                if (rel_x == 0 && rel_y == 0) {
-                    continue;
+        /// Frame form: the movement events leave the frame, and the steps take
+        /// their place right before its `SYN_REPORT` (only the first one when
+        /// paced).
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx, event_frame frame, frame_tag) noexcept {
+            using enum context_action;
+            for (auto const& event : frame) {
+                if (is_mouse_movement(event)) {
+                    accumulate(event.code(), event.value());
                 }
-                std::ignore = ctx.fork_emit(EV_REL, REL_X, rel_x);
-                std::ignore = ctx.fork_emit(EV_REL, REL_Y, rel_y);
-                std::ignore = ctx.fork_emit(syn());
             }
-
-            reset();
+            frame.erase_if([](event_type const& event) noexcept {
+                return is_mouse_movement(event);
+            });
+            if (!frame.ends_with_report() || !take_frame()) {
+                return next;
+            }
+            auto const add = [&](event_type const& step) noexcept {
+                std::ignore = frame.emit(step);
+            };
+            if (paced_in(ctx)) {
+                retarget(timer_clock::now());
+                emit_paced(ctx, add);
+            } else {
+                emit_steps(add);
+            }
             return next;
         }
+
+        /// A restart drops io_manager's deadlines; the next step needs a new timer.
+        template <Context CtxT>
+        context_action operator()([[maybe_unused]] CtxT& ctx, start_tag) noexcept {
+            armed_deadline({});
+            return context_action::next;
+        }
+
+        /// Paced mode: the steps that came due since the last one.
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx, timer_tag) noexcept {
+            if (paced_in(ctx)) {
+                emit_paced(ctx, [&](event_type const& step) noexcept {
+                    std::ignore = ctx.fork_emit(step);
+                });
+            }
+            return context_action::next;
+        }
     } lerp;
 
     /**
@@ -131,6 +258,8 @@ export namespace fs8 {
 
         using value_type = event_type::value_type;
 
+        static constexpr bool handles_frames = true;
+
         struct [[nodiscard]] smoothed {
             bool       emit = false;
             value_type x    = 0;
@@ -178,6 +307,35 @@ export namespace fs8 {
             event.reset_time();
             return next;
         }
+
+        /// Frame form: the movement events leave the frame, and the filtered
+        /// movement takes their place right before its `SYN_REPORT`.
+        context_action operator()(event_frame frame, frame_tag) noexcept {
+            using enum context_action;
+            for (auto const& event : frame) {
+                if (is_mouse_movement(event)) {
+                    accumulate(event.code(), event.value());
+                }
+            }
+            frame.erase_if([](event_type const& event) noexcept {
+                return is_mouse_movement(event);
+            });
+            if (!frame.ends_with_report()) {
+                return next;
+            }
+
+            auto const [cur_x, cur_y] = position();
+            auto const out            = filter_frame(cur_x, cur_y);
+            reset();
+            if (!out.emit) {
+                return next;
+            }
+
+            std::ignore = frame.emit(event_type{EV_REL, REL_X, out.x});
+            std::ignore = frame.emit(event_type{EV_REL, REL_Y, out.y});
+            frame.back().reset_time();
+            return next;
+        }
     } low_pass_filter;
 
     /**
@@ -209,6 +367,8 @@ export namespace fs8 {
 
         using value_type = event_type::value_type;
 
+        static constexpr bool handles_frames = true;
+
         struct [[nodiscard]] smoothed {
             bool       emit = false;
             value_type x    = 0;
@@ -259,6 +419,35 @@ export namespace fs8 {
             event.reset_time();
             return next;
         }
+
+        /// Frame form: the movement events leave the frame, and the filtered
+        /// movement takes their place right before its `SYN_REPORT`.
+        context_action operator()(event_frame frame, frame_tag) noexcept {
+            using enum context_action;
+            for (auto const& event : frame) {
+                if (is_mouse_movement(event)) {
+                    accumulate(event.code(), event.value());
+                }
+            }
+            frame.erase_if([](event_type const& event) noexcept {
+                return is_mouse_movement(event);
+            });
+            if (!frame.ends_with_report()) {
+                return next;
+            }
+
+            auto const [cur_x, cur_y] = position();
+            auto const out            = filter_frame(cur_x, cur_y);
+            reset();
+            if (!out.emit) {
+                return next;
+            }
+
+            std::ignore = frame.emit(event_type{EV_REL, REL_X, out.x});
+            std::ignore = frame.emit(event_type{EV_REL, REL_Y, out.y});
+            frame.back().reset_time();
+            return next;
+        }
     } kalman_filter;
 
 } // namespace fs8
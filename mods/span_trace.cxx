@@ -0,0 +1,159 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <format>
+#include <print>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+module fs8.mods;
+import fs8.log;
+import fs8.pimpl;
+import fs8.spans;
+
+using fs8::basic_span_recorder;
+using fs8::span_buffer;
+using fs8::span_record;
+
+namespace {
+    // Set from the signal handler, picked up by the pipeline thread.
+    std::atomic<bool> dump_requested{false}; // NOLINT(*-avoid-non-const-global-variables)
+
+    static_assert(std::atomic<bool>::is_always_lock_free, "It's set from a signal handler.");
+
+    extern "C" void request_dump(int) {
+        dump_requested.store(true, std::memory_order_relaxed);
+    }
+
+    /// The names are identifiers, but a lambda's may not be.
+    void write_escaped(std::FILE* file, std::string_view const name) {
+        for (char const chr : name) {
+            if (chr == '"' || chr == '\\') {
+                std::fputc('\\', file);
+            }
+            std::fputc(chr, file);
+        }
+    }
+
+    [[nodiscard]] bool write_spans(std::string const& path, pid_t const tid, span_buffer const& spans) noexcept try {
+        std::FILE* const file = std::fopen(path.c_str(), "w");
+        if (file == nullptr) [[unlikely]] {
+            log("span_trace: can't write '{}'.", path);
+            return false;
+        }
+        auto const pid   = ::getpid();
+        bool       first = true;
+        std::fputs("{\"traceEvents\":[", file);
+        spans.for_each([&](span_record const& span) {
+            std::fputs(first ? "\n" : ",\n", file);
+            first = false;
+            std::fputs(R"({"name":")", file);
+            write_escaped(file, span.name);
+            std::print(file,
+                       R"(","cat":"mod","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{}}})",
+                       static_cast<double>(span.begin) / 1000.0,
+                       static_cast<double>(span.end - span.begin) / 1000.0,
+                       pid,
+                       tid);
+        });
+        std::fputs("\n],\"displayTimeUnit\":\"ns\"}\n", file);
+        bool const ok = std::ferror(file) == 0;
+        std::fclose(file);
+        if (ok) {
+            log("span_trace: wrote {} spans to '{}'.", spans.size(), path);
+        }
+        return ok;
+    } catch (...) {
+        return false;
+    }
+} // namespace
+
+template <>
+struct fs8::pimpl_idiom<basic_span_recorder>::impl {
+    span_buffer       spans;
+    span_buffer       snapshot; // what the writer thread writes
+    std::string       path;
+    pid_t             tid = 0;
+    std::atomic<bool> writing{false};
+    std::jthread      writer; // last: joined before the snapshot goes
+
+    impl() noexcept = default;
+
+    impl(impl const&)            = delete;
+    impl(impl&&)                 = delete;
+    impl& operator=(impl const&) = delete;
+    impl& operator=(impl&&)      = delete;
+
+    ~impl() noexcept {
+        wait_for_writer();
+        if (spans.size() != 0) {
+            std::ignore = write_spans(path, tid, spans);
+        }
+    }
+
+    void wait_for_writer() noexcept {
+        if (writer.joinable()) {
+            writer.join();
+        }
+    }
+
+    /// Copy the ring, and have it written on a thread of its own.
+    void write_async() noexcept try {
+        snapshot = spans; // the same size as the ring, so it doesn't allocate
+        writing.store(true, std::memory_order_relaxed);
+        writer = std::jthread{[this]() noexcept {
+            std::ignore = write_spans(path, tid, snapshot);
+            writing.store(false, std::memory_order_release);
+        }};
+    } catch (...) {
+        writing.store(false, std::memory_order_relaxed);
+        log("span_trace: can't start the dump.");
+    }
+};
+
+void basic_span_recorder::start(std::size_t const capacity, std::string_view const path, int const signal) noexcept try {
+    if (pimpl.get() == nullptr) {
+        init_impl();
+    }
+    pimpl->wait_for_writer();
+    if (pimpl->spans.size() == 0) {
+        pimpl->spans.reserve(capacity);
+        pimpl->snapshot.reserve(capacity);
+    }
+    pimpl->path = path.empty() ? std::format("/tmp/foresight-{}.trace.json", ::getpid()) : std::string{path};
+    pimpl->tid  = ::gettid();
+    if (signal != 0) {
+        std::ignore = std::signal(signal, request_dump);
+    }
+} catch (...) {
+    log("span_trace: out of memory, nothing is traced.");
+}
+
+span_buffer* basic_span_recorder::active() noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return nullptr;
+    }
+    // A dump still being written takes the request at a later event.
+    if (dump_requested.load(std::memory_order_relaxed) && !pimpl->writing.load(std::memory_order_acquire)) [[unlikely]] {
+        dump_requested.store(false, std::memory_order_relaxed);
+        pimpl->wait_for_writer(); // it's done, this only reaps it
+        pimpl->write_async();
+    }
+    return &pimpl->spans;
+}
+
+bool basic_span_recorder::dump() const noexcept {
+    return pimpl.get() != nullptr && write_spans(pimpl->path, pimpl->tid, pimpl->spans);
+}
+
+void basic_span_recorder::clear() noexcept {
+    if (pimpl.get() != nullptr) {
+        pimpl->spans.clear();
+    }
+}
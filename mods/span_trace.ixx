@@ -0,0 +1,165 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <csignal>
+#include <cstddef>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+export module fs8.mods:span_trace;
+import dynamic_scoping;
+import fs8.context;
+import fs8.log;
+import fs8.pimpl;
+import fs8.spans;
+import fs8.traits;
+
+export namespace fs8 {
+
+    /// Owns the span ring of a `span_trace`, and writes it out as a Chrome
+    /// trace (the JSON Perfetto and `chrome://tracing` open).
+    struct [[nodiscard]] basic_span_recorder : pimpl_idiom<basic_span_recorder> {
+        using pimpl_idiom::pimpl_idiom;
+
+        /// Allocate the ring, and have `signal` (if not 0) ask for a dump.
+        /// The ring is written to `path` on exit too; an empty `path` means
+        /// `/tmp/foresight-<pid>.trace.json`.
+        void start(std::size_t capacity, std::string_view path, int signal) noexcept;
+
+        /// The ring to record into, nullptr if it's not started; if a signal
+        /// asked for a dump, copies the ring first and has a thread write it.
+        [[nodiscard]] span_buffer* active() noexcept;
+
+        /// Write the spans out now; false if the file couldn't be written.
+        bool dump() const noexcept;
+
+        void clear() noexcept;
+    };
+
+    /**
+     * Per-mod tracing spans: `span_trace[context | ...]` times each mod
+     * invocation inside it, nested ones included (`on[...]`, `modes`, the
+     * `router`'s routes, and the mods a `fork_emit` runs through again), into
+     * a ring of the latest spans.
+     *
+     * Send the process `SIGUSR1` (see `.on_signal(sig)`) to have it copied at
+     * the next event and written, off the event thread, to `.to(path)` as a
+     * Chrome trace; it's written on exit too. Open it in https://ui.perfetto.dev.
+     *
+     * The timing is compiled in only with the `FORESIGHT_TRACE_SPANS` CMake
+     * option; without it, this is a plain sub-pipeline.
+     */
+    template <Modifier... Funcs>
+    struct [[nodiscard]] basic_span_trace : consteval_copyable {
+        using consteval_copyable::consteval_copyable;
+        using mods_type = std::tuple<std::remove_cvref_t<Funcs>...>;
+
+      private:
+        mods_type           funcs{};
+        basic_span_recorder recorder{};
+        std::string_view    path{};
+        std::size_t         ring_capacity = span_buffer::default_capacity;
+        int                 dump_signal   = SIGUSR1;
+
+        void begin() noexcept {
+            if constexpr (spans_enabled) {
+                recorder.start(ring_capacity, path, dump_signal);
+            } else {
+                log("span_trace: built without FORESIGHT_TRACE_SPANS, nothing is traced.");
+            }
+        }
+
+        template <Context CtxT, typename... Args>
+        context_action traced(CtxT& ctx, Args const&... args) noexcept {
+            if constexpr (spans_enabled) {
+                dynamic_scope scope{span_target, recorder.active()};
+                return invoke_mods(ctx, funcs, args...);
+            } else {
+                return invoke_mods(ctx, funcs, args...);
+            }
+        }
+
+      public:
+        explicit constexpr basic_span_trace(std::remove_cvref_t<Funcs>... inp_funcs) noexcept : funcs{inp_funcs...} {}
+
+        /// Where the trace is written.
+        consteval basic_span_trace to(std::string_view const inp_path) const noexcept {
+            auto result{*this};
+            result.path = inp_path;
+            return result;
+        }
+
+        /// How many of the latest spans are kept (default 65536).
+        consteval basic_span_trace capacity(std::size_t const inp_capacity) const noexcept {
+            auto result{*this};
+            result.ring_capacity = inp_capacity;
+            return result;
+        }
+
+        /// The signal that asks for a dump (default `SIGUSR1`); 0 for none.
+        consteval basic_span_trace on_signal(int const inp_signal) const noexcept {
+            auto result{*this};
+            result.dump_signal = inp_signal;
+            return result;
+        }
+
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx, start_tag) noexcept {
+            begin();
+            return traced(ctx, start);
+        }
+
+        template <Context CtxT>
+        context_action operator()(CtxT& ctx) noexcept {
+            return traced(ctx);
+        }
+
+        template <Context CtxT, Tag TagT>
+            requires(!std::same_as<std::remove_cvref_t<TagT>, load_event_tag>
+                  && !std::same_as<std::remove_cvref_t<TagT>, next_event_tag>
+                  && !std::same_as<std::remove_cvref_t<TagT>, start_tag>)
+        context_action operator()(CtxT& ctx, TagT tag) noexcept {
+            return traced(ctx, tag);
+        }
+
+        template <Context CtxT, typename... Args>
+            requires(sizeof...(Args) >= 2)
+        context_action operator()(CtxT& ctx, Args const&... args) noexcept {
+            if constexpr ((std::same_as<Args, start_tag> || ...)) {
+                begin(); // e.g. a route of a router
+            }
+            return traced(ctx, args...);
+        }
+
+        template <typename Self>
+        [[nodiscard]] constexpr decltype(auto) sub_mods(this Self&& self) noexcept {
+            return std::forward_like<Self>(self.funcs);
+        }
+
+        /// Write the trace out now.
+        bool dump() const noexcept {
+            return recorder.dump();
+        }
+
+        void clear() noexcept {
+            recorder.clear();
+        }
+    };
+
+    struct [[nodiscard]] basic_span_trace_factory {
+        template <Context CtxT>
+        [[nodiscard]] consteval auto operator[](CtxT const& ctx) const noexcept {
+            return std::apply(
+              []<typename... ModT>(ModT const&... mods) constexpr noexcept {
+                  return basic_span_trace<std::remove_cvref_t<ModT>...>{mods...};
+              },
+              ctx.get_mods());
+        }
+    };
+
+    constexpr basic_span_trace_factory span_trace;
+
+    static_assert(Modifier<basic_span_trace<>>);
+
+} // namespace fs8
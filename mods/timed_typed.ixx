@@ -7,7 +7,6 @@ module;
 #include <string_view>
 export module fs8.mods:timed_typed;
 import fs8.context;
-import fs8.lib.xkb;
 import fs8.pimpl;
 import :typed;
 
@@ -18,6 +17,8 @@ namespace fs8 {
      * if the user pauses longer than `duration` between two characters of the pattern,
      * the partial match is discarded, so a pattern spread over a long period of time
      * will never fire.
+     *
+     * Like `typed`, it checks the shared scan of the `search_engine`.
      */
     export constexpr struct [[nodiscard]] basic_timed_typed : pimpl_idiom<basic_timed_typed> {
         using pimpl_idiom::pimpl_idiom;
@@ -27,15 +28,14 @@ namespace fs8 {
         static constexpr duration_type default_duration   = std::chrono::milliseconds(2000);
 
       private:
-        std::string_view pattern;          // pattern string
+        std::string_view pattern; // pattern string
         duration_type    duration{default_duration};
-        xkb::basic_state keyboard_state{}; // the state of the modifier keys and what not
 
         /// Register the pattern into the search engine
         context_action on_start(basic_search_engine& engine) noexcept;
 
-        /// Process and search with a time window
-        [[nodiscard]] bool on_search(event_type const& event, basic_search_engine const& engine) noexcept;
+        /// Check the engine's scan of this event, with the time window
+        [[nodiscard]] bool on_search(basic_search_engine const& engine) const noexcept;
 
       public:
         explicit consteval basic_timed_typed(std::string_view const inp_pattern) noexcept : pattern{inp_pattern} {}
@@ -57,14 +57,13 @@ namespace fs8 {
 
         /// Register the pattern into the search engine
         context_action operator()(Context auto& ctx, start_tag) noexcept {
-            keyboard_state.initialize(xkb::get_default_keymap());
             return on_start(ctx.mod(search_engine));
         }
 
         template <Context CtxT>
-        [[nodiscard]] bool operator()(CtxT& ctx) noexcept {
+        [[nodiscard]] bool operator()(CtxT& ctx) const noexcept {
             static_assert(has_mod<basic_search_engine, CtxT>, "You need to have 'search_engine' in your pipeline.");
-            return on_search(ctx.event(), ctx.mod(search_engine));
+            return on_search(ctx.mod(search_engine));
         }
     } timed_typed;
 
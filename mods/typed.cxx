@@ -1,27 +1,43 @@
 // Created by moisrex on 10/28/25.
 
 module;
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
 #include <chrono>
-#include <climits>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <functional>
+#include <limits>
 #include <linux/input-event-codes.h>
-#include <queue>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 module fs8.mods;
 import fs8.lib.xkb.how2type;
 import fs8.event;
+import fs8.lib.aho_table;
 import fs8.lib.mod_parser;
+import fs8.lib.xkb;
+import fs8.log;
 import fs8.pimpl;
 
 using fs8::basic_search_engine;
 using fs8::basic_typed;
 
+// NOLINTBEGIN(*-pro-bounds-constant-array-index)
 namespace {
 
     std::uint32_t calc_children_mask(auto const &node) noexcept {
@@ -31,236 +47,811 @@ namespace {
         }
         return mask;
     }
-} // namespace
 
-template <>
-struct fs8::pimpl_idiom<basic_search_engine>::impl {
-    struct node_type {
-        char32_t      value     = 0; // the incoming code point for this node (root = 0)
-        std::uint32_t out_link  = 0; // output bitmask (pattern IDs)
-        std::uint32_t fail_link = 0; // failure link (state index)
+    /**
+     * One built automaton. It's never changed once it's in use, so a new one
+     * can be built on another thread while the event thread runs on this one.
+     */
+    struct aho_machine {
+        using state_type = std::uint32_t;
+
+        static constexpr std::uint32_t no_pattern = std::numeric_limits<std::uint32_t>::max();
+        static constexpr std::uint32_t no_state   = std::numeric_limits<std::uint32_t>::max();
+
+        struct node_type {
+            char32_t      value     = 0;          // the incoming code point for this node (root = 0)
+            std::uint32_t fail_link = 0;          // failure link (state index)
+            std::uint32_t pattern   = no_pattern; // the pattern that ends right here
+            std::uint32_t dict_link = no_state;   // the next state down the failure links that ends a pattern
+
+            // Where this state is in a pre-order walk of the tree the failure links
+            // make: the states whose failure links lead through this one are the
+            // ones in [enter, leave), so "does this state's pattern end at that
+            // state" is two comparisons.
+            std::uint32_t enter = 0;
+            std::uint32_t leave = 0;
+
+            // children: pair<codepoint, state_index>. kept sorted by codepoint for binary search.
+            std::vector<std::pair<char32_t, std::uint32_t>> children;
+
+            // A mask for all children keys for faster failures
+            std::uint32_t children_mask = 0U;
+        };
+
+        /// The patterns it was built from, by trigger id; an empty one was removed
+        std::vector<std::u32string> patterns;
+        /// The state each pattern ends at (parallel to `patterns`); `no_state` for the removed ones
+        std::vector<std::uint32_t> pattern_states;
+        std::vector<node_type>     trie;
+        std::size_t                longest = 0; // the length of the longest pattern
+
+        // Which edit of the patterns it has, and the generation of the states
+        // it hands out.
+        std::uint64_t revision   = 0;
+        std::uint8_t  generation = 0;
+
+        // The hot path: the trie as a DFA, with the failure links folded into a
+        // dense table of [state][class]. The code points the patterns use are the
+        // classes (1 and up), everything else is class 0; so a keystroke is one
+        // load for its class and one for the next state. If the table would be
+        // too big, it stays empty and `next` walks the trie instead.
+        static constexpr std::size_t max_transitions = 1U << 22U; // 16 MiB
+
+        std::array<std::uint32_t, 128>                  ascii_classes{};
+        std::vector<std::pair<char32_t, std::uint32_t>> wide_classes; // open addressing; a 0 code point is empty
+        std::uint32_t                                   classes = 1;
+        std::vector<std::uint32_t>                      transitions;
+
+        [[nodiscard]] static constexpr std::size_t hash_of(char32_t const code, std::size_t const mask) noexcept {
+            return static_cast<std::size_t>((std::uint64_t{code} * 0x9E37'79B9'7F4A'7C15ULL) >> 32U) & mask;
+        }
+
+        [[nodiscard]] std::uint32_t class_of(char32_t const code) const noexcept {
+            if (code < ascii_classes.size()) [[likely]] {
+                return ascii_classes[code];
+            }
+            if (wide_classes.empty()) {
+                return 0;
+            }
+            auto const mask = wide_classes.size() - 1;
+            for (auto pos = hash_of(code, mask);; pos = (pos + 1) & mask) {
+                auto const [key, cls] = wide_classes[pos];
+                if (key == code) {
+                    return cls;
+                }
+                if (key == 0) {
+                    return 0;
+                }
+            }
+        }
+
+        [[nodiscard]] state_type find_child(state_type const state, char32_t const code) const noexcept {
+            auto const &children = trie[state].children;
+
+            // binary search since children is kept sorted by codepoint
+            auto const it = std::lower_bound(children.begin(), children.end(), code, [](auto const &a, char32_t value) {
+                return a.first < value;
+            });
+            if (it != children.end() && it->first == code) {
+                return it->second;
+            }
+            return 0; // index to root
+        }
+
+        [[nodiscard]] state_type quick_find_child(state_type const state, char32_t const code) const noexcept {
+            if ((trie[state].children_mask & code) == 0) [[likely]] {
+                // User most likely won't be typing the shortcuts all the time, so we put it in the slow path
+                return 0; // index to root
+            }
+            return find_child(state, code);
+        }
 
-        // children: pair<codepoint, state_index>. kept sorted by codepoint for binary search.
-        std::vector<std::pair<char32_t, std::uint32_t>> children;
+        std::uint32_t add_child(state_type const state, char32_t code, state_type child_index) {
+            auto      &node     = trie[state];
+            auto      &children = node.children;
+            auto const it       = std::lower_bound(children.begin(), children.end(), code, [](auto const &a, char32_t value) {
+                return a.first < value;
+            });
+            children.emplace(it, code, child_index); // insert sorted
+            node.children_mask |= code;
+            return calc_children_mask(node);
+        }
+
+        /// The state after `code`
+        [[nodiscard]] state_type next(state_type state, char32_t const code) const noexcept {
+            if (!transitions.empty()) [[likely]] {
+                return transitions[(state * classes) + class_of(code)];
+            }
+
+            // follow transitions; if not present, follow failure links until root
+            auto next = quick_find_child(state, code);
+            while (next == 0 && state != 0) {
+                state = trie[state].fail_link;
+                next  = quick_find_child(state, code);
+            }
+            return next;
+        }
+
+        [[nodiscard]] bool matches(std::uint32_t const state, std::uint16_t const trigger_id) const noexcept {
+            if (trigger_id >= pattern_states.size() || pattern_states[trigger_id] == no_state) [[unlikely]] {
+                return false;
+            }
+            // The pattern is a suffix of what's been typed, if its state is on this
+            // state's failure chain.
+            auto const &end  = trie[pattern_states[trigger_id]];
+            auto const  rank = trie[state].enter;
+            return end.enter <= rank && rank < end.leave;
+        }
 
-        // A mask for all children keys for faster failures
-        std::uint32_t children_mask = 0U;
+        void build();
+        void compile(std::span<std::uint32_t const> order);
     };
 
+    void aho_machine::build() {
+        trie.clear();
+        trie.emplace_back(); // root node (index 0)
+        pattern_states.assign(patterns.size(), no_state);
+        longest = 0;
+
+        // Insert patterns into trie
+        for (std::size_t id = 0; id < patterns.size(); ++id) {
+            auto const &pattern = patterns[id];
+            if (pattern.empty()) {
+                continue; // removed
+            }
+            state_type current = 0;
+            for (char32_t const c : pattern) {
+                auto next = find_child(current, c);
+                if (next == 0) {
+                    // create new node
+                    next               = static_cast<state_type>(trie.size());
+                    auto &last         = trie.emplace_back();
+                    last.value         = c;
+                    last.children_mask = add_child(current, c, next);
+                }
+                current = next;
+            }
+            if (trie[current].pattern == no_pattern) {
+                trie[current].pattern = static_cast<std::uint32_t>(id);
+            }
+            pattern_states[id] = current;
+            longest            = std::max(longest, pattern.size());
+        }
+
+        // Build failure links using BFS; `order` is the queue, and keeps the order
+        // for numbering the states below.
+        std::vector<state_type> order;
+        order.reserve(trie.size());
+        order.push_back(0);
+        trie[0].children_mask = calc_children_mask(trie[0]);
+
+        for (std::size_t head = 0; head < order.size(); ++head) {
+            auto const cstate = order[head];
+
+            // iterate over each child of cstate
+            for (auto const &[code, child_index] : trie[cstate].children) {
+                // compute failure for child_index; root's children fail to root
+                state_type fail = 0;
+                if (cstate != 0) {
+                    fail = trie[cstate].fail_link;
+                    // walk fail links until we find a node that has `ch` as child or reach root
+                    while (fail != 0 && find_child(fail, code) == 0) {
+                        fail = trie[fail].fail_link;
+                    }
+                    fail = find_child(fail, code);
+                }
+                auto &child     = trie[child_index];
+                child.fail_link = fail;
+                child.dict_link = trie[fail].pattern != no_pattern ? fail : trie[fail].dict_link;
+
+                order.push_back(child_index);
+            }
+        }
+
+        // Number the states in a pre-order walk of the failure-link tree. A state
+        // comes after its failure link in BFS order, so the subtree sizes add up
+        // backwards, and then the parents hand their ranges out going forwards.
+        for (auto &node : trie) {
+            node.leave = 1; // the subtree's size, for now
+        }
+        for (auto const state : std::views::reverse(order)) {
+            if (state != 0) {
+                trie[trie[state].fail_link].leave += trie[state].leave;
+            }
+        }
+        std::vector<std::uint32_t> next_rank(trie.size(), 0);
+        next_rank[0]  = 1;
+        trie[0].leave = static_cast<std::uint32_t>(trie.size());
+        for (auto const state : order | std::views::drop(1)) {
+            auto &node        = trie[state];
+            auto &parent_rank = next_rank[node.fail_link];
+            node.enter        = parent_rank;
+            node.leave       += node.enter;
+            parent_rank       = node.leave;
+            next_rank[state]  = node.enter + 1;
+        }
+
+        compile(order);
+    }
+
+    /// Fold the failure links of the trie into the table; `order` is the BFS
+    /// order of the states, so a state's failure state is done before it.
+    void aho_machine::compile(std::span<std::uint32_t const> const order) {
+        ascii_classes.fill(0);
+        wide_classes.clear();
+        transitions.clear();
+        classes = 1;
+
+        std::vector<char32_t> wide;
+        for (auto const &node : trie | std::views::drop(1)) {
+            auto const code = node.value;
+            if (code < ascii_classes.size()) {
+                if (ascii_classes[code] == 0) {
+                    ascii_classes[code] = classes++;
+                }
+            } else if (std::ranges::find(wide, code) == wide.end()) {
+                wide.push_back(code);
+            }
+        }
+        if (!wide.empty()) {
+            wide_classes.assign(std::bit_ceil(wide.size() * 2), {0, 0});
+            auto const mask = wide_classes.size() - 1;
+            for (auto const code : wide) {
+                auto pos = hash_of(code, mask);
+                while (wide_classes[pos].first != 0) {
+                    pos = (pos + 1) & mask;
+                }
+                wide_classes[pos] = {code, classes++};
+            }
+        }
+
+        if (trie.size() * classes > max_transitions) [[unlikely]] {
+            return;
+        }
+        transitions.assign(trie.size() * classes, 0);
+        for (auto const state : order) {
+            auto const row = transitions.begin() + static_cast<std::ptrdiff_t>(state * classes);
+            if (state != 0) {
+                auto const fail_row = transitions.begin() + static_cast<std::ptrdiff_t>(trie[state].fail_link * classes);
+                std::copy_n(fail_row, classes, row);
+            }
+            for (auto const &[code, child] : trie[state].children) {
+                row[class_of(code)] = child;
+            }
+        }
+    }
+
+    /// A change to the patterns, for the builder thread.
+    struct pattern_edit {
+        std::uint64_t  revision = 0;
+        std::uint16_t  id       = 0;
+        std::u32string pattern;      // empty: removed
+        bool           build = true; // false: it's built on the event thread already
+    };
+} // namespace
+
+template <>
+struct fs8::pimpl_idiom<basic_search_engine>::impl {
     /// UTF-32-encoded patterns (some code points are special code points)
-    /// Trigger ID is the index that points to this patterns
-    /// todo: use inplace_vector<std::u32string, MAX_PATTERNS>
+    /// Trigger ID is the index that points to this patterns; an empty one was removed
     std::vector<std::u32string> patterns;
     /// The modifier mode of each pattern (parallel to `patterns`)
     std::vector<modifier_mode> pattern_modes;
-    std::vector<node_type>     trie;
-};
+    /// Removed ids, free to be used again (no machine in use has them anymore)
+    std::vector<std::uint16_t> free_ids;
+    /// Removed ids, and the revision that removed them
+    std::vector<std::pair<std::uint64_t, std::uint16_t>> removed_ids;
+    /// Every change of the patterns is a new revision
+    std::uint64_t revision = 0;
+
+    /// The machine in use
+    std::unique_ptr<aho_machine> machine;
+    std::uint8_t                 generation = 0; // of the last machine; the compiled table's is 0
+
+    // The compiled table's patterns came into `patterns` already (see
+    // `aho_table_of`).
+    bool table_loaded = false;
+
+    // The shared scan: the presses and the releases are two separate streams
+    // of keystrokes, each with its own state.
+    enum struct stream_kind : std::uint8_t { press, release, none };
+
+    struct stream_type {
+        aho_state state{};
+
+        // The latest keystrokes, a ring as long as the longest pattern; for
+        // checking the gaps of the timed patterns, and for taking the state
+        // over to a new machine.
+        struct keystroke {
+            std::chrono::microseconds time{};
+            char32_t                  code = 0;
+        };
+
+        std::vector<keystroke> ring;
+        std::size_t            head = 0; // where the next one goes
+        std::size_t            seen = 0; // keystrokes so far
+
+        void reset(std::size_t const length) {
+            state = aho_state{};
+            ring.assign(length, {});
+            head = 0;
+            seen = 0;
+        }
 
-template <>
-struct fs8::pimpl_idiom<basic_typed>::impl {
-    std::uint16_t trigger_id = basic_typed::invalid_trigger_id; // pattern id in the search engine
-    aho_state     aho_search_state{};                           // the state of where we are in search engine
-};
+        void push(std::chrono::microseconds const time, char32_t const code) noexcept {
+            ring[head] = {.time = time, .code = code};
+            head       = (head + 1) % ring.size();
+            ++seen;
+        }
 
-// NOLINTBEGIN(*-pro-bounds-constant-array-index)
-basic_search_engine::state_type basic_search_engine::find_child(state_type const state, char32_t const code) const noexcept {
-    if (pimpl.get() == nullptr) [[unlikely]] {
-        return 0;
-    }
-    auto const &node     = pimpl->trie[state];
-    auto const &children = node.children;
+        /// The `nth` latest keystroke, 0 being the last one.
+        [[nodiscard]] keystroke const &latest(std::size_t const nth) const noexcept {
+            return ring[(head + ring.size() - 1 - nth) % ring.size()];
+        }
 
-    // binary search since children is kept sorted by codepoint
-    auto const it = std::lower_bound(children.begin(), children.end(), code, [](auto const &a, char32_t value) {
-        return a.first < value;
-    });
-    if (it != children.end() && it->first == code) {
-        return it->second;
-    }
-    return 0; // index to root
-}
+        /// The time of the `nth` latest keystroke, 0 being the last one.
+        [[nodiscard]] std::chrono::microseconds time(std::size_t const nth) const noexcept {
+            return latest(nth).time;
+        }
 
-basic_search_engine::state_type basic_search_engine::quick_find_child(state_type const state, char32_t const code) const noexcept {
-    if (pimpl.get() == nullptr) [[unlikely]] {
-        return 0;
+        /// Walk what's been typed again in `machine`; a state can't remember more
+        /// than the longest pattern, so the ring is all it takes.
+        void take_over(aho_machine const &machine) {
+            auto const kept = std::min(seen, ring.size());
+            if (machine.longest > ring.size()) {
+                std::vector<keystroke> grown(machine.longest);
+                for (std::size_t nth = kept; nth-- > 0;) {
+                    grown[kept - 1 - nth] = latest(nth);
+                }
+                ring = std::move(grown);
+                head = kept % ring.size();
+            }
+            std::uint32_t index = 0;
+            for (std::size_t nth = kept; nth-- > 0;) {
+                index = machine.next(index, latest(nth).code);
+            }
+            state = aho_state{index, machine.generation};
+        }
+    };
+
+    std::optional<xkb::basic_state> keyboard; // decoding the key events
+    std::array<stream_type, 2>      streams{};
+    stream_kind                     last_stream = stream_kind::none; // what the last scanned event moved on
+
+    void reset_streams(std::size_t const longest) {
+        for (auto &stream : streams) {
+            stream.reset(std::max<std::size_t>(longest, 1));
+        }
+        last_stream = stream_kind::none;
     }
-    if ((pimpl->trie[state].children_mask & code) == 0) [[likely]] {
-        // User most likely won't be typing the shortcuts all the time, so we put it in the slow path
-        return 0; // index to root
+
+    [[nodiscard]] static constexpr stream_kind stream_of(modifier_mode const mode) noexcept {
+        // keydown patterns only track presses, keyup patterns only track releases:
+        bool const is_up_mode = mode == modifier_mode::keyup || mode == modifier_mode::ordered_keyup;
+        return is_up_mode ? stream_kind::release : stream_kind::press;
     }
-    return find_child(state, code);
-}
 
-std::uint32_t basic_search_engine::add_child(state_type const state, char32_t code, state_type child_index) {
-    auto      &node     = pimpl->trie[state];
-    auto      &children = pimpl->trie[state].children;
-    auto const it       = std::lower_bound(children.begin(), children.end(), code, [](auto const &a, char32_t value) {
-        return a.first < value;
-    });
-    children.emplace(it, code, child_index); // insert sorted
-    node.children_mask |= code;
-    return calc_children_mask(node);
-}
+    // --- building off the event thread ---
 
-std::uint32_t basic_search_engine::build_machine() {
-    pimpl->trie.clear();
-    {
-        auto &root     = pimpl->trie.emplace_back(); // root node (index 0)
-        root.value     = 0;
-        root.out_link  = 0;
-        root.fail_link = 0;
-    }
-
-    std::uint32_t last_state = 1;
-    std::uint32_t index      = 0;
-
-    // Insert patterns into trie
-    for (auto const &pattern : pimpl->patterns) {
-        state_type current = 0;
-        for (char32_t const c : pattern) {
-            auto next = find_child(current, c);
-            if (next == 0) {
-                // create new node
-                auto &last         = pimpl->trie.emplace_back();
-                last.value         = c;
-                last.out_link      = 0;
-                last.fail_link     = 0;
-                next               = last_state;
-                last.children_mask = add_child(current, c, next);
-                ++last_state;
+    std::mutex                  lock;
+    std::condition_variable_any wake;
+    std::vector<pattern_edit>   edits; // guarded by `lock`
+
+    std::atomic<aho_machine *> built{nullptr};   // builder -> event thread
+    std::atomic<aho_machine *> retired{nullptr}; // event thread -> builder, to be freed there
+
+    std::jthread builder; // last: everything above is ready before it starts
+
+    impl() = default;
+
+    impl(impl const &)            = delete;
+    impl(impl &&)                 = delete;
+    impl &operator=(impl const &) = delete;
+    impl &operator=(impl &&)      = delete;
+
+    ~impl() {
+        if (builder.joinable()) {
+            builder.request_stop();
+            builder.join();
+        }
+        delete built.load();
+        delete retired.load();
+    }
+
+    /// Make `next` the machine in use; the streams are walked over to it.
+    void use(std::unique_ptr<aho_machine> next) {
+        next->generation = static_cast<std::uint8_t>(generation + 1U);
+        for (auto &stream : streams) {
+            stream.take_over(*next);
+        }
+        std::erase_if(removed_ids, [&](auto const &removed) {
+            if (removed.first > next->revision) {
+                return false;
             }
-            current = next;
+            free_ids.push_back(removed.second);
+            return true;
+        });
+        generation = next->generation;
+        if (machine != nullptr) {
+            // Freed on the builder thread, unless the last one is still there.
+            delete retired.exchange(machine.release());
+        }
+        machine = std::move(next);
+    }
+
+    /// The event thread: take the newest machine the builder made, if it's
+    /// newer than the one in use.
+    bool adopt() noexcept {
+        std::unique_ptr<aho_machine> next{built.exchange(nullptr, std::memory_order_acquire)};
+        if (next == nullptr || (machine != nullptr && next->revision <= machine->revision)) {
+            return false;
         }
+        try {
+            use(std::move(next));
+            return true;
+        } catch (...) {
+            return false; // out of memory growing the rings; keep the old one
+        }
+    }
+
+    /// Build a machine of the current patterns, right here.
+    void build_now() {
+        auto next      = std::make_unique<aho_machine>();
+        next->patterns = patterns;
+        next->revision = revision;
+        next->build();
+        use(std::move(next));
+    }
 
-        // pattern index too large for bitmask; you may want to change representation.
-        if (index >= MAX_PATTERNS) {
-            throw std::runtime_error("Too many patterns added.");
+    /// Hand the change to `id` to the builder thread, starting it if it's not
+    /// running; it builds a machine with it, unless `build` is false.
+    void request(std::uint16_t const id, bool const build = true) {
+        if (!builder.joinable()) {
+            // It starts with a copy of the patterns, this change included.
+            builder = std::jthread{[this, source = patterns, applied = revision](std::stop_token const stop) mutable noexcept {
+                run(stop, std::move(source), applied);
+            }};
+        } else {
+            std::scoped_lock const guard{lock};
+            edits.push_back({.revision = revision, .id = id, .pattern = patterns[id], .build = build});
         }
+        wake.notify_one();
+    }
 
-        // set output bit for pattern i
-        pimpl->trie[current].out_link |= 1U << index;
-        ++index;
+    /// The builder thread: apply the edits to its own copy of the patterns, and
+    /// build a machine of them, until it's stopped.
+    void run(std::stop_token const stop, std::vector<std::u32string> source, std::uint64_t applied) noexcept {
+        bool build = true; // the first one, of the copy it started with
+        for (;;) {
+            std::vector<pattern_edit> batch;
+            {
+                std::unique_lock guard{lock};
+                if (!build && !wake.wait(guard, stop, [&] {
+                        return !edits.empty();
+                    }))
+                {
+                    return; // stopped
+                }
+                batch.swap(edits);
+            }
+            try {
+                for (auto &edit : batch) {
+                    if (edit.id >= source.size()) {
+                        source.resize(edit.id + 1U);
+                    }
+                    source[edit.id] = std::move(edit.pattern);
+                    applied         = edit.revision;
+                    build           = build || edit.build;
+                }
+                if (!build) {
+                    continue;
+                }
+                build          = false;
+                auto next      = std::make_unique<aho_machine>();
+                next->patterns = source;
+                next->revision = applied;
+                next->build();
+                // One the event thread hasn't taken yet is out of date now.
+                delete built.exchange(next.release(), std::memory_order_release);
+            } catch (...) {
+                log("search_engine: failed to build the automaton; it's tried again with the next change.");
+            }
+            delete retired.exchange(nullptr);
+        }
     }
+};
 
+template <>
+struct fs8::pimpl_idiom<basic_typed>::impl {
+    std::uint16_t trigger_id = basic_typed::invalid_trigger_id; // pattern id in the search engine
+};
 
-    // Build failure links using BFS
-    std::queue<state_type> q;
+bool basic_search_engine::compiled() const noexcept {
+    return !table.empty() && (pimpl.get() == nullptr || pimpl->machine == nullptr);
+}
 
-    // initialize root's children: their fail is root (0)
-    for (auto const [_, child_index] : pimpl->trie[0].children) {
-        pimpl->trie[child_index].fail_link = 0;
-        q.push(child_index);
+std::size_t basic_search_engine::pattern_count() const noexcept {
+    if (compiled()) {
+        return table.size();
     }
-    pimpl->trie[0].children_mask = calc_children_mask(pimpl->trie[0]);
+    return pimpl.get() == nullptr ? 0 : pimpl->patterns.size();
+}
 
-    while (!q.empty()) {
-        auto const cstate = q.front();
-        q.pop();
+fs8::modifier_mode basic_search_engine::pattern_mode(std::uint16_t const trigger_id) const noexcept {
+    if (compiled()) {
+        return modifier_mode::unknown; // plain text only
+    }
+    return pimpl->pattern_modes[trigger_id];
+}
 
-        // iterate over each child of cstate
-        for (auto const &[code, child_index] : pimpl->trie[cstate].children) {
-            // compute failure for child_index
-            auto fail = pimpl->trie[cstate].fail_link;
-            // walk fail links until we find a node that has `ch` as child or reach root
-            while (fail != 0 && find_child(fail, code) == 0) {
-                fail = pimpl->trie[fail].fail_link;
-            }
-            auto const fchild = find_child(fail, code);
-            if (fchild != 0) {
-                pimpl->trie[child_index].fail_link = fchild;
-            } else {
-                pimpl->trie[child_index].fail_link = 0;
-            }
+std::size_t basic_search_engine::pattern_length(std::uint16_t const trigger_id) const noexcept {
+    if (pimpl.get() != nullptr && trigger_id < pimpl->patterns.size() && pimpl->patterns[trigger_id].empty()) {
+        return 0; // removed
+    }
+    if (compiled()) {
+        return table.lengths[trigger_id];
+    }
+    return pimpl->patterns[trigger_id].size();
+}
 
-            // merge output links
-            pimpl->trie[child_index].out_link |= pimpl->trie[pimpl->trie[child_index].fail_link].out_link;
+void basic_search_engine::load_table() {
+    if (table.empty() || pimpl->table_loaded) {
+        return;
+    }
+    for (auto const compiled_pattern : table.patterns) {
+        pimpl->patterns.emplace_back(encoded_modifiers(compiled_pattern));
+        pimpl->pattern_modes.push_back(modifier_mode_of(compiled_pattern));
+    }
+    pimpl->table_loaded = true;
+    ++pimpl->revision;
+}
 
-            q.push(child_index);
+std::uint16_t basic_search_engine::add_pattern(std::string_view const pattern, bool &added) {
+    auto const mode      = modifier_mode_of(pattern);
+    auto       e_pattern = encoded_modifiers(pattern);
+    added                = false;
+    if (e_pattern.empty()) [[unlikely]] {
+        throw std::invalid_argument("An empty pattern.");
+    }
+    if (auto const it = std::ranges::find(pimpl->patterns, e_pattern); it != pimpl->patterns.end()) {
+        return static_cast<std::uint16_t>(std::distance(pimpl->patterns.begin(), it));
+    }
+    std::uint16_t index = 0;
+    if (!pimpl->free_ids.empty()) {
+        index = pimpl->free_ids.back();
+        pimpl->free_ids.pop_back();
+        pimpl->patterns[index]      = std::move(e_pattern);
+        pimpl->pattern_modes[index] = mode;
+    } else {
+        if (pimpl->patterns.size() >= MAX_PATTERNS) [[unlikely]] {
+            throw std::length_error("Too many patterns added.");
         }
+        pimpl->patterns.emplace_back(std::move(e_pattern));
+        pimpl->pattern_modes.push_back(mode);
+        index = static_cast<std::uint16_t>(pimpl->patterns.size() - 1);
     }
+    ++pimpl->revision;
+    added = true;
+    return index;
+}
 
-    return last_state;
+std::uint32_t basic_search_engine::build_machine() {
+    pimpl->build_now();
+    return static_cast<std::uint32_t>(pimpl->machine->trie.size());
 }
 
 std::uint16_t basic_search_engine::emplace_pattern(std::string_view const pattern) {
     if (pimpl.get() == nullptr) [[unlikely]] {
         init_impl();
     }
-    auto const    mode      = modifier_mode_of(pattern);
-    auto          e_pattern = encoded_modifiers(pattern);
-    auto const    it        = std::ranges::find(pimpl->patterns, e_pattern);
-    std::uint16_t index     = 0;
-    if (it == pimpl->patterns.end()) {
-        // insert it if we didn't find it
-        pimpl->patterns.emplace_back(std::move(e_pattern));
-        pimpl->pattern_modes.push_back(mode);
-        index = static_cast<std::uint16_t>(pimpl->patterns.size() - 1);
+    if (!pimpl->keyboard) {
+        pimpl->keyboard.emplace(xkb::get_default_keymap());
+    }
+    if (compiled()) {
+        if (auto const id = table.find(pattern); id < table.size()) [[likely]] {
+            if (pimpl->streams.front().ring.empty()) {
+                pimpl->reset_streams(table.longest); // not started, e.g. outside of a pipeline
+            }
+            return static_cast<std::uint16_t>(id);
+        }
+        log("search_engine: '{}' isn't one of the compiled patterns; building the automaton at runtime instead.", pattern);
+        load_table();
+    }
+    bool       added = false;
+    auto const index = add_pattern(pattern, added);
+    if (added || pimpl->machine == nullptr) {
+        // Rebuild it right here; see `insert_pattern` for doing it on the side
+        pimpl->build_now();
+        if (pimpl->builder.joinable()) {
+            pimpl->request(index, false);
+        }
+    }
+    return index;
+}
 
-        // Rebuild machine (can be optimized to incremental insertion if needed)
-        build_machine();
-    } else {
-        index = static_cast<std::uint16_t>(std::distance(pimpl->patterns.begin(), it));
+std::uint16_t basic_search_engine::insert_pattern(std::string_view const pattern) {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        init_impl();
+    }
+    if (!pimpl->keyboard) {
+        pimpl->keyboard.emplace(xkb::get_default_keymap());
+    }
+    if (compiled()) {
+        if (auto const id = table.find(pattern); id < table.size()) {
+            return static_cast<std::uint16_t>(id);
+        }
+        load_table(); // the table's in use until the machine that has them all is ready
+    }
+    bool       added = false;
+    auto const index = add_pattern(pattern, added);
+    if (added) {
+        pimpl->request(index);
     }
     return index;
 }
 
-fs8::aho_state basic_search_engine::process(char32_t const code_point, aho_state const last_state) const noexcept {
+void basic_search_engine::erase_pattern(std::uint16_t const trigger_id) {
     if (pimpl.get() == nullptr) [[unlikely]] {
-        return last_state.next_generation(0);
+        init_impl();
     }
-    assert(!pimpl->trie.empty());
-    auto state = last_state.index();
+    if (compiled()) {
+        load_table();
+    }
+    if (trigger_id >= pimpl->patterns.size() || pimpl->patterns[trigger_id].empty()) [[unlikely]] {
+        return;
+    }
+    pimpl->patterns[trigger_id].clear();
+    pimpl->pattern_modes[trigger_id] = modifier_mode::unknown;
+    ++pimpl->revision;
+    pimpl->removed_ids.emplace_back(pimpl->revision, trigger_id);
+    pimpl->request(trigger_id);
+}
 
-    // follow transitions; if not present, follow failure links until root
-    auto next = quick_find_child(state, code_point);
-    while (next == 0 && state != 0) {
-        state = pimpl->trie[state].fail_link;
-        next  = quick_find_child(state, code_point);
+bool basic_search_engine::refresh() noexcept {
+    if (pimpl.get() == nullptr) [[unlikely]] {
+        return false;
+    }
+    if (pimpl->built.load(std::memory_order_relaxed) == nullptr) [[likely]] {
+        return false;
     }
-    return last_state.next_generation(next);
+    return pimpl->adopt();
+}
+
+bool basic_search_engine::rebuilding() const noexcept {
+    if (pimpl.get() == nullptr || !pimpl->builder.joinable()) {
+        return false;
+    }
+    return pimpl->machine == nullptr || pimpl->machine->revision < pimpl->revision;
+}
+
+fs8::aho_state basic_search_engine::process(char32_t const code_point, aho_state const last_state) const noexcept {
+    if (compiled()) {
+        return aho_state{table.next(last_state.index(), code_point), 0};
+    }
+    if (pimpl.get() == nullptr || pimpl->machine == nullptr) [[unlikely]] {
+        return aho_state{};
+    }
+    auto const &machine = *pimpl->machine;
+
+    // A state of another machine means nothing in this one.
+    auto state = last_state.index();
+    if (last_state.generation() != machine.generation || state >= machine.trie.size()) [[unlikely]] {
+        state = 0;
+    }
+    return aho_state{machine.next(state, code_point), machine.generation};
 }
 
 void basic_search_engine::matches(std::uint32_t const state, std::function_ref<void(std::u32string_view)> callback) const {
-    if (pimpl.get() == nullptr) [[unlikely]] {
+    if (compiled()) {
+        for (std::size_t id = 0; id < table.size(); ++id) {
+            if (table.matches(state, id)) {
+                callback(table.code_points(id));
+            }
+        }
         return;
     }
-    assert(pimpl->patterns.size() < MAX_PATTERNS);
-    if (state >= pimpl->trie.size()) [[unlikely]] {
+    if (pimpl.get() == nullptr || pimpl->machine == nullptr) [[unlikely]] {
         return;
     }
-    auto const mask = pimpl->trie[state].out_link;
-    for (std::size_t j = 0; j < pimpl->patterns.size(); ++j) {
-        if ((mask & (1U << j)) != 0u) {
-            callback(pimpl->patterns[j]);
-        }
+    auto const &machine = *pimpl->machine;
+    if (state >= machine.trie.size()) [[unlikely]] {
+        return;
+    }
+    // The pattern that ends here, then the ones that end at its suffixes.
+    auto cur = machine.trie[state].pattern != aho_machine::no_pattern ? state : machine.trie[state].dict_link;
+    while (cur != aho_machine::no_state) {
+        auto const &node = machine.trie[cur];
+        callback(machine.patterns[node.pattern]);
+        cur = node.dict_link;
     }
 }
 
 bool basic_search_engine::matches(std::uint32_t const state, std::uint16_t const trigger_id) const noexcept {
-    if (pimpl.get() == nullptr) [[unlikely]] {
+    if (compiled()) {
+        return trigger_id < table.size() && table.matches(state, trigger_id);
+    }
+    if (pimpl.get() == nullptr || pimpl->machine == nullptr) [[unlikely]] {
+        return false;
+    }
+    if (state >= pimpl->machine->trie.size()) [[unlikely]] {
         return false;
     }
-    assert(state < pimpl->trie.size());
-    assert(trigger_id < MAX_PATTERNS);
-    auto const mask = pimpl->trie[state].out_link;
-    return (mask >> trigger_id & 0b1U) != 0u;
+    return pimpl->machine->matches(state, trigger_id);
 }
 
 fs8::context_action basic_search_engine::operator()(start_tag) noexcept try {
     if (pimpl.get() == nullptr) [[unlikely]] {
         init_impl();
     }
-    pimpl->trie.clear(); // clear the trie in case of a restart
+    if (!pimpl->keyboard) {
+        pimpl->keyboard.emplace(xkb::get_default_keymap());
+    }
+    if (compiled()) {
+        pimpl->reset_streams(table.longest);
+        return fs8::context_action::next; // the compiler has built it already
+    }
 
-    // create empty machine (root-only)
+    // (re)build the machine of what's there (root-only if nothing is)
     build_machine();
+    pimpl->reset_streams(pimpl->machine->longest);
     return fs8::context_action::next;
 } catch (...) {
-    // clear the trie in case of a failed build; keep the pipeline running in a degraded state
-    pimpl->trie.clear();
+    // drop the machine in case of a failed build; keep the pipeline running in a degraded state
+    pimpl->machine.reset();
     return fs8::context_action::idle;
 }
 
+void basic_search_engine::scan(event_type const &event) noexcept {
+    if (pimpl.get() == nullptr || !pimpl->keyboard) [[unlikely]] {
+        return; // not started
+    }
+    refresh();
+    if (pimpl->streams.front().ring.empty() || (!compiled() && pimpl->machine == nullptr)) [[unlikely]] {
+        return; // no machine yet, or a failed build
+    }
+    pimpl->last_stream = impl::stream_kind::none;
+    if (event.type() != EV_KEY || event.value() > 1) {
+        return; // not a keystroke, or a repeat
+    }
+    auto const code = unicode_encoded_event(*pimpl->keyboard, static_cast<key_event>(event));
+
+    auto const kind   = event.value() == 1 ? impl::stream_kind::press : impl::stream_kind::release;
+    auto      &stream = pimpl->streams[static_cast<std::size_t>(kind)];
+    stream.state      = process(code, stream.state);
+    stream.push(event.micro_time(), code);
+    pimpl->last_stream = kind;
+}
+
+bool basic_search_engine::matched(std::uint16_t const trigger_id) const noexcept {
+    if (pimpl.get() == nullptr || pimpl->last_stream == impl::stream_kind::none) {
+        return false;
+    }
+    if (trigger_id >= pattern_count() || pattern_length(trigger_id) == 0) [[unlikely]] {
+        return false; // not there, or removed
+    }
+    auto const kind = impl::stream_of(pattern_mode(trigger_id));
+    if (kind != pimpl->last_stream) {
+        return false;
+    }
+    return matches(pimpl->streams[static_cast<std::size_t>(kind)].state.index(), trigger_id);
+}
+
+bool basic_search_engine::matched(std::uint16_t const trigger_id, std::chrono::microseconds const max_gap) const noexcept {
+    if (!matched(trigger_id)) {
+        return false;
+    }
+    // If the user paused too long between two characters of the pattern, it
+    // doesn't count.
+    auto const &stream = pimpl->streams[static_cast<std::size_t>(pimpl->last_stream)];
+    auto const  length = std::min({pattern_length(trigger_id), stream.seen, stream.ring.size()});
+    for (std::size_t nth = 1; nth < length; ++nth) {
+        if (stream.time(nth - 1) - stream.time(nth) > max_gap) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool basic_search_engine::search(
   event_type const       &event,
   std::uint16_t const     trigger_id,
@@ -271,10 +862,10 @@ bool basic_search_engine::search(
     }
     auto const code = unicode_encoded_event(keyboard_state, static_cast<key_event>(event));
 
-    if (trigger_id >= pimpl->pattern_modes.size()) [[unlikely]] {
+    if (trigger_id >= pattern_count()) [[unlikely]] {
         return false;
     }
-    auto const mode       = pimpl->pattern_modes[trigger_id];
+    auto const mode       = pattern_mode(trigger_id);
     bool const is_up_mode = mode == modifier_mode::keyup || mode == modifier_mode::ordered_keyup;
     // keydown patterns only track presses, keyup patterns only track releases:
     if (is_up_mode ? event.value() != 0 : event.value() != 1) {
@@ -297,10 +888,10 @@ bool basic_search_engine::timed_search(
     }
     auto const code = unicode_encoded_event(keyboard_state, static_cast<key_event>(event));
 
-    if (trigger_id >= pimpl->pattern_modes.size()) [[unlikely]] {
+    if (trigger_id >= pattern_count()) [[unlikely]] {
         return false;
     }
-    auto const mode       = pimpl->pattern_modes[trigger_id];
+    auto const mode       = pattern_mode(trigger_id);
     bool const is_up_mode = mode == modifier_mode::keyup || mode == modifier_mode::ordered_keyup;
     // keydown patterns only track presses, keyup patterns only track releases:
     if (is_up_mode ? event.value() != 0 : event.value() != 1) {
@@ -330,11 +921,11 @@ fs8::context_action basic_typed::on_start(basic_search_engine &engine) noexcept
     return fs8::context_action::idle;
 }
 
-bool basic_typed::on_search(event_type const &event, basic_search_engine const &engine) noexcept {
+bool basic_typed::on_search(basic_search_engine const &engine) const noexcept {
     if (pimpl.get() == nullptr) [[unlikely]] {
         return false;
     }
-    return engine.search(event, pimpl->trigger_id, keyboard_state, pimpl->aho_search_state);
+    return engine.matched(pimpl->trigger_id);
 }
 
 // NOLINTEND(*-pro-bounds-constant-array-index)
@@ -3,12 +3,13 @@
 module;
 #include <cassert>
 #include <chrono>
-#include <climits>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <string_view>
 export module fs8.mods:typed;
 import fs8.context;
+import fs8.lib.aho_table;
 import fs8.lib.xkb;
 import fs8.lib.mod_parser;
 import fs8.log;
@@ -110,34 +111,86 @@ namespace fs8 {
 
     /**
      * Aho-Corasick status
+     *
+     * In a pipeline it's also the shared scan of all the `typed` and
+     * `timed_typed` patterns: each key event is decoded once, and walks one
+     * state for the presses and one for the releases; the patterns then only
+     * check `matched(trigger_id)`, which is O(1). So it goes before them:
+     * `context | search_engine | on[typed["..."], ...] | ...`.
+     *
+     * If the patterns are known at compile time, the compiler can build the
+     * automaton instead, as a flat table in the binary, with the failure links
+     * folded into the transitions: `search_engine.with<hotkeys>()` (see
+     * `aho_table_of`). Then the start costs nothing, and the `typed` mods of
+     * those patterns only look their ids up. A pattern that's not in the table
+     * has everything rebuilt at runtime, the usual way.
      */
     export struct [[nodiscard]] basic_search_engine : pimpl_idiom<basic_search_engine> {
         using pimpl_idiom::pimpl_idiom;
 
         using state_type = std::uint32_t;
 
-        using output_link_type                    = std::uint32_t;
-        static constexpr std::size_t MAX_PATTERNS = sizeof(output_link_type) * CHAR_BIT;
+        /// The trigger ids are 16 bits, and the last one means none.
+        static constexpr std::size_t MAX_PATTERNS = std::numeric_limits<std::uint16_t>::max();
 
       private:
+        aho_table_view table{}; // the compiled automaton, if any
+
+        /// Whether it's running on the compiled table
+        [[nodiscard]] bool compiled() const noexcept;
+
+        // The patterns, from the table or from the trie
+        [[nodiscard]] std::size_t   pattern_count() const noexcept;
+        [[nodiscard]] modifier_mode pattern_mode(std::uint16_t trigger_id) const noexcept;
+        [[nodiscard]] std::size_t   pattern_length(std::uint16_t trigger_id) const noexcept;
+
+        /// Build the machine of the current patterns on this thread, and use it.
         /// Returns the number of states that the built machine has.
         /// States are numbered 0 up to the return value - 1, inclusive.
         std::uint32_t build_machine();
 
         // helpers
-        [[nodiscard]] state_type    find_child(state_type state, char32_t code) const noexcept;
-        [[nodiscard]] state_type    quick_find_child(state_type state, char32_t code) const noexcept;
-        [[nodiscard]] std::uint32_t add_child(state_type state, char32_t code, state_type child_index);
+        void          load_table();
+        std::uint16_t add_pattern(std::string_view pattern, bool& added);
 
       public:
+        /// Use the automaton the compiler built for these patterns.
+        template <auto const& Patterns>
+        [[nodiscard]] consteval basic_search_engine with() const noexcept {
+            auto result{*this};
+            result.table = aho_table_of<Patterns>.view();
+            return result;
+        }
+
         /**
          * Add a new pattern to search for
          * @param pattern It's a UTF-8-encoded string that we will try to find later on
          */
         [[nodiscard("Don't lose your trigger id")]] std::uint16_t emplace_pattern(std::string_view pattern);
 
+        /**
+         * Add a pattern without holding the event thread up: the machine is
+         * rebuilt on a thread of its own, and `scan` (or `refresh`) swaps it in
+         * when it's ready, taking the typing so far over to it. The id's good
+         * right away; the pattern matches from the swap on.
+         */
+        [[nodiscard("Don't lose your trigger id")]] std::uint16_t insert_pattern(std::string_view pattern);
+
+        /// Remove a pattern; it stops matching right away, and the rest of it is
+        /// like `insert_pattern`. Its id may be handed out again after the swap.
+        void erase_pattern(std::uint16_t trigger_id);
+
+        /// Swap in the machine the builder thread made, if there's a new one.
+        bool refresh() noexcept;
+
+        /// Whether the builder thread hasn't caught up with the patterns yet.
+        [[nodiscard]] bool rebuilding() const noexcept;
+
         /**
          * Process this new event, and return a new state
+         *
+         * The generation of the states is the machine's that made them; a state
+         * of an older machine starts over from the root.
          */
         aho_state process(char32_t code_point, aho_state last_state) const noexcept;
 
@@ -147,12 +200,21 @@ namespace fs8 {
         /// Initialize empty
         context_action operator()(start_tag) noexcept;
 
+        /// Decode `event`, and move the shared states on.
+        void scan(event_type const& event) noexcept;
+
+        /// Whether the last scanned event completed the pattern.
+        [[nodiscard]] bool matched(std::uint16_t trigger_id) const noexcept;
+
+        /// Same, but only if no two of its keys were more than `max_gap` apart.
+        [[nodiscard]] bool matched(std::uint16_t trigger_id, std::chrono::microseconds max_gap) const noexcept;
+
         /// Handling events
-        void operator()() const noexcept {
-            // do nothing
+        void operator()(event_type const& event) noexcept {
+            scan(event);
         }
 
-        /// Process and match
+        /// Process and match, walking a state of your own (outside of a pipeline)
         [[nodiscard]] bool
         search(event_type const& event, std::uint16_t trigger_id, xkb::basic_state const& keyboard_state, aho_state& state) const noexcept;
 
@@ -181,14 +243,13 @@ namespace fs8 {
         static constexpr std::uint16_t invalid_trigger_id = std::numeric_limits<std::uint16_t>::max();
 
       private:
-        std::string_view pattern;          // pattern string
-        xkb::basic_state keyboard_state{}; // the state of the modifier keys and what not
+        std::string_view pattern; // pattern string
 
         /// Register the pattern into the search engine
         context_action on_start(basic_search_engine& engine) noexcept;
 
-        /// Process and search
-        [[nodiscard]] bool on_search(event_type const& event, basic_search_engine const& engine) noexcept;
+        /// Check the engine's scan of this event
+        [[nodiscard]] bool on_search(basic_search_engine const& engine) const noexcept;
 
       public:
         explicit consteval basic_typed(std::string_view const inp_pattern) noexcept : pattern{inp_pattern} {}
@@ -200,14 +261,13 @@ namespace fs8 {
 
         /// Register the pattern into the search engine
         context_action operator()(Context auto& ctx, start_tag) noexcept {
-            keyboard_state.initialize(xkb::get_default_keymap());
             return on_start(ctx.mod(search_engine));
         }
 
         template <Context CtxT>
-        [[nodiscard]] bool operator()(CtxT& ctx) noexcept {
+        [[nodiscard]] bool operator()(CtxT& ctx) const noexcept {
             static_assert(has_mod<basic_search_engine, CtxT>, "You need to have 'search_engine' in your pipeline.");
-            return on_search(ctx.event(), ctx.mod(search_engine));
+            return on_search(ctx.mod(search_engine));
         }
     } typed;
 
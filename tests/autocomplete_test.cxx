@@ -1,6 +1,8 @@
 #include "./common/tests_common_pch.hpp"
 
+#include <fstream>
 #include <linux/input-event-codes.h>
+#include <unistd.h>
 
 import fs8.mods;
 
@@ -214,3 +216,81 @@ TEST(AutocompleteTest, NoTriggerTagIsANoop) {
                 {EV_KEY, KEY_O, 1},
     }));
 }
+
+TEST(AutocompleteTest, CompletesFromADictionary) {
+    using namespace fs8; // NOLINT(*-build-using-namespace)
+
+    static constexpr std::string_view path = "/tmp/foresight-autocomplete-test.tsv";
+    std::ofstream{path.data()} << "work\t9\nworld\t3\nwonder\t1\n";
+
+    captured_events.clear();
+    // typing "wo" then Tab types the rest of the most frequent "wo..." word.
+    auto pipeline =
+      context
+      | emit_all[{
+        {.type = EV_KEY,   .code = KEY_W, .value = 1},
+        {.type = EV_KEY,   .code = KEY_O, .value = 1},
+        {.type = EV_KEY, .code = KEY_TAB, .value = 1},
+    }]
+      | autocomplete.from(path).top(2)
+      | record[captured_events];
+    pipeline();
+
+    auto const keys = key_events(to_user_events(captured_events));
+    EXPECT_EQ(keys,
+              (std::vector<std::array<int, 3>>{
+                {EV_KEY, KEY_W, 1},
+                {EV_KEY, KEY_O, 1},
+                {EV_KEY, KEY_R, 1},
+                {EV_KEY, KEY_R, 0},
+                {EV_KEY, KEY_K, 1},
+                {EV_KEY, KEY_K, 0},
+    }));
+
+    // the cursor is at the end of "work" now
+    EXPECT_EQ(pipeline.mod(autocomplete).completions(), (std::vector<std::string_view>{"work"}));
+    ::unlink(path.data());
+}
+
+TEST(AutocompleteTest, CompleteWordLetsTheTriggerThrough) {
+    using namespace fs8; // NOLINT(*-build-using-namespace)
+
+    static constexpr std::string_view path = "/tmp/foresight-autocomplete-complete-test.tsv";
+    std::ofstream{path.data()} << "the\t100\nthen\t30\nwork\t9\n";
+
+    captured_events.clear();
+    // "the" is the best word for "the" itself, so Tab types "then"'s "n";
+    // after "work", which nothing goes on from, Tab reaches the app.
+    (context
+     | emit_all[{
+       {.type = EV_KEY,   .code = KEY_T, .value = 1},
+       {.type = EV_KEY,   .code = KEY_H, .value = 1},
+       {.type = EV_KEY,   .code = KEY_E, .value = 1},
+       {.type = EV_KEY, .code = KEY_TAB, .value = 1},
+       {.type = EV_KEY, .code = KEY_SPACE, .value = 1},
+       {.type = EV_KEY,   .code = KEY_W, .value = 1},
+       {.type = EV_KEY,   .code = KEY_O, .value = 1},
+       {.type = EV_KEY,   .code = KEY_R, .value = 1},
+       {.type = EV_KEY,   .code = KEY_K, .value = 1},
+       {.type = EV_KEY, .code = KEY_TAB, .value = 1},
+    }]
+     | autocomplete.from(path)
+     | record[captured_events])();
+
+    auto const keys = key_events(to_user_events(captured_events));
+    EXPECT_EQ(keys,
+              (std::vector<std::array<int, 3>>{
+                {EV_KEY,     KEY_T, 1},
+                {EV_KEY,     KEY_H, 1},
+                {EV_KEY,     KEY_E, 1},
+                {EV_KEY,     KEY_N, 1},
+                {EV_KEY,     KEY_N, 0},
+                {EV_KEY, KEY_SPACE, 1},
+                {EV_KEY,     KEY_W, 1},
+                {EV_KEY,     KEY_O, 1},
+                {EV_KEY,     KEY_R, 1},
+                {EV_KEY,     KEY_K, 1},
+                {EV_KEY,   KEY_TAB, 1},
+    }));
+    ::unlink(path.data());
+}
@@ -48,3 +48,44 @@ TEST(BenchmarkTest, ResultActionReportsBenchmarks) {
 
     EXPECT_EQ(reported_calls, 1U);
 }
+
+TEST(BenchmarkTest, PercentilesStayWithinTheirBucket) {
+    using std::chrono::microseconds;
+    using std::chrono::nanoseconds;
+
+    benchmark_stats stats;
+    for (int index = 1; index <= 1000; ++index) {
+        stats.record(microseconds{index});
+    }
+
+    auto const near = [](nanoseconds const got, nanoseconds const want) noexcept {
+        return got >= want && got - want <= want / 32;
+    };
+    EXPECT_PRED2(near, stats.percentile(50), microseconds{500});
+    EXPECT_PRED2(near, stats.percentile(90), microseconds{900});
+    EXPECT_PRED2(near, stats.percentile(99), microseconds{990});
+    EXPECT_PRED2(near, stats.percentile(99.9), microseconds{999});
+    EXPECT_LT(stats.percentile(99.9), microseconds{1000});
+    EXPECT_EQ(stats.percentile(100), stats.max);
+
+    latency_histogram exact;
+    exact.record(nanoseconds{42});
+    EXPECT_EQ(exact.percentile(50), nanoseconds{42});
+}
+
+TEST(BenchmarkTest, WindowOnlyHoldsRecentCalls) {
+    using namespace std::chrono_literals;
+    using clock = basic_benchmark_counter::clock;
+
+    basic_benchmark_counter counter;
+    counter.window(1s);
+    counter.record(10us, clock::now() - 1h);
+    counter.record(20us, clock::now());
+
+    EXPECT_EQ(counter.result().calls, 2U);
+    EXPECT_EQ(counter.window_result().calls, 1U);
+    EXPECT_EQ(counter.window_result().max, 20us);
+
+    counter.clear();
+    EXPECT_EQ(counter.window_result().calls, 0U);
+}
@@ -0,0 +1,47 @@
+// Created by moisrex on 10/17/26.
+
+#ifndef FORESIGHT_TESTS_FEED_THEN_WAIT_HPP
+#define FORESIGHT_TESTS_FEED_THEN_WAIT_HPP
+
+// Include it after `import fs8.mods;`.
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace fs8::tests {
+
+    /// Feeds its events at once, then keeps the pipeline waiting on io_manager
+    /// until `give_up` passes, so the timers of the mods get to go off.
+    struct feed_then_wait {
+        std::array<user_event, 8> events{};
+        std::size_t               count   = 0;
+        std::size_t               index   = 0;
+        std::chrono::milliseconds give_up = std::chrono::milliseconds{150};
+        timer_clock::time_point   deadline{};
+
+        context_action operator()(Context auto& ctx, start_tag) noexcept {
+            deadline = timer_clock::now() + give_up;
+            return ctx.mod(io_manager).wake_at(deadline) ? context_action::next : context_action::exit;
+        }
+
+        context_action operator()(Context auto& ctx, next_event_tag) noexcept {
+            if (index == count) {
+                return context_action::ignore_event;
+            }
+            ctx.event(event_type{events[index++]});
+            return context_action::next;
+        }
+
+        context_action operator()(timer_tag) const noexcept {
+            return timer_clock::now() >= deadline ? context_action::exit : context_action::next;
+        }
+
+        context_action operator()(Context auto&) noexcept {
+            return context_action::next;
+        }
+    };
+
+} // namespace fs8::tests
+
+#endif // FORESIGHT_TESTS_FEED_THEN_WAIT_HPP
@@ -2,6 +2,7 @@
 
 #include "./common/tests_common_pch.hpp"
 
+#include <array>
 #include <chrono>
 #include <fcntl.h>
 #include <libevdev/libevdev.h>
@@ -248,6 +249,125 @@ TEST(DeviceTest, FromInputMarksStdin) {
     EXPECT_EQ(captured_events.at(1).source(), device_id::stdin);
 }
 
+// A record split across two reads is put back together, and every event
+// arrives in order.
+TEST(DeviceTest, BatchedFromInputJoinsSplitRecords) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    int const saved_stdin = ::dup(STDIN_FILENO);
+    ASSERT_GE(saved_stdin, 0);
+    ASSERT_EQ(::dup2(fds[0], STDIN_FILENO), STDIN_FILENO);
+
+    std::array<input_event, 3> events{};
+    events[0].type  = EV_KEY;
+    events[0].code  = KEY_A;
+    events[0].value = 1;
+    events[1].type  = EV_KEY;
+    events[1].code  = KEY_B;
+    events[1].value = 1;
+    events[2].type  = EV_SYN;
+    events[2].code  = SYN_REPORT;
+
+    // One and a half events first, the rest a bit later.
+    auto const* bytes = reinterpret_cast<char const*>(events.data());
+    auto const  split = sizeof(input_event) + sizeof(input_event) / 2;
+    std::thread writer{[&] {
+        EXPECT_EQ(::write(fds[1], bytes, split), static_cast<ssize_t>(split));
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        auto const rest = sizeof(events) - split;
+        EXPECT_EQ(::write(fds[1], bytes + split, rest), static_cast<ssize_t>(rest));
+        ::close(fds[1]);
+    }};
+
+    captured_events.clear();
+    auto pipeline = context | from_input[io_buffering::batched] | record[captured_events];
+    pipeline();
+    writer.join();
+
+    ASSERT_EQ(::dup2(saved_stdin, STDIN_FILENO), STDIN_FILENO);
+    ::close(saved_stdin);
+    ::close(fds[0]);
+
+    ASSERT_EQ(captured_events.size(), 3U);
+    EXPECT_TRUE(captured_events.at(0).is(EV_KEY, KEY_A, 1));
+    EXPECT_TRUE(captured_events.at(1).is(EV_KEY, KEY_B, 1));
+    EXPECT_TRUE(captured_events.at(2).is(EV_SYN, SYN_REPORT));
+    EXPECT_EQ(captured_events.at(1).source(), device_id::stdin);
+}
+
+// The batched output holds the events back until their SYN_REPORT.
+TEST(DeviceTest, BatchedOutputWritesOnReport) {
+    int fds[2];
+    ASSERT_EQ(::pipe2(fds, O_NONBLOCK), 0);
+
+    auto  pipeline = context | output[io_buffering::batched];
+    auto& out      = pipeline.mod<basic_output>();
+    out.set_output(fds[1]);
+
+    std::array<input_event, 4> got{};
+    EXPECT_TRUE(out.emit(EV_KEY, KEY_A, 1));
+    EXPECT_TRUE(out.emit(EV_KEY, KEY_B, 1));
+    EXPECT_LT(::read(fds[0], got.data(), sizeof(got)), 0); // nothing written yet
+
+    EXPECT_TRUE(out.emit_syn());
+    ASSERT_EQ(::read(fds[0], got.data(), sizeof(got)), static_cast<ssize_t>(3 * sizeof(input_event)));
+    EXPECT_EQ(got[0].code, KEY_A);
+    EXPECT_EQ(got[1].code, KEY_B);
+    EXPECT_EQ(got[2].code, SYN_REPORT);
+
+    // A partial frame goes out on flush.
+    EXPECT_TRUE(out.emit(EV_KEY, KEY_A, 0));
+    EXPECT_TRUE(out.flush());
+    EXPECT_EQ(::read(fds[0], got.data(), sizeof(got)), static_cast<ssize_t>(sizeof(input_event)));
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// Two foresight ends of a pipe switch to a shared ring, and nothing is lost
+// or reordered on the way.
+TEST(DeviceTest, SharedMemoryTransportKeepsTheOrder) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    int const saved_stdin = ::dup(STDIN_FILENO);
+    ASSERT_GE(saved_stdin, 0);
+    ASSERT_EQ(::dup2(fds[0], STDIN_FILENO), STDIN_FILENO);
+    ::close(fds[0]);
+
+    constexpr int frames = 20;
+
+    captured_events.clear();
+    auto reader = context | from_input[io_buffering::batched][io_transport::shared_memory] | record[captured_events];
+    std::thread reading{[&reader] {
+        reader();
+    }};
+
+    bool used_ring = false;
+    {
+        auto  writer = context | output[io_buffering::batched][io_transport::shared_memory];
+        auto& out    = writer.mod<basic_output>();
+        out.set_output(fds[1]);
+        for (int i = 0; i < frames; ++i) {
+            EXPECT_TRUE(out.emit(EV_REL, REL_X, i));
+            EXPECT_TRUE(out.emit_syn());
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        }
+        used_ring = out.shares_memory();
+        ::close(fds[1]);
+    }
+    reading.join();
+
+    ASSERT_EQ(::dup2(saved_stdin, STDIN_FILENO), STDIN_FILENO);
+    ::close(saved_stdin);
+
+    EXPECT_TRUE(used_ring);
+    ASSERT_EQ(captured_events.size(), static_cast<std::size_t>(frames) * 2U);
+    for (int i = 0; i < frames; ++i) {
+        EXPECT_TRUE(captured_events.at(static_cast<std::size_t>(i) * 2U).is(EV_REL, REL_X, i));
+        EXPECT_TRUE(captured_events.at((static_cast<std::size_t>(i) * 2U) + 1U).is(EV_SYN, SYN_REPORT));
+    }
+}
+
 TEST(DeviceTest, InterceptMarksDeviceSource) {
     if (!input_available()) {
         GTEST_SKIP() << "No /dev/uinput access or udev daemon is not active.";
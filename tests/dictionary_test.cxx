@@ -0,0 +1,116 @@
+// Created by moisrex on 10/17/26.
+
+#include "./common/tests_common_pch.hpp"
+
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+import fs8.lib.dictionary;
+
+using namespace fs8;
+
+namespace {
+    constexpr std::string_view dictionary_path = "/tmp/foresight-dictionary-test.tsv";
+
+    [[nodiscard]] bool open_with(dictionary& words, std::string_view const text, std::size_t const top = dictionary::default_top) {
+        std::ofstream{dictionary_path.data()} << text;
+        auto const opened = words.open(dictionary_path, top);
+        ::unlink(dictionary_path.data());
+        return opened;
+    }
+
+    void type(dictionary const& words, dictionary::cursor& at, std::u32string_view const text) {
+        for (auto const code : text) {
+            words.push(at, code);
+        }
+    }
+
+    [[nodiscard]] std::vector<std::string_view> completions(dictionary const& words, dictionary::cursor const& at) {
+        std::vector<std::string_view> result;
+        for (auto const id : words.completions(at)) {
+            result.push_back(words.word(id));
+        }
+        return result;
+    }
+} // namespace
+
+TEST(DictionaryTest, RanksByFrequency) {
+    dictionary words;
+    ASSERT_TRUE(open_with(words,
+                          "# a comment\n"
+                          "their\t40\n"
+                          "the\t100\n"
+                          "then\t30\r\n"
+                          "there\t40\n"
+                          "them\tmany\n" // not a frequency
+                          "theory\n"     // 1
+                          "then\t20\n"   // 50, with the one above
+                          "\n",
+                          3));
+    EXPECT_EQ(words.size(), 5U);
+
+    dictionary::cursor at;
+    EXPECT_TRUE(completions(words, at).empty());
+    type(words, at, U"th");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"the", "then", "their"}));
+    type(words, at, U"eo");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"theory"}));
+    type(words, at, U"x");
+    EXPECT_FALSE(words.in_trie(at));
+    EXPECT_TRUE(completions(words, at).empty());
+
+    // Backspace goes back into the trie.
+    words.pop(at);
+    words.pop(at);
+    EXPECT_EQ(at.typed, "the");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"the", "then", "their"}));
+}
+
+TEST(DictionaryTest, FollowsPhrasesAndWords) {
+    dictionary words;
+    ASSERT_TRUE(open_with(words, "hello there\t5\nhello\t1\nworld\t3\nwork\t9\ncafé\t2\n"));
+
+    dictionary::cursor at;
+    type(words, at, U"hello th");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"hello there"}));
+
+    // "hello w" isn't a phrase, so "w" starts a new word.
+    dictionary::reset(at);
+    type(words, at, U"hello wo");
+    EXPECT_EQ(at.typed, "wo");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"work", "world"}));
+
+    dictionary::reset(at);
+    type(words, at, U"caf");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"café"}));
+    type(words, at, U"é");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"café"}));
+    words.pop(at);
+    EXPECT_EQ(at.typed, "caf");
+}
+
+TEST(DictionaryTest, KeepsTheBestOfManyWords) {
+    // Every word of 3 letters from "abcdefghij", the frequency is its number.
+    std::string text;
+    for (int i = 0; i < 1'000; ++i) {
+        text += static_cast<char>('a' + (i / 100));
+        text += static_cast<char>('a' + ((i / 10) % 10));
+        text += static_cast<char>('a' + (i % 10));
+        text += '\t' + std::to_string(i) + '\n';
+    }
+    dictionary words;
+    ASSERT_TRUE(open_with(words, text, 2));
+    EXPECT_EQ(words.size(), 1'000U);
+
+    dictionary::cursor at;
+    type(words, at, U"c");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"cjj", "cji"}));
+    type(words, at, U"a");
+    EXPECT_EQ(completions(words, at), (std::vector<std::string_view>{"caj", "cai"}));
+    EXPECT_EQ(words.frequency(words.completions(at).front()), 209U);
+
+    EXPECT_FALSE(dictionary{}.open("/tmp/foresight-no-such-dictionary.tsv"));
+}
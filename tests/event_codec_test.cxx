@@ -0,0 +1,135 @@
+// Created by moisrex on 10/17/26.
+
+#include "./common/tests_common_pch.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <linux/input-event-codes.h>
+#include <span>
+#include <vector>
+
+import fs8.event;
+import fs8.lib.event_codec;
+
+using namespace fs8;
+
+namespace {
+    [[nodiscard]] event_type event_at(
+      std::int64_t const          time,
+      event_type::type_type const type,
+      event_type::code_type const code,
+      int const                   value,
+      device_id const             source) noexcept {
+        input_event raw{};
+        raw.time.tv_sec  = time / 1'000'000;
+        raw.time.tv_usec = time % 1'000'000;
+        raw.type         = type;
+        raw.code         = code;
+        raw.value        = value;
+        event_type event{raw};
+        event.source(source);
+        return event;
+    }
+
+    /// A mouse moving about, and a few key presses from a keyboard.
+    [[nodiscard]] std::vector<event_type> sample_events() {
+        auto const mouse    = hashed_device("event5");
+        auto const keyboard = hashed_device("event3");
+
+        std::vector<event_type> events;
+        std::int64_t            time = 1'700'000'000'000'000;
+        for (int i = 0; i < 2'000; ++i) {
+            time += 1'000 + (i % 7);
+            if (i % 20 == 0) {
+                events.push_back(event_at(time, EV_KEY, static_cast<event_type::code_type>(KEY_A + (i % 9)), (i / 20) % 2, keyboard));
+                events.push_back(event_at(time, EV_SYN, SYN_REPORT, 0, keyboard));
+                continue;
+            }
+            events.push_back(event_at(time, EV_REL, REL_X, (i % 5) - 2, mouse));
+            events.push_back(event_at(time, EV_REL, REL_Y, 2 - (i % 3), mouse));
+            events.push_back(event_at(time, EV_SYN, SYN_REPORT, 0, mouse));
+        }
+        return events;
+    }
+
+    void expect_same(event_type const& lhs, event_type const& rhs) {
+        EXPECT_EQ(lhs.type(), rhs.type());
+        EXPECT_EQ(lhs.code(), rhs.code());
+        EXPECT_EQ(lhs.value(), rhs.value());
+        EXPECT_EQ(lhs.source(), rhs.source());
+        EXPECT_EQ(lhs.micro_time(), rhs.micro_time());
+    }
+
+    [[nodiscard]] std::vector<event_type> decode_all(std::span<std::byte const> bytes) {
+        event_decoder           decoder;
+        std::vector<event_type> events;
+        event_type              event;
+        while (!bytes.empty()) {
+            auto const read = decoder.decode(bytes, event);
+            if (read == 0) {
+                break;
+            }
+            events.push_back(event);
+            bytes = bytes.subspan(read);
+        }
+        return events;
+    }
+} // namespace
+
+TEST(EventCodec, RoundTrips) {
+    auto const events = sample_events();
+
+    event_encoder          encoder;
+    std::vector<std::byte> bytes;
+    for (auto const& event : events) {
+        encoder.encode(event, bytes);
+    }
+
+    auto const decoded = decode_all(bytes);
+    ASSERT_EQ(decoded.size(), events.size());
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        expect_same(decoded[i], events[i]);
+    }
+
+    // At least 5x smaller than the `input_event`s.
+    EXPECT_LE(bytes.size() * 5, events.size() * sizeof(input_event)) << bytes.size() << " bytes";
+}
+
+TEST(EventCodec, SpellsOutWhatDoesntGetASymbol) {
+    // More (type, code, device) triples than there are symbols.
+    std::vector<event_type> events;
+    for (std::uint32_t i = 0; i < event_codec_symbols + 200; ++i) {
+        events.push_back(event_at(1'000 + i, EV_ABS, static_cast<event_type::code_type>(i % 64), static_cast<int>(i), static_cast<device_id>(i / 64)));
+    }
+    events.push_back(events.back()); // not a symbol, again
+
+    event_encoder          encoder;
+    std::vector<std::byte> bytes;
+    for (auto const& event : events) {
+        encoder.encode(event, bytes);
+    }
+    auto const decoded = decode_all(bytes);
+    ASSERT_EQ(decoded.size(), events.size());
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        expect_same(decoded[i], events[i]);
+    }
+}
+
+TEST(EventCodec, WaitsForAWholeEvent) {
+    event_encoder                                 encoder;
+    std::array<std::byte, max_encoded_event_size> bytes{};
+    auto const                                    size = encoder.encode(event_at(1'234'567, EV_REL, REL_WHEEL, -1, device_id::self), bytes);
+    ASSERT_GT(size, 1U);
+
+    event_decoder decoder;
+    event_type    event;
+    EXPECT_EQ(decoder.decode(std::span{bytes}.first(size - 1), event), 0U);
+    ASSERT_EQ(decoder.decode(std::span{bytes}.first(size), event), size);
+    EXPECT_TRUE(event.is(EV_REL, REL_WHEEL));
+    EXPECT_EQ(event.value(), -1);
+
+    // No room.
+    std::array<std::byte, 4> small{};
+    EXPECT_EQ(encoder.encode(event, small), 0U);
+}
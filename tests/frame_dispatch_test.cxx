@@ -0,0 +1,208 @@
+#include "common/tests_common_pch.hpp"
+
+#include <array>
+#include <linux/input-event-codes.h>
+#include <utility>
+import fs8.mods;
+
+using namespace fs8;
+
+namespace {
+
+    std::size_t frame_calls = 0; // NOLINT(*-global-variables)
+    std::size_t event_calls = 0; // NOLINT(*-global-variables)
+    std::size_t last_size   = 0; // NOLINT(*-global-variables)
+
+    /// Counts how it's called; leaves the frames alone.
+    struct frame_counter {
+        static constexpr bool handles_frames = true;
+
+        context_action operator()(event_frame const frame, frame_tag) noexcept {
+            ++frame_calls;
+            last_size = frame.size();
+            return context_action::next;
+        }
+
+        context_action operator()(Context auto&) noexcept {
+            ++event_calls;
+            return context_action::next;
+        }
+    };
+
+    /// Turns every key press of a frame into a single REL_X of their count.
+    struct keys2rel {
+        static constexpr bool handles_frames = true;
+
+        context_action operator()(event_frame frame, frame_tag) noexcept {
+            event_type::value_type presses = 0;
+            for (auto const& event : frame) {
+                if (event.type() == EV_KEY && event.value() == 1) {
+                    ++presses;
+                }
+            }
+            frame.erase_if([](event_type const& event) noexcept {
+                return event.type() == EV_KEY;
+            });
+            if (presses > 0) {
+                std::ignore = frame.emit(event_type{EV_REL, REL_X, presses});
+            }
+            return context_action::next;
+        }
+
+        context_action operator()(Context auto&) noexcept {
+            return context_action::next;
+        }
+    };
+
+    /// Hands out its events, then has nothing more; there's no waiting for more.
+    struct two_frames_and_a_half {
+        std::array<event_type, 5> events{
+          {{EV_ABS, ABS_X, 1}, {EV_SYN, SYN_REPORT, 0}, {EV_ABS, ABS_X, 2}, {EV_SYN, SYN_REPORT, 0}, {EV_ABS, ABS_X, 3}}
+        };
+        std::size_t index = 0;
+
+        context_action operator()(Context auto& ctx, next_event_tag) noexcept {
+            if (index == events.size()) {
+                return context_action::ignore_event;
+            }
+            ctx.event(events[index++]);
+            return context_action::next;
+        }
+
+        context_action operator()(Context auto&) noexcept {
+            return context_action::next;
+        }
+    };
+
+    /// Quits at the first frame that isn't finished.
+    struct exit_on_partial_frame {
+        static constexpr bool handles_frames = true;
+
+        context_action operator()(event_frame const frame, frame_tag) noexcept {
+            for (auto const& event : frame) {
+                if (event.is(EV_SYN, SYN_REPORT)) {
+                    return context_action::next;
+                }
+            }
+            return context_action::exit;
+        }
+
+        context_action operator()(Context auto&) noexcept {
+            return context_action::next;
+        }
+    };
+
+    /// Holds the events back like a batched output, until it's flushed.
+    struct holder {
+        std::size_t held    = 0;
+        std::size_t flushed = 0;
+
+        context_action operator()(Context auto&) noexcept {
+            ++held;
+            return context_action::ignore_event;
+        }
+
+        void operator()(flush_tag) noexcept {
+            flushed += std::exchange(held, 0);
+        }
+    };
+
+    void reset_counters() {
+        frame_calls = 0;
+        event_calls = 0;
+        last_size   = 0;
+    }
+
+} // namespace
+
+// A frame mod is called once per SYN_REPORT frame, and the frames go on
+// unchanged and in order.
+TEST(FrameDispatchTest, OneCallPerFrame) {
+    reset_counters();
+    auto pipeline =
+      context
+      | emit_all[{
+        {EV_ABS,        ABS_X, 10},
+        {EV_ABS,        ABS_Y, 20},
+        {EV_ABS, ABS_PRESSURE, 30},
+        {EV_SYN,   SYN_REPORT,  0},
+        {EV_ABS,        ABS_X, 11},
+        {EV_SYN,   SYN_REPORT,  0},
+    }]
+      | frame_counter{}
+      | record;
+    auto& col = pipeline.mod<basic_record>();
+
+    pipeline();
+
+    EXPECT_EQ(frame_calls, 2U);
+    EXPECT_EQ(event_calls, 0U);
+    EXPECT_EQ(last_size, 2U);
+
+    auto const events = col.events();
+    ASSERT_EQ(events.size(), 6U);
+    EXPECT_TRUE(events[0].is(EV_ABS, ABS_X));
+    EXPECT_EQ(events[0].value(), 10);
+    EXPECT_TRUE(events[2].is(EV_ABS, ABS_PRESSURE));
+    EXPECT_TRUE(events[3].is(EV_SYN, SYN_REPORT));
+    EXPECT_EQ(events[4].value(), 11);
+    EXPECT_TRUE(events[5].is(EV_SYN, SYN_REPORT));
+}
+
+// Dropped events leave the frame, and emitted ones land before its report.
+TEST(FrameDispatchTest, EraseAndEmitKeepTheReportLast) {
+    auto pipeline =
+      context
+      | emit_all[{
+        {EV_KEY,      KEY_A, 1},
+        {EV_KEY,      KEY_B, 1},
+        {EV_REL,      REL_Y, 5},
+        {EV_SYN, SYN_REPORT, 0},
+    }]
+      | keys2rel{}
+      | record;
+    auto& col = pipeline.mod<basic_record>();
+
+    pipeline();
+
+    auto const events = col.events();
+    ASSERT_EQ(events.size(), 3U);
+    EXPECT_TRUE(events[0].is(EV_REL, REL_Y));
+    EXPECT_TRUE(events[1].is(EV_REL, REL_X));
+    EXPECT_EQ(events[1].value(), 2);
+    EXPECT_TRUE(events[2].is(EV_SYN, SYN_REPORT));
+}
+
+// Events after the last SYN_REPORT are not lost when the provider runs out.
+TEST(FrameDispatchTest, PartialFrameIsFlushedOnExit) {
+    reset_counters();
+    auto pipeline =
+      context
+      | emit_all[{
+        {EV_ABS,      ABS_X, 1},
+        {EV_SYN, SYN_REPORT, 0},
+        {EV_ABS,      ABS_X, 2},
+    }]
+      | frame_counter{}
+      | record;
+    auto& col = pipeline.mod<basic_record>();
+
+    pipeline();
+
+    EXPECT_EQ(frame_calls, 2U);
+    EXPECT_EQ(last_size, 1U);
+    ASSERT_EQ(col.events().size(), 3U);
+    EXPECT_EQ(col.events()[2].value(), 2);
+}
+
+// A frame mod that quits while the partial frames are pushed through doesn't
+// take what the outputs are holding back down with it.
+TEST(FrameDispatchTest, OutputsAreFlushedWhenAFrameModQuits) {
+    auto pipeline = context | two_frames_and_a_half{} | exit_on_partial_frame{} | holder{};
+    auto& held    = pipeline.mod<holder>();
+
+    pipeline();
+
+    EXPECT_EQ(held.held, 0U);
+    EXPECT_EQ(held.flushed, 4U);
+}
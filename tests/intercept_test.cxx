@@ -3,6 +3,7 @@
 #include "common/tests_common_pch.hpp"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <fcntl.h>
 #include <linux/input.h>
@@ -224,3 +225,238 @@ TEST(Interceptor, HotpluggedDeviceGetsWatchedWithoutStaleEvent) {
     uin.close();
     uin2.close();
 }
+
+TEST(Interceptor, BurstOfFramesIsDeliveredInOrder) {
+    if (!input_available()) {
+        GTEST_SKIP() << "No /dev/uinput access or udev daemon is not active.";
+    }
+
+    static constinit auto pipeline = context | io_manager | intercept[keyboard] | input_manager | record;
+
+    auto& io  = pipeline.mod<basic_io_manager>();
+    auto& im  = pipeline.mod<basic_input_manager>();
+    auto& col = pipeline.mod<basic_record>();
+
+    EXPECT_EQ(pipeline(start), context_action::next);
+
+    basic_uinput uin;
+    udev_monitor probe;
+    if (!create_uinput_keyboard(uin, probe)) {
+        GTEST_SKIP() << "Cannot create a virtual uinput keyboard.";
+    }
+
+    EXPECT_EQ(io(load_event), context_action::next);
+    if (im.devices().empty()) {
+        uin.close();
+        GTEST_SKIP() << "The uinput keyboard was not enumerated.";
+    }
+    EXPECT_EQ(invoke_first_mod_of(pipeline, pipeline.get_mods(), next_event), context_action::ignore_event);
+
+    bool grabbed = false;
+    for (auto& dev : im.devices()) {
+        if (device_sysname(dev) != sysname_of(uin.devnode())) {
+            continue;
+        }
+        dev.grab_input(true);
+        grabbed = dev.get_status() != fs8::evdev_status::grab_failure;
+        break;
+    }
+    if (!grabbed) {
+        uin.close();
+        GTEST_SKIP() << "Cannot grab the virtual keyboard before injecting events.";
+    }
+
+    // Queue several frames at once (well within the kernel's client buffer),
+    // so a single wakeup has to read them all as one batch.
+    constexpr int frames = 16;
+    int const     fd     = ::open(uin.devnode().data(), O_WRONLY | O_NONBLOCK);
+    ASSERT_GE(fd, 0);
+    for (int i = 0; i < frames; ++i) {
+        std::array<input_event, 2> frame{};
+        frame[0].type  = EV_KEY;
+        frame[0].code  = KEY_A;
+        frame[0].value = (i % 2 == 0) ? 1 : 0;
+        frame[1].type  = EV_SYN;
+        frame[1].code  = SYN_REPORT;
+        ASSERT_EQ(::write(fd, frame.data(), sizeof(frame)), static_cast<ssize_t>(sizeof(frame)));
+    }
+    ::close(fd);
+
+    col.clear();
+    EXPECT_EQ(io(load_event), context_action::next);
+    while (invoke_first_mod_of(pipeline, pipeline.get_mods(), next_event) == context_action::next) {
+        ASSERT_EQ(invoke_mods(pipeline, pipeline.get_mods()), context_action::next);
+    }
+
+    auto const keys = col.filter([](event_type const& ev) noexcept {
+        return ev.type() == EV_KEY && ev.code() == KEY_A;
+    });
+    ASSERT_EQ(keys.size(), static_cast<std::size_t>(frames));
+    for (int i = 0; i < frames; ++i) {
+        EXPECT_EQ(keys[static_cast<std::size_t>(i)].value(), (i % 2 == 0) ? 1 : 0) << "frame " << i;
+    }
+    EXPECT_GE(col.count(EV_SYN, SYN_REPORT), static_cast<std::size_t>(frames));
+
+    uin.close();
+}
+
+TEST(Interceptor, ReaderThreadDeliversFramesThroughNextEvent) {
+    if (!input_available()) {
+        GTEST_SKIP() << "No /dev/uinput access or udev daemon is not active.";
+    }
+
+    static constinit auto pipeline =
+      context | io_manager | intercept[keyboard][intercept_mode::reader_thread] | input_manager | record;
+
+    auto& io  = pipeline.mod<basic_io_manager>();
+    auto& im  = pipeline.mod<basic_input_manager>();
+    auto& ic  = pipeline.mod<basic_interceptor>();
+    auto& col = pipeline.mod<basic_record>();
+
+    EXPECT_EQ(pipeline(start), context_action::next);
+
+    basic_uinput uin;
+    udev_monitor probe;
+    if (!create_uinput_keyboard(uin, probe)) {
+        GTEST_SKIP() << "Cannot create a virtual uinput keyboard.";
+    }
+
+    EXPECT_EQ(io(load_event), context_action::next);
+    if (im.devices().empty()) {
+        uin.close();
+        GTEST_SKIP() << "The uinput keyboard was not enumerated.";
+    }
+
+    // Hands the devices to the reader thread; they're not io_manager's.
+    EXPECT_EQ(invoke_first_mod_of(pipeline, pipeline.get_mods(), next_event), context_action::ignore_event);
+    EXPECT_FALSE(io.is_watched(im.devices().front().native_handle()));
+
+    bool grabbed = false;
+    for (auto& dev : im.devices()) {
+        if (device_sysname(dev) != sysname_of(uin.devnode())) {
+            continue;
+        }
+        dev.grab_input(true);
+        grabbed = dev.get_status() != fs8::evdev_status::grab_failure;
+        break;
+    }
+    if (!grabbed) {
+        uin.close();
+        GTEST_SKIP() << "Cannot grab the virtual keyboard before injecting events.";
+    }
+
+    constexpr int frames = 16;
+    int const     fd     = ::open(uin.devnode().data(), O_WRONLY | O_NONBLOCK);
+    ASSERT_GE(fd, 0);
+    for (int i = 0; i < frames; ++i) {
+        std::array<input_event, 2> frame{};
+        frame[0].type  = EV_KEY;
+        frame[0].code  = KEY_A;
+        frame[0].value = (i % 2 == 0) ? 1 : 0;
+        frame[1].type  = EV_SYN;
+        frame[1].code  = SYN_REPORT;
+        ASSERT_EQ(::write(fd, frame.data(), sizeof(frame)), static_cast<ssize_t>(sizeof(frame)));
+    }
+    ::close(fd);
+
+    // The reader runs on its own; poll the queue through next_event.
+    col.clear();
+    auto const is_key_a = [](event_type const& ev) noexcept {
+        return ev.type() == EV_KEY && ev.code() == KEY_A;
+    };
+    for (int tries = 0; tries < 300 && col.count(is_key_a) < static_cast<std::size_t>(frames); ++tries) {
+        while (invoke_first_mod_of(pipeline, pipeline.get_mods(), next_event) == context_action::next) {
+            ASSERT_EQ(invoke_mods(pipeline, pipeline.get_mods()), context_action::next);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto const keys = col.filter(is_key_a);
+    ASSERT_EQ(keys.size(), static_cast<std::size_t>(frames));
+    for (int i = 0; i < frames; ++i) {
+        EXPECT_EQ(keys[static_cast<std::size_t>(i)].value(), (i % 2 == 0) ? 1 : 0) << "frame " << i;
+    }
+
+    auto const stats = ic.stats();
+    EXPECT_GE(stats.queue_capacity, static_cast<std::size_t>(frames * 2));
+    EXPECT_GE(stats.high_water, 2U);
+    EXPECT_EQ(stats.overflowed_frames, 0U);
+    EXPECT_EQ(stats.syn_dropped, 0U);
+
+    uin.close();
+}
+
+// A press and its release in one frame both get through the reader thread.
+TEST(Interceptor, ReaderThreadKeepsTheReleaseOfAFrame) {
+    if (!input_available()) {
+        GTEST_SKIP() << "No /dev/uinput access or udev daemon is not active.";
+    }
+
+    static constinit auto pipeline =
+      context | io_manager | intercept[keyboard][intercept_mode::reader_thread] | input_manager | record;
+
+    auto& io  = pipeline.mod<basic_io_manager>();
+    auto& im  = pipeline.mod<basic_input_manager>();
+    auto& col = pipeline.mod<basic_record>();
+
+    EXPECT_EQ(pipeline(start), context_action::next);
+
+    basic_uinput uin;
+    udev_monitor probe;
+    if (!create_uinput_keyboard(uin, probe)) {
+        GTEST_SKIP() << "Cannot create a virtual uinput keyboard.";
+    }
+
+    EXPECT_EQ(io(load_event), context_action::next);
+    if (im.devices().empty()) {
+        uin.close();
+        GTEST_SKIP() << "The uinput keyboard was not enumerated.";
+    }
+    EXPECT_EQ(invoke_first_mod_of(pipeline, pipeline.get_mods(), next_event), context_action::ignore_event);
+
+    bool grabbed = false;
+    for (auto& dev : im.devices()) {
+        if (device_sysname(dev) != sysname_of(uin.devnode())) {
+            continue;
+        }
+        dev.grab_input(true);
+        grabbed = dev.get_status() != fs8::evdev_status::grab_failure;
+        break;
+    }
+    if (!grabbed) {
+        uin.close();
+        GTEST_SKIP() << "Cannot grab the virtual keyboard before injecting events.";
+    }
+
+    std::array<input_event, 3> frame{};
+    frame[0].type  = EV_KEY;
+    frame[0].code  = KEY_A;
+    frame[0].value = 1;
+    frame[1].type  = EV_KEY;
+    frame[1].code  = KEY_A;
+    frame[1].value = 0;
+    frame[2].type  = EV_SYN;
+    frame[2].code  = SYN_REPORT;
+    int const fd   = ::open(uin.devnode().data(), O_WRONLY | O_NONBLOCK);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::write(fd, frame.data(), sizeof(frame)), static_cast<ssize_t>(sizeof(frame)));
+    ::close(fd);
+
+    col.clear();
+    auto const is_key_a = [](event_type const& ev) noexcept {
+        return ev.type() == EV_KEY && ev.code() == KEY_A;
+    };
+    for (int tries = 0; tries < 300 && col.count(is_key_a) < 2; ++tries) {
+        while (invoke_first_mod_of(pipeline, pipeline.get_mods(), next_event) == context_action::next) {
+            ASSERT_EQ(invoke_mods(pipeline, pipeline.get_mods()), context_action::next);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto const keys = col.filter(is_key_a);
+    ASSERT_EQ(keys.size(), 2U);
+    EXPECT_EQ(keys[0].value(), 1);
+    EXPECT_EQ(keys[1].value(), 0);
+
+    uin.close();
+}
@@ -331,3 +331,232 @@ TEST(IOManager, DuplicateWatchReplacesEventsMask) {
     close(fds[0]);
     close(fds[1]);
 }
+
+TEST(IOManager, UringBackendDispatchesReadyFds) {
+    basic_io_manager mgr;
+    mgr.backend(io_backend::uring);
+    ASSERT_EQ(mgr(start), context_action::next);
+    // Kernels without io_uring silently fall back to poll; either way the
+    // dispatch semantics must be the same.
+    EXPECT_TRUE(mgr.active_backend() == io_backend::uring || mgr.active_backend() == io_backend::poll);
+
+    int a[2], b[2];
+    ASSERT_EQ(pipe(a), 0);
+    ASSERT_EQ(pipe(b), 0);
+
+    read_handler ha, hb;
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = a[0]}, ha));
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = b[0]}, hb));
+
+    ASSERT_EQ(write(a[1], "a", 1), 1);
+    ASSERT_EQ(write(b[1], "b", 1), 1);
+
+    // Both may or may not be reaped in the same batch, depending on timing.
+    ASSERT_EQ(mgr(load_event), context_action::next);
+    if (ha.buf[0] == 0 || hb.buf[0] == 0) {
+        ASSERT_EQ(mgr(load_event), context_action::next);
+    }
+    EXPECT_STREQ(ha.buf.data(), "a");
+    EXPECT_STREQ(hb.buf.data(), "b");
+    EXPECT_TRUE(has(ha.info.revents, io_event::in));
+
+    // The multishot requests stay armed: a second round needs no re-watch.
+    ASSERT_EQ(write(a[1], "c", 1), 1);
+    ASSERT_EQ(mgr(load_event), context_action::next);
+    EXPECT_STREQ(ha.buf.data(), "c");
+
+    mgr.clear();
+    EXPECT_TRUE(mgr.empty());
+    close(a[0]);
+    close(a[1]);
+    close(b[0]);
+    close(b[1]);
+}
+
+TEST(IOManager, UringBackendSkipsUnwatchedInSameBatch) {
+    static constinit auto uring_pipeline = context | io_manager[io_backend::uring];
+    auto&                 mgr            = uring_pipeline.mod<basic_io_manager>();
+    EXPECT_EQ(mgr.backend(), io_backend::uring);
+    ASSERT_EQ(mgr(start), context_action::next);
+
+    int a[2], b[2];
+    ASSERT_EQ(pipe(a), 0);
+    ASSERT_EQ(pipe(b), 0);
+
+    self_unwatch_handler ha, hb;
+    ha.mgr   = &mgr;
+    ha.self  = a[0];
+    ha.other = b[0];
+    hb.mgr   = &mgr;
+    hb.self  = b[0];
+    hb.other = a[0];
+
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = a[0]}, ha));
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = b[0]}, hb));
+
+    ASSERT_EQ(write(a[1], "1", 1), 1);
+    ASSERT_EQ(write(b[1], "2", 1), 1);
+
+    ASSERT_EQ(mgr(load_event), context_action::next);
+    // Whichever handler runs first unwatches both; the other must not run.
+    EXPECT_EQ(ha.calls + hb.calls, 1);
+    EXPECT_TRUE(mgr.empty());
+
+    close(a[0]);
+    close(a[1]);
+    close(b[0]);
+    close(b[1]);
+}
+
+TEST(IOManager, EpollBackendDispatchesOnlyReadyFds) {
+    static constinit auto epoll_pipeline = context | io_manager[io_backend::epoll];
+    auto&                 mgr            = epoll_pipeline.mod<basic_io_manager>();
+    ASSERT_EQ(mgr(start), context_action::next);
+    EXPECT_EQ(mgr.active_backend(), io_backend::epoll);
+
+    int a[2], b[2];
+    ASSERT_EQ(pipe(a), 0);
+    ASSERT_EQ(pipe(b), 0);
+
+    read_handler ha, hb;
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = a[0]}, ha));
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = b[0]}, hb));
+    EXPECT_EQ(mgr.size(), 2);
+
+    ASSERT_EQ(write(b[1], "b", 1), 1);
+    ASSERT_EQ(mgr(load_event), context_action::next);
+    EXPECT_EQ(ha.buf[0], 0);
+    EXPECT_STREQ(hb.buf.data(), "b");
+    EXPECT_EQ(hb.info.fd, b[0]);
+    EXPECT_TRUE(has(hb.info.revents, io_event::in));
+
+    mgr.clear();
+    EXPECT_TRUE(mgr.empty());
+    close(a[0]);
+    close(a[1]);
+    close(b[0]);
+    close(b[1]);
+}
+
+TEST(IOManager, EpollBackendSkipsUnwatchedInSameBatch) {
+    basic_io_manager mgr;
+    mgr.backend(io_backend::epoll);
+    ASSERT_EQ(mgr(start), context_action::next);
+
+    int a[2], b[2];
+    ASSERT_EQ(pipe(a), 0);
+    ASSERT_EQ(pipe(b), 0);
+
+    self_unwatch_handler ha, hb;
+    ha.mgr   = &mgr;
+    ha.self  = a[0];
+    ha.other = b[0];
+    hb.mgr   = &mgr;
+    hb.self  = b[0];
+    hb.other = a[0];
+
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = a[0]}, ha));
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = b[0]}, hb));
+
+    ASSERT_EQ(write(a[1], "1", 1), 1);
+    ASSERT_EQ(write(b[1], "2", 1), 1);
+
+    ASSERT_EQ(mgr(load_event), context_action::next);
+    EXPECT_EQ(ha.calls + hb.calls, 1);
+    EXPECT_TRUE(mgr.empty());
+
+    close(a[0]);
+    close(a[1]);
+    close(b[0]);
+    close(b[1]);
+}
+
+TEST(IOManager, EpollBackendRewatchesReusedFd) {
+    basic_io_manager mgr;
+    mgr.backend(io_backend::epoll);
+    ASSERT_EQ(mgr(start), context_action::next);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    read_handler handler;
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = fds[0]}, handler));
+
+    // The kernel drops a closed fd from the epoll set; a new file that gets the
+    // same fd number must be watchable again.
+    int const old_fd = fds[0];
+    close(fds[0]);
+    close(fds[1]);
+    mgr.unwatch(old_fd);
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(fds[0], old_fd);
+
+    ASSERT_TRUE(mgr.watch(io_fd{.fd = fds[0]}, handler));
+    ASSERT_EQ(write(fds[1], "r", 1), 1);
+    ASSERT_EQ(mgr(load_event), context_action::next);
+    EXPECT_STREQ(handler.buf.data(), "r");
+
+    mgr.clear();
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(IOManager, SlotsAreReusedAfterUnwatch) {
+    for (auto const backend : {io_backend::poll, io_backend::epoll}) {
+        basic_io_manager mgr;
+        mgr.backend(backend);
+        ASSERT_EQ(mgr(start), context_action::next);
+
+        std::array<std::array<int, 2>, 8> pipes{};
+        std::array<read_handler, 8>       handlers{};
+        for (std::size_t i = 0; i < pipes.size(); ++i) {
+            ASSERT_EQ(pipe(pipes[i].data()), 0);
+            ASSERT_TRUE(mgr.watch(io_fd{.fd = pipes[i][0]}, handlers[i]));
+        }
+        for (std::size_t i = 0; i < pipes.size(); i += 2) {
+            mgr.unwatch(pipes[i][0]);
+        }
+        EXPECT_EQ(mgr.size(), pipes.size() / 2);
+        for (std::size_t i = 0; i < pipes.size(); i += 2) {
+            ASSERT_TRUE(mgr.watch(io_fd{.fd = pipes[i][0]}, handlers[i]));
+        }
+        EXPECT_EQ(mgr.size(), pipes.size());
+
+        ASSERT_EQ(write(pipes[4][1], "4", 1), 1);
+        ASSERT_EQ(mgr(load_event), context_action::next);
+        EXPECT_STREQ(handlers[4].buf.data(), "4");
+        EXPECT_EQ(handlers[5].buf[0], 0);
+
+        mgr.clear();
+        for (auto& [rd, wr] : pipes) {
+            close(rd);
+            close(wr);
+        }
+    }
+}
+
+TEST(IOManager, WakeAtFiresOnTheDeadline) {
+    using namespace std::chrono_literals;
+    basic_io_manager mgr;
+    ASSERT_EQ(mgr(start), context_action::next);
+    EXPECT_FALSE(mgr.next_deadline().has_value());
+
+    auto const started = timer_clock::now();
+    ASSERT_TRUE(mgr.wake_at(started + 40ms));
+    ASSERT_TRUE(mgr.wake_at(started + 20ms));
+    EXPECT_EQ(mgr.next_deadline(), started + 20ms);
+
+    // The earliest deadline wakes the wait up, and only that one is dropped.
+    ASSERT_EQ(mgr(load_event), context_action::next);
+    EXPECT_GE(timer_clock::now() - started, 20ms);
+    EXPECT_EQ(mgr.next_deadline(), started + 40ms);
+
+    ASSERT_EQ(mgr(load_event), context_action::next);
+    EXPECT_GE(timer_clock::now() - started, 40ms);
+    EXPECT_FALSE(mgr.next_deadline().has_value());
+
+    // A restart drops the deadlines of the previous run.
+    ASSERT_TRUE(mgr.wake_at(timer_clock::now() + 1h));
+    ASSERT_EQ(mgr(start), context_action::next);
+    EXPECT_FALSE(mgr.next_deadline().has_value());
+    mgr.clear();
+}
@@ -0,0 +1,111 @@
+// Created by moisrex on 10/17/26.
+
+#include "./common/tests_common_pch.hpp"
+
+#include <fcntl.h>
+#include <format>
+#include <linux/input-event-codes.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+import fs8.mods;
+import dynamic_scoping;
+
+using namespace fs8;
+
+namespace {
+    std::vector<std::string> report_lines; // NOLINT(*-global-variables)
+
+    constexpr auto capture_report = []<typename... Args>(std::format_string<Args...> fmt, Args&&... args) noexcept {
+        report_lines.push_back(std::format(fmt, std::forward<Args>(args)...));
+    };
+
+    [[nodiscard]] bool has_line(std::string_view const prefix) noexcept {
+        return std::ranges::any_of(report_lines, [&](std::string const& line) noexcept {
+            return line.starts_with(prefix);
+        });
+    }
+} // namespace
+
+// The events `emit` forks off are charged to the event that caused them.
+TEST(LatencyTraceTest, ChargesForkedEventsToTheirTrigger) {
+    int fds[2];
+    ASSERT_EQ(::pipe2(fds, O_NONBLOCK), 0);
+
+    auto pipeline =
+      context
+      | emit_all[{
+        {.type = EV_KEY,      .code = KEY_A, .value = 1},
+        {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+    }]
+      | latency_trace[context | emit[down(KEY_B)] | output];
+    for (basic_output& out : pipeline.rmods(output)) {
+        out.set_output(fds[1]);
+    }
+
+    pipeline();
+
+    std::array<input_event, 8> got{};
+    ASSERT_EQ(::read(fds[0], got.data(), sizeof(got)), static_cast<ssize_t>(4 * sizeof(input_event)));
+
+    report_lines.clear();
+    auto report = latency_report[capture_report];
+    report(pipeline);
+
+    EXPECT_TRUE(has_line("latency of self: events=2 "));
+    EXPECT_TRUE(has_line("latency to output: events=4 "));
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// Nothing is traced outside of a `latency_trace`.
+TEST(LatencyTraceTest, OutputsOutsideOfATraceAreLeftAlone) {
+    EXPECT_FALSE(is_tracing());
+
+    basic_latency_recorder recorder;
+    {
+        auto          trigger = recorder.ingress(event_type{EV_KEY, KEY_A, 1});
+        dynamic_scope scope{traced_event, trigger};
+        EXPECT_TRUE(is_tracing());
+        trace_egress(&recorder, "somewhere");
+    }
+    EXPECT_FALSE(is_tracing());
+    trace_egress(&recorder, "somewhere");
+
+    std::uint64_t routed = 0;
+    recorder.for_each_route([&](latency_entry const& out, latency_entry const&) noexcept {
+        routed += out.stats.calls;
+    });
+    EXPECT_EQ(routed, 1U);
+}
+
+// A held-back event is stamped when it's written, for the event it was emitted for.
+TEST(LatencyTraceTest, HeldEventsAreStampedWhenWritten) {
+    int fds[2];
+    ASSERT_EQ(::pipe2(fds, O_NONBLOCK), 0);
+
+    basic_latency_recorder recorder;
+    auto const             routed = [&]() noexcept {
+        std::uint64_t calls = 0;
+        recorder.for_each_route([&](latency_entry const& out, latency_entry const&) noexcept {
+            calls += out.stats.calls;
+        });
+        return calls;
+    };
+
+    auto out = output[io_buffering::batched];
+    out.set_output(fds[1]);
+    {
+        auto          trigger = recorder.ingress(event_type{EV_KEY, KEY_A, 1});
+        dynamic_scope scope{traced_event, trigger};
+        EXPECT_TRUE(out.emit(EV_KEY, KEY_A, 1));
+        EXPECT_EQ(routed(), 0U);
+    }
+    EXPECT_TRUE(out.flush());
+    EXPECT_EQ(routed(), 1U);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
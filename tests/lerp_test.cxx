@@ -1,11 +1,15 @@
 #include "common/tests_common_pch.hpp"
 
+#include <chrono>
 #include <cstdint>
 #include <linux/input-event-codes.h>
 #include <span>
 import fs8.mods;
 
+#include "common/feed_then_wait.hpp"
+
 using namespace fs8;
+using fs8::tests::feed_then_wait;
 
 namespace {
 
@@ -36,6 +40,35 @@ namespace {
         return total;
     }
 
+    using namespace std::chrono_literals;
+
+    struct stamped {
+        event_type              event;
+        timer_clock::time_point at;
+    };
+
+    std::vector<stamped> stamps; // NOLINT(*-global-variables)
+
+    /// Records the movement it sees with the time it saw it.
+    struct stamp_recorder {
+        context_action operator()(event_type const& event) noexcept {
+            if (event.type() == EV_REL) {
+                stamps.push_back({event, timer_clock::now()});
+            }
+            return context_action::next;
+        }
+    };
+
+    std::int32_t stamped_sum(std::uint16_t const code) {
+        std::int32_t total = 0;
+        for (auto const& [event, at] : stamps) {
+            if (event.code() == code) {
+                total += event.value();
+            }
+        }
+        return total;
+    }
+
 } // namespace
 
 // Subdividing a frame must reproduce the exact input movement (drift-free) and
@@ -170,3 +203,81 @@ TEST(SmoothTest, LerpLeavesNonMovementFramesAlone) {
     EXPECT_EQ(key_frame[0].code, KEY_A);
     EXPECT_EQ(key_frame[1].type, EV_SYN);
 }
+
+// Paced steps go out over the frame interval, not all at once, and still add
+// up to the input.
+TEST(SmoothTest, PacedLerpSpreadsTheSteps) {
+    stamps.clear();
+    auto pipeline =
+      context
+      | io_manager
+      | feed_then_wait{
+        .events  = {{{EV_REL, REL_X, 40}, {EV_REL, REL_Y, -8}, {EV_SYN, SYN_REPORT, 0}}},
+        .count   = 3,
+        .give_up = 100ms,
+    }
+      | lerp[4].paced()
+      | stamp_recorder{};
+
+    pipeline();
+
+    EXPECT_EQ(stamped_sum(REL_X), 40);
+    EXPECT_EQ(stamped_sum(REL_Y), -8);
+
+    // Four steps, about 2ms apart (the assumed 8ms frame interval / 4).
+    auto const steps = std::ranges::count_if(stamps, [](stamped const& stamp) {
+        return stamp.event.code() == REL_X && stamp.event.value() != 0;
+    });
+    EXPECT_GE(steps, 2);
+    EXPECT_LE(steps, 4);
+    ASSERT_FALSE(stamps.empty());
+    EXPECT_GE(stamps.back().at - stamps.front().at, 4ms);
+}
+
+// A frame that comes before the previous one's steps are done takes over what's
+// left of them, so nothing is lost.
+TEST(SmoothTest, PacedLerpRetargetsOnANewFrame) {
+    stamps.clear();
+    auto pipeline =
+      context
+      | io_manager
+      | feed_then_wait{
+        .events = {{
+          {EV_REL, REL_X, 40},
+          {EV_SYN, SYN_REPORT, 0},
+          {EV_REL, REL_X, 40},
+          {EV_SYN, SYN_REPORT, 0},
+        }},
+        .count   = 4,
+        .give_up = 100ms,
+    }
+      | lerp.paced()
+      | stamp_recorder{};
+
+    pipeline();
+
+    EXPECT_EQ(stamped_sum(REL_X), 80);
+}
+
+// At a display's refresh rate there are only as many steps as frames it shows.
+TEST(SmoothTest, PacedLerpAtARefreshRateEmitsFewerSteps) {
+    stamps.clear();
+    auto pipeline =
+      context
+      | io_manager
+      | feed_then_wait{
+        .events  = {{{EV_REL, REL_X, 40}, {EV_SYN, SYN_REPORT, 0}}},
+        .count   = 2,
+        .give_up = 100ms,
+    }
+      | lerp.paced(144)
+      | stamp_recorder{};
+
+    pipeline();
+
+    EXPECT_EQ(stamped_sum(REL_X), 40);
+    auto const steps = std::ranges::count_if(stamps, [](stamped const& stamp) {
+        return stamp.event.code() == REL_X && stamp.event.value() != 0;
+    });
+    EXPECT_LE(steps, 2); // ceil(8ms * 144 Hz)
+}
@@ -0,0 +1,93 @@
+#include "common/tests_common_pch.hpp"
+
+#include <chrono>
+#include <linux/input-event-codes.h>
+import fs8.mods;
+
+#include "common/feed_then_wait.hpp"
+
+using namespace fs8;
+using fs8::tests::feed_then_wait;
+using namespace std::chrono_literals;
+
+namespace {
+
+    std::vector<event_type> out; // NOLINT(*-global-variables)
+
+    [[nodiscard]] std::vector<event_type> keys_of(std::vector<event_type> const& events) {
+        std::vector<event_type> keys;
+        std::ranges::copy_if(events, std::back_inserter(keys), [](event_type const& event) {
+            return event.type() == EV_KEY;
+        });
+        return keys;
+    }
+
+} // namespace
+
+// Without io_manager the deadline is noticed on the next event.
+TEST(LongPressTest, FiresOnTheNextEventWithoutTimers) {
+    out.clear();
+    (context
+     | emit_all[{
+       {EV_KEY,   BTN_LEFT, 1},
+       {EV_SYN, SYN_REPORT, 0},
+       {EV_KEY,   BTN_LEFT, 0},
+       {EV_SYN, SYN_REPORT, 0},
+    }]
+     | long_press.hold(0us)
+     | record[out])();
+
+    auto const keys = keys_of(out);
+    ASSERT_EQ(keys.size(), 4U);
+    EXPECT_TRUE(keys[0].is(EV_KEY, BTN_LEFT, 1));
+    EXPECT_TRUE(keys[1].is(EV_KEY, BTN_LEFT, 0));
+    EXPECT_TRUE(keys[2].is(EV_KEY, BTN_RIGHT, 1));
+    EXPECT_TRUE(keys[3].is(EV_KEY, BTN_RIGHT, 0)); // the real release is swallowed
+}
+
+// With io_manager the long press fires while the button is still held and no
+// event comes in.
+TEST(LongPressTest, FiresOnTimeWithIoManager) {
+    out.clear();
+    auto pipeline =
+      context
+      | io_manager
+      | feed_then_wait{
+        .events = {{{EV_KEY, BTN_LEFT, 1}, {EV_SYN, SYN_REPORT, 0}}},
+        .count  = 2,
+    }
+      | long_press.hold(20ms)
+      | record[out];
+
+    auto const started = timer_clock::now();
+    pipeline();
+    EXPECT_GE(timer_clock::now() - started, 150ms);
+
+    auto const keys = keys_of(out);
+    ASSERT_EQ(keys.size(), 4U);
+    EXPECT_TRUE(keys[0].is(EV_KEY, BTN_LEFT, 1));
+    EXPECT_TRUE(keys[1].is(EV_KEY, BTN_LEFT, 0));
+    EXPECT_TRUE(keys[2].is(EV_KEY, BTN_RIGHT, 1));
+    EXPECT_TRUE(keys[3].is(EV_KEY, BTN_RIGHT, 0));
+}
+
+// Moving past the tolerance makes it a drag; the timer then does nothing.
+TEST(LongPressTest, DragIsLeftAlone) {
+    out.clear();
+    auto pipeline =
+      context
+      | io_manager
+      | feed_then_wait{
+        .events = {{{EV_KEY, BTN_LEFT, 1}, {EV_SYN, SYN_REPORT, 0}, {EV_REL, REL_X, 10}, {EV_SYN, SYN_REPORT, 0}}},
+        .count  = 4,
+        .give_up = 80ms,
+    }
+      | long_press.hold(20ms)
+      | record[out];
+
+    pipeline();
+
+    auto const keys = keys_of(out);
+    ASSERT_EQ(keys.size(), 1U);
+    EXPECT_TRUE(keys[0].is(EV_KEY, BTN_LEFT, 1));
+}
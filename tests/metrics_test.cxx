@@ -0,0 +1,95 @@
+// Created by moisrex on 10/17/26.
+
+#include "./common/tests_common_pch.hpp"
+
+#include <linux/input-event-codes.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+import fs8.mods;
+import fs8.metrics;
+
+using namespace fs8;
+
+// The counters link themselves in, whoever defines them.
+TEST(MetricsTest, NamedCountersAreListed) {
+    static named_counter counter{"metrics_test_counter"};
+    counter.count.add(3);
+
+    bool found = false;
+    for (auto const* cur = named_counter::first(); cur != nullptr; cur = cur->next) {
+        if (cur->name == "metrics_test_counter") {
+            EXPECT_EQ(cur->count.load(), 3);
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST(MetricsTest, CountsEventsAndDrops) {
+    auto const before = dropped_by<basic_ignore_mouse_moves>.count.load();
+
+    auto pipeline =
+      context
+      | emit_all[{
+        {.type = EV_REL,      .code = REL_X, .value = 3},
+        {.type = EV_REL,      .code = REL_Y, .value = 4},
+        {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+    }]
+      | metrics
+      | ignore_mouse_moves;
+    pipeline();
+
+    EXPECT_EQ(dropped_by<basic_ignore_mouse_moves>.count.load(), before + 2);
+
+    auto const text = pipeline.mod(metrics).snapshot();
+    EXPECT_TRUE(text.contains("foresight_events_total{device=\"self\"} 3\n")) << text;
+    EXPECT_TRUE(text.contains("foresight_dropped_events_total{mod=\"basic_ignore_mouse_moves\"} ")) << text;
+    EXPECT_TRUE(text.contains("foresight_sanitizer_issues_total{issue=\"orphan_release\"} ")) << text;
+}
+
+TEST(MetricsTest, DropsAreCountedOnlyWithMetrics) {
+    auto const before = dropped_by<basic_ignore_mouse_moves>.count.load();
+
+    auto pipeline =
+      context
+      | emit_all[{
+        {.type = EV_REL,      .code = REL_X, .value = 3},
+        {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+    }]
+      | ignore_mouse_moves;
+    pipeline();
+
+    EXPECT_EQ(dropped_by<basic_ignore_mouse_moves>.count.load(), before);
+}
+
+TEST(MetricsTest, ServesTheSocket) {
+    static constexpr std::string_view path = "@foresight-metrics-test";
+
+    auto  pipeline = context | io_manager | metrics.at(path);
+    auto& io       = pipeline.mod(io_manager);
+    io.clear();
+    ASSERT_EQ(pipeline.mod(metrics).start(&io, nullptr), context_action::next);
+
+    int const client = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_NE(client, -1);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::ranges::copy(path.substr(1), std::begin(addr.sun_path) + 1);
+    auto const len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+    ASSERT_EQ(::connect(client, reinterpret_cast<sockaddr const*>(&addr), len), 0);
+
+    ASSERT_EQ(io(load_event), context_action::next);
+
+    std::string            text;
+    std::array<char, 4096> buf{};
+    for (ssize_t got = 0; (got = ::read(client, buf.data(), buf.size())) > 0;) {
+        text.append(buf.data(), static_cast<std::size_t>(got));
+    }
+    ::close(client);
+
+    EXPECT_TRUE(text.starts_with("# HELP foresight_events_total ")) << text;
+    EXPECT_TRUE(text.contains("# TYPE foresight_dropped_events_total counter\n")) << text;
+}
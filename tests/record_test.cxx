@@ -2,9 +2,14 @@
 
 #include "./common/tests_common_pch.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <linux/input-event-codes.h>
+#include <optional>
+#include <unistd.h>
 
 import fs8.mods;
+import fs8.lib.recording;
 
 using namespace fs8;
 
@@ -146,6 +151,166 @@ TEST(RecordTest, AtOutOfRangeThrows) {
     EXPECT_THROW(std::ignore = col.at(1), std::out_of_range);
 }
 
+TEST(RecordTest, RecordsIntoAFile) {
+    static constexpr std::string_view path = "/tmp/foresight-record-test.fs8e";
+    ::unlink(path.data());
+
+    auto pipeline =
+      context
+      | emit_all[{
+        {.type = EV_KEY,      .code = KEY_A, .value = 1},
+        {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+        {.type = EV_KEY,      .code = KEY_A, .value = 0},
+        {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+    }]
+      | record.to(path);
+    auto &col = pipeline.mod<basic_record>();
+
+    pipeline();
+    EXPECT_TRUE(col.empty());
+    EXPECT_EQ(col.file_size(), 4U);
+    col.close();
+
+    recording_reader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.size(), 4U);
+    recording_reader::cursor at{};
+    auto const first = reader.next(at);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_TRUE(first->is(EV_KEY, KEY_A));
+    EXPECT_EQ(first->value(), 1);
+    EXPECT_EQ(first->source(), device_id::self);
+    ::unlink(path.data());
+}
+
+TEST(RecordTest, RecordingFileSeeksAndAppends) {
+    static constexpr std::string_view path = "/tmp/foresight-recording-test.fs8e";
+    ::unlink(path.data());
+
+    constexpr std::int64_t start = 1'700'000'000'000'000;
+    constexpr int          count = 10'000; // a few blocks
+    auto const             event_at = [](std::int64_t const time, int const value) noexcept {
+        input_event raw{};
+        raw.time.tv_sec  = time / 1'000'000;
+        raw.time.tv_usec = time % 1'000'000;
+        raw.type         = EV_REL;
+        raw.code         = REL_X;
+        raw.value        = value;
+        event_type event{raw};
+        event.source(hashed_device("event9"));
+        return event;
+    };
+
+    {
+        recording_writer writer;
+        ASSERT_TRUE(writer.open(path));
+        for (int i = 0; i < count; ++i) {
+            // An hour-long pause half-way through doesn't fit a delta.
+            auto const time = start + (i * 1'000LL) + (i >= count / 2 ? 3'600'000'000LL : 0);
+            ASSERT_TRUE(writer.write(event_at(time, i)));
+        }
+    }
+    {
+        recording_writer writer;
+        ASSERT_TRUE(writer.open(path));
+        EXPECT_EQ(writer.size(), static_cast<std::uint64_t>(count));
+        ASSERT_TRUE(writer.write(event_at(start + 7'200'000'000LL, count)));
+    }
+
+    recording_reader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.size(), static_cast<std::uint64_t>(count) + 1);
+    EXPECT_GT(reader.block_count(), 2U);
+
+    recording_reader::cursor at{};
+    int                      index = 0;
+    while (auto const event = reader.next(at)) {
+        ASSERT_EQ(event->value(), index);
+        ASSERT_EQ(event->source(), hashed_device("event9"));
+        ++index;
+    }
+    EXPECT_EQ(index, count + 1);
+
+    auto       found = reader.seek(start + 3'600'000'000LL + (7'000 * 1'000LL));
+    auto const event = reader.next(found);
+    ASSERT_TRUE(event.has_value());
+    EXPECT_EQ(event->value(), 7'000);
+    EXPECT_EQ(event->micro_time().count(), start + 3'600'000'000LL + (7'000 * 1'000LL));
+    ::unlink(path.data());
+}
+
+TEST(RecordTest, KeepsTheLastEvents) {
+    auto pipeline =
+      context
+      | emit_all[{
+        {.type = EV_KEY, .code = KEY_1, .value = 1},
+        {.type = EV_KEY, .code = KEY_2, .value = 1},
+        {.type = EV_KEY, .code = KEY_3, .value = 1},
+        {.type = EV_KEY, .code = KEY_4, .value = 1},
+        {.type = EV_KEY, .code = KEY_5, .value = 1},
+        {.type = EV_KEY, .code = KEY_6, .value = 1},
+        {.type = EV_KEY, .code = KEY_7, .value = 1},
+    }]
+      | record.last(3).on_signal(0);
+    auto &col = pipeline.mod<basic_record>();
+
+    pipeline();
+    ASSERT_EQ(col.size(), 3U);
+    EXPECT_EQ(col[0].code(), KEY_5);
+    EXPECT_EQ(col[2].code(), KEY_7);
+}
+
+TEST(RecordTest, KeepsTheLastSeconds) {
+    using namespace std::chrono_literals;
+
+    auto pipeline = context | replay | record.last(1s).on_signal(0);
+    auto events   = std::vector<event_type>{};
+    for (int sec = 0; sec < 5; ++sec) {
+        input_event raw{};
+        raw.time.tv_sec = 100 + sec;
+        raw.type        = EV_KEY;
+        raw.code        = KEY_A;
+        raw.value       = sec;
+        events.emplace_back(raw);
+    }
+    pipeline.mod(replay).load(events);
+    pipeline();
+
+    auto &col = pipeline.mod<basic_record>();
+    ASSERT_EQ(col.size(), 2U); // 103s and 104s
+    EXPECT_EQ(col.front().value(), 3);
+}
+
+TEST(RecordTest, DumpsOnASanitizerIssue) {
+    static constexpr std::string_view path = "/tmp/foresight-record-dump-test.fs8e";
+    ::unlink(path.data());
+
+    auto pipeline =
+      context
+      | emit_all[{
+        {.type = EV_KEY,      .code = KEY_A, .value = 1},
+        {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+        {.type = EV_KEY,      .code = KEY_B, .value = 0}, // never pressed
+        {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+    }]
+      | event_sanitizer.diagnostics()[dump_records]
+      | record.last(16).dump_to(path).on_signal(0);
+    pipeline();
+    pipeline.mod<basic_record>().wait_for_dump();
+
+    recording_reader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.size(), 3U); // up to the orphan release
+    recording_reader::cursor at{};
+    std::optional<event_type> last;
+    while (auto const event = reader.next(at)) {
+        last = event;
+    }
+    ASSERT_TRUE(last.has_value());
+    EXPECT_TRUE(last->is(EV_KEY, KEY_B));
+    ::unlink(path.data());
+}
+
 TEST(RecordTest, RunAsMod) {
     run_events.clear();
 
@@ -0,0 +1,117 @@
+// Created by moisrex on 10/17/26.
+
+#include "./common/tests_common_pch.hpp"
+
+#include <chrono>
+#include <linux/input-event-codes.h>
+#include <unistd.h>
+
+import fs8.mods;
+import fs8.lib.recording;
+
+using namespace fs8;
+
+namespace {
+    /// What `replay[recorded_events]` plays back.
+    std::vector<fs8::event_type> recorded_events; // NOLINT(*-global-variables)
+
+    [[nodiscard]] event_type event_at(
+      std::int64_t const          time,
+      event_type::type_type const type,
+      event_type::code_type const code,
+      int const                   value) noexcept {
+        input_event raw{};
+        raw.time.tv_sec  = time / 1'000'000;
+        raw.time.tv_usec = time % 1'000'000;
+        raw.type         = type;
+        raw.code         = code;
+        raw.value        = value;
+        event_type event{raw};
+        event.source(hashed_device("event3"));
+        return event;
+    }
+} // namespace
+
+TEST(ReplayTest, ReplaysABuffer) {
+    recorded_events = {
+      event_at(1'000'000, EV_KEY, KEY_A, 1),
+      event_at(1'000'000, EV_SYN, SYN_REPORT, 0),
+      event_at(1'100'000, EV_KEY, KEY_A, 0),
+      event_at(1'100'000, EV_SYN, SYN_REPORT, 0),
+    };
+
+    auto  pipeline = context | replay[recorded_events] | record;
+    auto& col      = pipeline.mod<basic_record>();
+    pipeline();
+
+    ASSERT_EQ(col.size(), 4U);
+    EXPECT_EQ(pipeline.mod(replay).replayed(), 4U);
+    EXPECT_TRUE(col[0].is(EV_KEY, KEY_A));
+    EXPECT_EQ(col[2].value(), 0);
+    EXPECT_EQ(col[2].micro_time().count(), 1'100'000);
+    EXPECT_EQ(col[0].source(), hashed_device("event3"));
+}
+
+TEST(ReplayTest, ReplaysAnotherRecord) {
+    auto recording =
+      context
+      | emit_all[{
+        {.type = EV_KEY,      .code = KEY_B, .value = 1},
+        {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+    }]
+      | record;
+    recording();
+
+    auto pipeline = context | replay | record;
+    pipeline.mod(replay).load(recording.mod<basic_record>().events());
+    pipeline();
+
+    auto const& col = pipeline.mod<basic_record>();
+    ASSERT_EQ(col.size(), 2U);
+    EXPECT_TRUE(col[0].is(EV_KEY, KEY_B));
+    EXPECT_EQ(col[1].type(), EV_SYN);
+}
+
+TEST(ReplayTest, ReplaysAFile) {
+    static constexpr std::string_view path = "/tmp/foresight-replay-test.fs8e";
+    ::unlink(path.data());
+    {
+        recording_writer writer;
+        ASSERT_TRUE(writer.open(path));
+        for (int i = 0; i < 5'000; ++i) {
+            ASSERT_TRUE(writer.write(event_at(1'000'000 + (i * 100LL), EV_KEY, KEY_C, i % 2)));
+        }
+    }
+
+    auto pipeline = context | replay.from(path) | record;
+    pipeline();
+
+    auto const& col = pipeline.mod<basic_record>();
+    ASSERT_EQ(col.size(), 5'000U);
+    EXPECT_EQ(col[4'999].micro_time().count(), 1'000'000 + (4'999 * 100LL));
+    EXPECT_EQ(col[1].value(), 1);
+    ::unlink(path.data());
+}
+
+TEST(ReplayTest, KeepsTheRecordedTiming) {
+    recorded_events = {
+      event_at(0, EV_KEY, KEY_D, 1),
+      event_at(200'000, EV_KEY, KEY_D, 0), // 200ms later
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    // Four times as fast: 50ms.
+    auto       paced = context | replay[recorded_events].speed(4.0) | record;
+    auto const start = clock::now();
+    paced();
+    EXPECT_GE(clock::now() - start, std::chrono::milliseconds{45});
+    EXPECT_EQ(paced.mod<basic_record>().size(), 2U);
+
+    // The same through io_manager's timers.
+    auto       timed       = context | io_manager | replay[recorded_events].speed(4.0) | record;
+    auto const timed_start = clock::now();
+    timed();
+    EXPECT_GE(clock::now() - timed_start, std::chrono::milliseconds{45});
+    EXPECT_EQ(timed.mod<basic_record>().size(), 2U);
+}
@@ -0,0 +1,99 @@
+// Created by moisrex on 10/17/26.
+
+#include "common/tests_common_pch.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fcntl.h>
+#include <span>
+#include <unistd.h>
+
+import fs8.shm_ring;
+
+using namespace fs8;
+
+TEST(ShmRing, AttachedRingSeesThePushes) {
+    auto producer = shm_ring<std::uint32_t>::create(100);
+    ASSERT_TRUE(producer.is_ok());
+    EXPECT_EQ(producer.capacity(), 128U);
+
+    // What the other process would get through SCM_RIGHTS.
+    int const memfd = ::fcntl(producer.native_handle(), F_DUPFD_CLOEXEC, 0);
+    ASSERT_GE(memfd, 0);
+    auto consumer = shm_ring<std::uint32_t>::attach(memfd);
+    ASSERT_TRUE(consumer.is_ok());
+    EXPECT_EQ(consumer.capacity(), 128U);
+
+    std::array<std::uint32_t, 3> const frame{1, 2, 3};
+    ASSERT_TRUE(producer.try_push(std::span<std::uint32_t const>{frame}));
+
+    std::array<std::uint32_t, 8> out{};
+    ASSERT_EQ(consumer.pop(out), 3U);
+    EXPECT_EQ(out[0], 1U);
+    EXPECT_EQ(out[1], 2U);
+    EXPECT_EQ(out[2], 3U);
+    EXPECT_EQ(consumer.pop(out), 0U);
+}
+
+TEST(ShmRing, SpanPushIsAllOrNothing) {
+    auto ring = shm_ring<std::uint32_t>::create(4);
+    ASSERT_TRUE(ring.is_ok());
+    std::array<std::uint32_t, 3> const frame{1, 2, 3};
+    ASSERT_TRUE(ring.try_push(std::span<std::uint32_t const>{frame}));
+    EXPECT_FALSE(ring.try_push(std::span<std::uint32_t const>{frame}));
+
+    std::array<std::uint32_t, 4> out{};
+    ASSERT_EQ(ring.pop(out), 3U);
+    EXPECT_TRUE(ring.try_push(std::span<std::uint32_t const>{frame}));
+}
+
+TEST(ShmRing, SleepHandshake) {
+    auto ring = shm_ring<std::uint32_t>::create(8);
+    ASSERT_TRUE(ring.is_ok());
+    EXPECT_FALSE(ring.consumer_sleeping());
+
+    // Empty: the consumer may sleep, and the producer sees it.
+    ASSERT_TRUE(ring.prepare_sleep());
+    EXPECT_TRUE(ring.consumer_sleeping());
+    ring.woke_up();
+    EXPECT_FALSE(ring.consumer_sleeping());
+
+    // Something's in there: no sleeping.
+    std::array<std::uint32_t, 1> const item{7};
+    ASSERT_TRUE(ring.try_push(std::span<std::uint32_t const>{item}));
+    EXPECT_FALSE(ring.prepare_sleep());
+    EXPECT_FALSE(ring.consumer_sleeping());
+}
+
+TEST(ShmRing, RoomHandshake) {
+    auto ring = shm_ring<std::uint32_t>::create(4);
+    ASSERT_TRUE(ring.is_ok());
+    EXPECT_FALSE(ring.producer_sleeping());
+
+    // There's room: no sleeping.
+    EXPECT_FALSE(ring.prepare_sleep_for_room(4));
+    EXPECT_FALSE(ring.producer_sleeping());
+
+    // Full: the producer may sleep, and the consumer sees it.
+    std::array<std::uint32_t, 3> const frame{1, 2, 3};
+    ASSERT_TRUE(ring.try_push(std::span<std::uint32_t const>{frame}));
+    ASSERT_TRUE(ring.prepare_sleep_for_room(2));
+    EXPECT_TRUE(ring.producer_sleeping());
+    ring.woke_up_for_room();
+    EXPECT_FALSE(ring.producer_sleeping());
+
+    // One item left: room for three, not for four.
+    std::array<std::uint32_t, 2> out{};
+    ASSERT_EQ(ring.pop(out), 2U);
+    EXPECT_FALSE(ring.prepare_sleep_for_room(3));
+    EXPECT_TRUE(ring.prepare_sleep_for_room(4));
+    ring.woke_up_for_room();
+}
+
+TEST(ShmRing, AttachRejectsForeignMemory) {
+    int const memfd = ::memfd_create("not-a-ring", MFD_CLOEXEC);
+    ASSERT_GE(memfd, 0);
+    ASSERT_EQ(::ftruncate(memfd, 4096), 0);
+    auto const ring = shm_ring<std::uint32_t>::attach(memfd);
+    EXPECT_FALSE(ring.is_ok());
+}
@@ -0,0 +1,60 @@
+// Created by moisrex on 10/17/26.
+
+#include "./common/tests_common_pch.hpp"
+
+#include <cstdio>
+#include <linux/input-event-codes.h>
+#include <sstream>
+#include <string>
+
+import fs8.mods;
+import fs8.spans;
+
+using namespace fs8;
+
+static_assert(span_name<basic_record>() == "basic_record");
+static_assert(span_name<basic_emit<1>>() == "basic_emit");
+
+TEST(SpanTraceTest, RingKeepsTheLatestSpans) {
+    span_buffer spans;
+    spans.reserve(3);
+    for (std::int64_t index = 0; index < 5; ++index) {
+        spans.push(span_record{.name = "mod", .begin = index, .end = index + 1});
+    }
+    ASSERT_EQ(spans.size(), 3U);
+
+    std::vector<std::int64_t> begins;
+    spans.for_each([&](span_record const& span) noexcept {
+        begins.push_back(span.begin);
+    });
+    EXPECT_EQ(begins, (std::vector<std::int64_t>{2, 3, 4}));
+}
+
+// The mods a `fork_emit` runs through again show up as their own spans.
+TEST(SpanTraceTest, WritesAChromeTraceOnExit) {
+    if constexpr (!spans_enabled) {
+        GTEST_SKIP() << "Built without FORESIGHT_TRACE_SPANS.";
+    }
+    constexpr auto path = "/tmp/foresight-span-trace-test.json";
+    std::remove(path);
+    {
+        auto pipeline =
+          context
+          | emit_all[{
+            {.type = EV_KEY,      .code = KEY_A, .value = 1},
+            {.type = EV_SYN, .code = SYN_REPORT, .value = 0},
+        }]
+          | span_trace[context | emit[down(KEY_B)] | record].to(path).on_signal(0);
+        pipeline();
+    } // written when the pipeline goes away
+
+    std::ifstream     file{path};
+    std::stringstream json;
+    json << file.rdbuf();
+    auto const text = json.str();
+    EXPECT_TRUE(text.starts_with(R"({"traceEvents":[)"));
+    EXPECT_NE(text.find(R"("name":"basic_emit")"), std::string::npos);
+    EXPECT_NE(text.find(R"("name":"basic_record")"), std::string::npos);
+    EXPECT_NE(text.find(R"("ph":"X")"), std::string::npos);
+    std::remove(path);
+}
@@ -0,0 +1,84 @@
+// Created by moisrex on 10/17/26.
+
+#include "common/tests_common_pch.hpp"
+
+#include <cstdint>
+#include <span>
+#include <stop_token>
+#include <thread>
+
+import fs8.spsc_ring;
+
+using namespace fs8;
+
+TEST(SpscRing, CapacityIsRoundedToPowerOfTwo) {
+    spsc_ring<int> const ring{100};
+    EXPECT_EQ(ring.capacity(), 128U);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRing, PopsInPushOrder) {
+    spsc_ring<int> ring{8};
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(ring.try_push(i));
+    }
+    EXPECT_EQ(ring.size(), 5U);
+    for (int i = 0; i < 5; ++i) {
+        auto const val = ring.try_pop();
+        ASSERT_TRUE(val.has_value());
+        EXPECT_EQ(*val, i);
+    }
+    EXPECT_FALSE(ring.try_pop().has_value());
+}
+
+TEST(SpscRing, SpanPushIsAllOrNothing) {
+    spsc_ring<int> ring{4};
+    std::array<int, 3> const frame{1, 2, 3};
+    ASSERT_TRUE(ring.try_push(std::span<int const>{frame}));
+
+    // Only one slot is left: the whole frame must be refused.
+    EXPECT_FALSE(ring.try_push(std::span<int const>{frame}));
+    EXPECT_EQ(ring.size(), 3U);
+
+    ASSERT_EQ(ring.try_pop(), 1);
+    ASSERT_EQ(ring.try_pop(), 2);
+    EXPECT_TRUE(ring.try_push(std::span<int const>{frame}));
+    EXPECT_EQ(ring.size(), 4U);
+    EXPECT_EQ(ring.high_water(), 4U);
+}
+
+TEST(SpscRing, WrapsAroundManyTimes) {
+    spsc_ring<std::uint64_t> ring{4};
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(ring.try_push(i));
+        ASSERT_EQ(ring.try_pop(), i);
+    }
+    EXPECT_EQ(ring.high_water(), 1U);
+}
+
+TEST(SpscRing, ProducerAndConsumerThreadsAgreeOnOrder) {
+    constexpr std::uint64_t  count = 200'000;
+    spsc_ring<std::uint64_t> ring{64};
+
+    std::jthread producer{[&](std::stop_token const stop) {
+        for (std::uint64_t i = 0; i < count && !stop.stop_requested();) {
+            if (ring.try_push(i)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    std::uint64_t expected = 0;
+    while (expected < count) {
+        if (auto const val = ring.try_pop()) {
+            ASSERT_EQ(*val, expected);
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    EXPECT_TRUE(ring.empty());
+    EXPECT_LE(ring.high_water(), ring.capacity());
+}
@@ -1,8 +1,17 @@
 #include "./common/tests_common_pch.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
 #include <linux/input-event-codes.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 import fs8.mods;
+import fs8.lib.aho_table;
 import fs8.lib.mod_parser;
 
 int happened = 0;        // NOLINT
@@ -41,6 +50,203 @@ TEST(SearchTest, Basic) {
     EXPECT_TRUE(happened == 1);
 }
 
+// Far more patterns than fit a bitmask.
+TEST(SearchTest, ManyPatterns) {
+    using namespace fs8; // NOLINT(*-build-using-namespace)
+
+    basic_search_engine        engine;
+    std::vector<std::uint16_t> ids;
+    for (int i = 0; i < 500; ++i) {
+        ids.push_back(engine.emplace_pattern(std::format("x{}y", i)));
+    }
+    auto const suffix_id = engine.emplace_pattern("3y");
+
+    aho_state state{0U};
+    for (char32_t const code : std::u32string_view{U"zzx123y"}) {
+        state = engine.process(code, state);
+    }
+    EXPECT_TRUE(engine.matches(state.index(), ids[123]));
+    EXPECT_TRUE(engine.matches(state.index(), suffix_id));
+    EXPECT_FALSE(engine.matches(state.index(), ids[23]));
+    EXPECT_FALSE(engine.matches(state.index(), ids[12]));
+
+    std::vector<std::u32string> found;
+    engine.matches(state.index(), [&](std::u32string_view const pattern) {
+        found.emplace_back(pattern);
+    });
+    std::ranges::sort(found);
+    EXPECT_EQ(found, (std::vector<std::u32string>{U"3y", U"x123y"}));
+}
+
+// One scan per event, checked by every pattern.
+TEST(SearchTest, SharedScan) {
+    using namespace fs8; // NOLINT(*-build-using-namespace)
+
+    basic_search_engine engine;
+    auto const          test_id = engine.emplace_pattern("test");
+    auto const          es_id   = engine.emplace_pattern("es");
+    auto const          up_id   = engine.emplace_pattern("[t]");
+
+    auto const key = [&](event_type::code_type const code, event_type::value_type const value) {
+        engine.scan(event_type{EV_KEY, code, value});
+        return std::array{engine.matched(test_id), engine.matched(es_id), engine.matched(up_id)};
+    };
+    using result = std::array<bool, 3>;
+    EXPECT_EQ(key(KEY_T, 1), (result{false, false, false}));
+    EXPECT_EQ(key(KEY_T, 0), (result{false, false, true}));
+    EXPECT_EQ(key(KEY_E, 1), (result{false, false, false}));
+    EXPECT_EQ(key(KEY_E, 2), (result{false, false, false})); // a repeat
+    EXPECT_EQ(key(KEY_S, 1), (result{false, true, false}));
+    EXPECT_EQ(key(KEY_T, 1), (result{true, false, false}));
+    EXPECT_EQ(key(KEY_T, 0), (result{false, false, true})); // the releases are a stream of their own
+    engine.scan(event_type{EV_SYN, SYN_REPORT, 0});
+    EXPECT_EQ(engine.matched(up_id), false);
+}
+
+// The DFA of the hot path against the plain definition of a match.
+TEST(SearchTest, TransitionTable) {
+    using namespace fs8; // NOLINT(*-build-using-namespace)
+
+    std::vector<std::u32string> const patterns{U"ab", U"ba", U"aab", U"bab", U"abba", U"b", U"ñb", U"aéñ"};
+    std::u32string_view const         alphabet = U"abéñc";
+
+    basic_search_engine        engine;
+    std::vector<std::uint16_t> ids;
+    for (auto const& pattern : patterns) {
+        std::string utf8;
+        for (char32_t const code : pattern) {
+            if (code < 0x80) {
+                utf8 += static_cast<char>(code);
+            } else {
+                utf8 += static_cast<char>(0xC0 | (code >> 6U));
+                utf8 += static_cast<char>(0x80 | (code & 0x3FU));
+            }
+        }
+        ids.push_back(engine.emplace_pattern(utf8));
+    }
+
+    std::u32string typed_text;
+    aho_state      state{0U};
+    for (std::size_t i = 0; i < 20'000; ++i) {
+        auto const code = alphabet[(i * 7 + i / 3) % alphabet.size()];
+        typed_text += code;
+        state       = engine.process(code, state);
+        for (std::size_t id = 0; id < patterns.size(); ++id) {
+            ASSERT_EQ(engine.matches(state.index(), ids[id]), typed_text.ends_with(patterns[id])) << i;
+        }
+    }
+}
+
+// Patterns come and go while typing, built on the side.
+TEST(SearchTest, InsertsAndErasesOffThread) {
+    using namespace fs8; // NOLINT(*-build-using-namespace)
+
+    basic_search_engine engine;
+    auto const          test_id = engine.emplace_pattern("test");
+    auto const          es_id   = engine.emplace_pattern("es");
+
+    auto const press = [&](event_type::code_type const code) {
+        engine.scan(event_type{EV_KEY, code, 1});
+    };
+    auto const wait_for_the_builder = [&] {
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (engine.rebuilding() && std::chrono::steady_clock::now() < deadline) {
+            engine.refresh();
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        ASSERT_FALSE(engine.rebuilding());
+    };
+
+    press(KEY_T);
+    press(KEY_E);
+    auto const west_id = engine.insert_pattern("west");
+    engine.erase_pattern(es_id);
+    press(KEY_S);
+    EXPECT_FALSE(engine.matched(es_id)); // gone right away
+    wait_for_the_builder();
+
+    press(KEY_T); // what was typed before the swap still counts
+    EXPECT_TRUE(engine.matched(test_id));
+
+    press(KEY_W);
+    press(KEY_E);
+    press(KEY_S);
+    EXPECT_FALSE(engine.matched(es_id));
+    press(KEY_T);
+    EXPECT_TRUE(engine.matched(west_id));
+    EXPECT_FALSE(engine.matched(test_id));
+
+    // The id of a removed pattern is handed out again.
+    auto const st_id = engine.insert_pattern("st");
+    EXPECT_EQ(st_id, es_id);
+    EXPECT_FALSE(engine.matched(st_id)); // not built yet
+    wait_for_the_builder();
+    press(KEY_S);
+    press(KEY_T);
+    EXPECT_TRUE(engine.matched(st_id));
+}
+
+namespace {
+    constexpr std::array<std::string_view, 3> compiled_patterns{"test", "es", "héllo"};
+} // namespace
+
+// The automaton of constant patterns is the compiler's.
+TEST(SearchTest, CompiledTable) {
+    using namespace fs8; // NOLINT(*-build-using-namespace)
+
+    constexpr auto table = aho_table_of<compiled_patterns>.view();
+    static_assert(table.find("es") == 1);
+    static_assert(table.code_points(2) == U"héllo");
+
+    constexpr auto step = [](std::uint32_t const state, char32_t const code) {
+        return aho_table_of<compiled_patterns>.view().next(state, code);
+    };
+    static_assert(table.matches(step(step(step(step(0, U't'), U'e'), U's'), U't'), 0));
+    static_assert(table.matches(step(step(0, U'e'), U's'), 1));
+    static_assert(!table.matches(step(step(0, U'e'), U'x'), 1));
+
+    happened = 0;
+    (context
+     | emit_all[{
+       {.type = EV_KEY, .code = KEY_T, .value = 1},
+       {.type = EV_KEY, .code = KEY_T, .value = 0},
+       {.type = EV_KEY, .code = KEY_E, .value = 1},
+       {.type = EV_KEY, .code = KEY_E, .value = 0},
+       {.type = EV_KEY, .code = KEY_S, .value = 1},
+       {.type = EV_KEY, .code = KEY_S, .value = 0},
+       {.type = EV_KEY, .code = KEY_T, .value = 1},
+       {.type = EV_KEY, .code = KEY_T, .value = 0},
+    }]
+     | search_engine.with<compiled_patterns>()
+     | on[typed["es"], [] noexcept {
+           ++happened;
+           EXPECT_EQ(happened, 1);
+       }]
+     | on[typed["test"], [] noexcept {
+           ++happened;
+           EXPECT_EQ(happened, 2);
+       }])();
+    EXPECT_EQ(happened, 2);
+}
+
+// A pattern that's not in the table has it all built at runtime.
+TEST(SearchTest, OutgrownTable) {
+    using namespace fs8; // NOLINT(*-build-using-namespace)
+
+    auto       engine  = search_engine.with<compiled_patterns>();
+    auto const es_id   = engine.emplace_pattern("es");
+    auto const west_id = engine.emplace_pattern("west");
+    EXPECT_EQ(es_id, 1);
+
+    aho_state state{0U};
+    for (char32_t const code : std::u32string_view{U"west"}) {
+        state = engine.process(code, state);
+    }
+    EXPECT_TRUE(engine.matches(state.index(), west_id));
+    EXPECT_FALSE(engine.matches(state.index(), es_id));
+    EXPECT_FALSE(engine.matches(state.index(), 0)); // "test"
+}
+
 TEST(SearchTest, BasicStateful) {
     using namespace fs8; // NOLINT(*-build-using-namespace)
 
@@ -231,3 +231,39 @@ TEST(Uinput, VirtualDeviceChainingAppendsOrigin) {
     vdev_a.close();
     vdev_b.close();
 }
+
+TEST(Uinput, PerFrameWritesHoldUntilSynReport) {
+    auto const res = fs8::verify_access_to_uinput();
+    if (res != fs8::uinput_access_result::available) {
+        GTEST_SKIP() << "uinput is not available: " << to_string(res);
+    }
+    fs8::basic_uinput vdev;
+    if (!vdev.init(fs8::keyboard)) {
+        GTEST_SKIP() << "Cannot create a virtual keyboard.";
+    }
+    vdev.write_mode(fs8::uinput_write_mode::per_frame);
+    EXPECT_EQ(vdev.write_mode(), fs8::uinput_write_mode::per_frame);
+
+    EXPECT_TRUE(vdev.emit(EV_KEY, KEY_A, 1));
+    EXPECT_TRUE(vdev.emit(EV_MSC, MSC_SCAN, 30));
+    EXPECT_EQ(vdev.pending_events(), 2U);
+
+    // The report sends the whole frame out.
+    EXPECT_TRUE(vdev.emit_syn());
+    EXPECT_EQ(vdev.pending_events(), 0U);
+
+    // An explicit flush sends out a partial frame.
+    EXPECT_TRUE(vdev.emit(EV_KEY, KEY_A, 0));
+    EXPECT_EQ(vdev.pending_events(), 1U);
+    EXPECT_TRUE(vdev.flush());
+    EXPECT_EQ(vdev.pending_events(), 0U);
+    EXPECT_TRUE(vdev.emit_syn());
+
+    // Back to per-event writes, nothing is held.
+    vdev.write_mode(fs8::uinput_write_mode::per_event);
+    EXPECT_TRUE(vdev.emit(EV_KEY, KEY_B, 1));
+    EXPECT_EQ(vdev.pending_events(), 0U);
+    EXPECT_TRUE(vdev.emit(EV_KEY, KEY_B, 0));
+    EXPECT_TRUE(vdev.emit_syn());
+    vdev.close();
+}
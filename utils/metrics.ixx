@@ -0,0 +1,73 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+export module fs8.metrics;
+
+export namespace fs8 {
+
+    /**
+     * A counter with a single writer (the pipeline thread) that any thread may
+     * read: a relaxed load and store, no read-modify-write, so counting costs
+     * about as much as a plain `++` on every architecture we care about.
+     */
+    struct [[nodiscard]] metric_counter {
+      private:
+        std::atomic<std::uint64_t> value{0};
+
+      public:
+        constexpr metric_counter() noexcept = default;
+
+        metric_counter(metric_counter const&)            = delete;
+        metric_counter(metric_counter&&)                 = delete;
+        metric_counter& operator=(metric_counter const&) = delete;
+        metric_counter& operator=(metric_counter&&)      = delete;
+        ~metric_counter() noexcept                       = default;
+
+        void add(std::uint64_t const count = 1) noexcept {
+            value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::uint64_t load() const noexcept {
+            return value.load(std::memory_order_relaxed);
+        }
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The counters are read from other threads.");
+
+    /// A counter that links itself into a process-wide list as it's constructed,
+    /// so whatever reports them doesn't need to know where they all live.
+    struct [[nodiscard]] named_counter {
+        std::string_view name;
+        metric_counter   count;
+        named_counter*   next = nullptr;
+
+        explicit named_counter(std::string_view inp_name) noexcept;
+
+        named_counter(named_counter const&)            = delete;
+        named_counter(named_counter&&)                 = delete;
+        named_counter& operator=(named_counter const&) = delete;
+        named_counter& operator=(named_counter&&)      = delete;
+        ~named_counter() noexcept                      = default;
+
+        /// The list head; the counters are never unlinked.
+        [[nodiscard]] static named_counter const* first() noexcept;
+    };
+
+} // namespace fs8
+
+namespace fs8 {
+    // Constant-initialized, so it's there before any counter links itself in.
+    constinit std::atomic<named_counter*> named_counters{nullptr}; // NOLINT(*-avoid-non-const-global-variables)
+
+    named_counter::named_counter(std::string_view const inp_name) noexcept : name{inp_name} {
+        next = named_counters.load(std::memory_order_relaxed);
+        while (!named_counters.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    named_counter const* named_counter::first() noexcept {
+        return named_counters.load(std::memory_order_acquire);
+    }
+} // namespace fs8
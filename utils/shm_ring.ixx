@@ -0,0 +1,300 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <span>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+export module fs8.shm_ring;
+
+export namespace fs8 {
+
+    /**
+     * Bounded single-producer / single-consumer ring living in a memfd, so two
+     * processes can share it: one creates it and hands the fd over (e.g. with
+     * `SCM_RIGHTS`), the other attaches to it.
+     *
+     * The indices live in the mapping, each on its own cache line; each side
+     * keeps a cached copy of the other side's index like `spsc_ring` does.
+     *
+     * The ring doesn't block. `prepare_sleep`/`consumer_sleeping` implement the
+     * "am I about to sleep" handshake, so the producer only rings a doorbell
+     * (an eventfd, a pipe, ...) when the consumer is actually waiting for one;
+     * `prepare_sleep_for_room`/`producer_sleeping` are the same the other way
+     * around, for a producer that waits for the consumer to make room.
+     */
+    template <typename T>
+        requires(std::is_trivially_copyable_v<T>)
+    struct [[nodiscard]] shm_ring {
+        using value_type = T;
+
+      private:
+        static constexpr std::uint32_t ring_magic   = 0x66'73'38'72; // "fs8r"
+        static constexpr std::uint32_t ring_version = 2;
+        static constexpr std::size_t   line_size    = 64;
+
+        struct header {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint64_t capacity;
+            std::uint64_t item_size;
+
+            alignas(line_size) std::atomic<std::uint64_t> tail;
+            alignas(line_size) std::atomic<std::uint64_t> head;
+            alignas(line_size) std::atomic<std::uint32_t> consumer_waiting;
+            alignas(line_size) std::atomic<std::uint32_t> producer_waiting;
+        };
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The indices are shared between processes.");
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "The flags are shared between processes.");
+
+        static constexpr std::size_t slots_offset = (sizeof(header) + line_size - 1) / line_size * line_size;
+
+        int           fd       = -1;
+        void*         base     = nullptr;
+        std::size_t   map_size = 0;
+        header*       hdr      = nullptr;
+        T*            slots    = nullptr;
+        std::uint64_t mask     = 0;
+
+        // the other side's index, as last seen
+        std::uint64_t cached_head = 0;
+        std::uint64_t cached_tail = 0;
+
+        [[nodiscard]] bool map(int const inp_fd, std::size_t const size) noexcept {
+            void* const ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, inp_fd, 0);
+            if (ptr == MAP_FAILED) [[unlikely]] {
+                ::close(inp_fd);
+                return false;
+            }
+            fd       = inp_fd;
+            base     = ptr;
+            map_size = size;
+            hdr      = static_cast<header*>(ptr);
+            slots    = reinterpret_cast<T*>(static_cast<std::byte*>(ptr) + slots_offset);
+            return true;
+        }
+
+        void unmap() noexcept {
+            if (base != nullptr) {
+                ::munmap(base, map_size);
+            }
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            fd       = -1;
+            base     = nullptr;
+            map_size = 0;
+            hdr      = nullptr;
+            slots    = nullptr;
+            mask     = 0;
+        }
+
+      public:
+        constexpr shm_ring() noexcept = default;
+
+        shm_ring(shm_ring const&)            = delete;
+        shm_ring& operator=(shm_ring const&) = delete;
+
+        shm_ring(shm_ring&& other) noexcept
+          : fd{std::exchange(other.fd, -1)},
+            base{std::exchange(other.base, nullptr)},
+            map_size{std::exchange(other.map_size, 0)},
+            hdr{std::exchange(other.hdr, nullptr)},
+            slots{std::exchange(other.slots, nullptr)},
+            mask{std::exchange(other.mask, 0)},
+            cached_head{other.cached_head},
+            cached_tail{other.cached_tail} {}
+
+        shm_ring& operator=(shm_ring&& other) noexcept {
+            if (this != &other) {
+                unmap();
+                fd          = std::exchange(other.fd, -1);
+                base        = std::exchange(other.base, nullptr);
+                map_size    = std::exchange(other.map_size, 0);
+                hdr         = std::exchange(other.hdr, nullptr);
+                slots       = std::exchange(other.slots, nullptr);
+                mask        = std::exchange(other.mask, 0);
+                cached_head = other.cached_head;
+                cached_tail = other.cached_tail;
+            }
+            return *this;
+        }
+
+        ~shm_ring() noexcept {
+            unmap();
+        }
+
+        /// A new ring in a fresh memfd; `capacity` is rounded up to a power of two.
+        /// Check `is_ok()`, the memfd may not be available.
+        [[nodiscard]] static shm_ring create(std::size_t const capacity) noexcept {
+            shm_ring   ring;
+            auto const count = std::bit_ceil(std::max<std::size_t>(capacity, 2));
+            auto const size  = slots_offset + (count * sizeof(T));
+            int const  memfd = ::memfd_create("fs8-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+            if (memfd < 0) [[unlikely]] {
+                return ring;
+            }
+            if (::ftruncate(memfd, static_cast<off_t>(size)) != 0) [[unlikely]] {
+                ::close(memfd);
+                return ring;
+            }
+            // Neither side can resize the mapping under the other one.
+            static_cast<void>(::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL));
+            if (!ring.map(memfd, size)) [[unlikely]] {
+                return ring;
+            }
+            auto* const created = std::construct_at(ring.hdr);
+            created->magic      = ring_magic;
+            created->version    = ring_version;
+            created->capacity   = count;
+            created->item_size  = sizeof(T);
+            created->tail.store(0, std::memory_order_relaxed);
+            created->head.store(0, std::memory_order_relaxed);
+            created->consumer_waiting.store(0, std::memory_order_relaxed);
+            created->producer_waiting.store(0, std::memory_order_relaxed);
+            ring.mask = count - 1;
+            return ring;
+        }
+
+        /// Map a ring created by `create` in another process; takes over `memfd`.
+        /// Check `is_ok()`, the layout may not match.
+        [[nodiscard]] static shm_ring attach(int const memfd) noexcept {
+            shm_ring    ring;
+            struct stat info{};
+            if (::fstat(memfd, &info) != 0 || info.st_size < static_cast<off_t>(slots_offset)) [[unlikely]] {
+                ::close(memfd);
+                return ring;
+            }
+            auto const size = static_cast<std::size_t>(info.st_size);
+            if (!ring.map(memfd, size)) [[unlikely]] {
+                return ring;
+            }
+            auto const* const found    = ring.hdr;
+            auto const        capacity = found->capacity;
+            if (found->magic != ring_magic
+                || found->version != ring_version
+                || found->item_size != sizeof(T)
+                || !std::has_single_bit(capacity)
+                || slots_offset + (capacity * sizeof(T)) != size) [[unlikely]]
+            {
+                ring.unmap();
+                return ring;
+            }
+            ring.mask        = capacity - 1;
+            ring.cached_head = found->head.load(std::memory_order_acquire);
+            ring.cached_tail = found->tail.load(std::memory_order_acquire);
+            return ring;
+        }
+
+        [[nodiscard]] bool is_ok() const noexcept {
+            return hdr != nullptr;
+        }
+
+        /// The memfd, to be handed over to the other process.
+        [[nodiscard]] int native_handle() const noexcept {
+            return fd;
+        }
+
+        [[nodiscard]] std::size_t capacity() const noexcept {
+            return mask + 1;
+        }
+
+        // --- producer side ---
+
+        /// Push all of `items` or none of them; false when they don't fit.
+        [[nodiscard]] bool try_push(std::span<T const> const items) noexcept {
+            auto const tail = hdr->tail.load(std::memory_order_relaxed);
+            if (tail + items.size() - cached_head > capacity()) {
+                cached_head = hdr->head.load(std::memory_order_acquire);
+                if (tail + items.size() - cached_head > capacity()) [[unlikely]] {
+                    return false;
+                }
+            }
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                std::memcpy(slots + ((tail + i) & mask), items.data() + i, sizeof(T));
+            }
+            hdr->tail.store(tail + items.size(), std::memory_order_release);
+            return true;
+        }
+
+        /// Whether the consumer went to sleep waiting for the doorbell; call it
+        /// after `try_push`.
+        [[nodiscard]] bool consumer_sleeping() const noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return hdr->consumer_waiting.load(std::memory_order_relaxed) != 0;
+        }
+
+        /// Tell the consumer we're about to wait for room for `count` items.
+        /// False (and the flag is cleared again) when it made room meanwhile.
+        [[nodiscard]] bool prepare_sleep_for_room(std::size_t const count) noexcept {
+            hdr->producer_waiting.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cached_head = hdr->head.load(std::memory_order_acquire);
+            if (hdr->tail.load(std::memory_order_relaxed) + count - cached_head <= capacity()) {
+                hdr->producer_waiting.store(0, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        /// We're up again; the consumer can stop ringing.
+        void woke_up_for_room() noexcept {
+            hdr->producer_waiting.store(0, std::memory_order_relaxed);
+        }
+
+        // --- consumer side ---
+
+        /// Pop up to `out.size()` items; returns how many.
+        [[nodiscard]] std::size_t pop(std::span<T> const out) noexcept {
+            auto const head = hdr->head.load(std::memory_order_relaxed);
+            if (head == cached_tail) {
+                cached_tail = hdr->tail.load(std::memory_order_acquire);
+            }
+            auto const count = std::min<std::uint64_t>(out.size(), cached_tail - head);
+            for (std::uint64_t i = 0; i < count; ++i) {
+                std::memcpy(out.data() + i, slots + ((head + i) & mask), sizeof(T));
+            }
+            if (count != 0) {
+                hdr->head.store(head + count, std::memory_order_release);
+            }
+            return static_cast<std::size_t>(count);
+        }
+
+        /// Tell the producer we're about to wait for the doorbell. False (and
+        /// the flag is cleared again) when something got pushed meanwhile.
+        [[nodiscard]] bool prepare_sleep() noexcept {
+            hdr->consumer_waiting.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cached_tail = hdr->tail.load(std::memory_order_acquire);
+            if (cached_tail != hdr->head.load(std::memory_order_relaxed)) {
+                hdr->consumer_waiting.store(0, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        /// We're up again; the producer can stop ringing.
+        void woke_up() noexcept {
+            hdr->consumer_waiting.store(0, std::memory_order_relaxed);
+        }
+
+        /// Whether the producer went to sleep waiting for room; call it after
+        /// a `pop` that took something.
+        [[nodiscard]] bool producer_sleeping() const noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return hdr->producer_waiting.load(std::memory_order_relaxed) != 0;
+        }
+    };
+
+} // namespace fs8
@@ -0,0 +1,148 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <source_location>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+export module fs8.spans;
+import dynamic_scoping;
+
+export namespace fs8 {
+
+    /// Whether the mod invocations are timed at all: the `FORESIGHT_TRACE_SPANS`
+    /// CMake option. When off, `span_scope` is an empty struct and nothing of
+    /// this is compiled into the pipelines.
+#ifdef FS8_TRACE_SPANS
+    inline constexpr bool spans_enabled = true;
+#else
+    inline constexpr bool spans_enabled = false;
+#endif
+
+    /// A short, human name of `T` for the traces: "basic_router" for
+    /// `fs8::basic_router<...>`; no namespaces, no template arguments.
+    template <typename T>
+    [[nodiscard]] consteval std::string_view span_name() noexcept {
+        std::string_view name = std::source_location::current().function_name();
+        if (auto const start = name.find("T = "); start != std::string_view::npos) {
+            name.remove_prefix(start + 4);
+        }
+        name = name.substr(0, name.find_first_of("<;]"));
+        if (auto const scope = name.rfind("::"); scope != std::string_view::npos) {
+            name.remove_prefix(scope + 2);
+        }
+        return name.empty() ? std::string_view{"lambda"} : name;
+    }
+
+    /// One mod invocation; the times are `steady_clock` nanoseconds.
+    struct [[nodiscard]] span_record {
+        std::string_view name;
+        std::int64_t     begin = 0;
+        std::int64_t     end   = 0;
+    };
+
+    /**
+     * The spans of a thread, in a fixed ring: once it's full, the oldest spans
+     * make room for the new ones, so it always holds the latest `capacity`.
+     * The spans are recorded as they end, so the inner ones come first.
+     */
+    struct [[nodiscard]] span_buffer {
+        static constexpr std::size_t default_capacity = std::size_t{1} << 16U;
+
+      private:
+        std::vector<span_record> records;
+        std::size_t              next    = 0;
+        bool                     wrapped = false;
+
+      public:
+        /// Allocate the ring; the recording itself never allocates.
+        void reserve(std::size_t const capacity) {
+            records.assign(capacity, span_record{});
+            next    = 0;
+            wrapped = false;
+        }
+
+        void push(span_record const& record) noexcept {
+            if (records.empty()) [[unlikely]] {
+                return;
+            }
+            records[next] = record;
+            if (++next == records.size()) {
+                next    = 0;
+                wrapped = true;
+            }
+        }
+
+        void clear() noexcept {
+            next    = 0;
+            wrapped = false;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return wrapped ? records.size() : next;
+        }
+
+        /// fn(span_record) for each span, the oldest first.
+        template <typename Fn>
+        void for_each(Fn&& fn) const noexcept {
+            if (wrapped) {
+                for (std::size_t index = next; index < records.size(); ++index) {
+                    fn(records[index]);
+                }
+            }
+            for (std::size_t index = 0; index < next; ++index) {
+                fn(records[index]);
+            }
+        }
+    };
+
+    /// The span buffer of this thread, bound by `span_trace` while it runs.
+    constexpr struct [[nodiscard]] basic_span_target : thread_binding<span_buffer> {
+    } span_target;
+
+    /// Times the scope it lives in, into the bound `span_target` (if any).
+    template <typename T>
+    struct [[nodiscard]] active_span_scope {
+      private:
+        span_buffer* buffer = nullptr;
+        std::int64_t begin  = 0;
+
+        [[nodiscard]] static std::int64_t now() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+      public:
+        constexpr active_span_scope() noexcept {
+            if !consteval {
+                buffer = basic_span_target::instance();
+                if (buffer != nullptr) {
+                    begin = now();
+                }
+            }
+        }
+
+        active_span_scope(active_span_scope const&)            = delete;
+        active_span_scope(active_span_scope&&)                 = delete;
+        active_span_scope& operator=(active_span_scope const&) = delete;
+        active_span_scope& operator=(active_span_scope&&)      = delete;
+
+        constexpr ~active_span_scope() noexcept {
+            if !consteval {
+                if (buffer != nullptr) {
+                    buffer->push(span_record{.name = span_name<T>(), .begin = begin, .end = now()});
+                }
+            }
+        }
+    };
+
+    template <typename T>
+    struct [[nodiscard]] inactive_span_scope {};
+
+    /// What `invoke_mod` wraps each mod invocation in.
+    template <typename T>
+    using span_scope = std::conditional_t<spans_enabled, active_span_scope<T>, inactive_span_scope<T>>;
+
+} // namespace fs8
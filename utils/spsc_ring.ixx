@@ -0,0 +1,127 @@
+// Created by moisrex on 10/17/26.
+
+module;
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+export module fs8.spsc_ring;
+
+export namespace fs8 {
+
+    /**
+     * Bounded lock-free single-producer / single-consumer ring.
+     *
+     * Exactly one thread pushes and exactly one thread pops. Each side keeps a
+     * cached copy of the other side's index, so the shared cache lines are only
+     * touched when the cached view says the ring is full (producer) or empty
+     * (consumer); and by the producer once per push for the high-water mark,
+     * after the items are published.
+     *
+     * `try_push` is all-or-nothing for a span of items, which lets a producer
+     * publish a whole frame of events at once or drop it as a unit.
+     */
+    template <typename T>
+        requires(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>)
+    struct [[nodiscard]] spsc_ring {
+        using value_type = T;
+
+        /// `capacity` is rounded up to a power of two.
+        explicit spsc_ring(std::size_t const capacity)
+          : slots{std::make_unique<T[]>(std::bit_ceil(std::max<std::size_t>(capacity, 2)))},
+            mask{std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1} {}
+
+        spsc_ring(spsc_ring const&)            = delete;
+        spsc_ring(spsc_ring&&)                 = delete;
+        spsc_ring& operator=(spsc_ring const&) = delete;
+        spsc_ring& operator=(spsc_ring&&)      = delete;
+        ~spsc_ring()                           = default;
+
+        // --- producer side ---
+
+        /// Push all of `items` or none of them; false when they don't fit.
+        [[nodiscard]] bool try_push(std::span<T const> const items) noexcept {
+            auto const tail = prod.tail.load(std::memory_order_relaxed);
+            if (tail + items.size() - prod.cached_head > capacity()) {
+                prod.cached_head = cons.head.load(std::memory_order_acquire);
+                if (tail + items.size() - prod.cached_head > capacity()) [[unlikely]] {
+                    return false;
+                }
+            }
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                slots[(tail + i) & mask] = items[i];
+            }
+            prod.tail.store(tail + items.size(), std::memory_order_release);
+
+            prod.cached_head = cons.head.load(std::memory_order_acquire);
+            auto const used  = tail + items.size() - prod.cached_head;
+            if (used > prod.high_water.load(std::memory_order_relaxed)) {
+                prod.high_water.store(used, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool try_push(T const& item) noexcept {
+            return try_push(std::span<T const>{&item, 1});
+        }
+
+        // --- consumer side ---
+
+        [[nodiscard]] std::optional<T> try_pop() noexcept {
+            auto const head = cons.head.load(std::memory_order_relaxed);
+            if (head == cons.cached_tail) {
+                cons.cached_tail = prod.tail.load(std::memory_order_acquire);
+                if (head == cons.cached_tail) {
+                    return std::nullopt;
+                }
+            }
+            T item = slots[head & mask];
+            cons.head.store(head + 1, std::memory_order_release);
+            return item;
+        }
+
+        // --- either side ---
+
+        [[nodiscard]] std::size_t capacity() const noexcept {
+            return mask + 1;
+        }
+
+        /// A snapshot; only exact when neither side is running.
+        [[nodiscard]] std::size_t size() const noexcept {
+            auto const head = cons.head.load(std::memory_order_acquire);
+            auto const tail = prod.tail.load(std::memory_order_acquire);
+            return tail - head;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        /// The most items the ring has held at once.
+        [[nodiscard]] std::size_t high_water() const noexcept {
+            return prod.high_water.load(std::memory_order_relaxed);
+        }
+
+      private:
+        static constexpr std::size_t line_size = 64;
+
+        std::unique_ptr<T[]> slots;
+        std::size_t          mask;
+
+        struct alignas(line_size) producer_side {
+            std::atomic<std::size_t> tail{0};
+            std::size_t              cached_head = 0;
+            std::atomic<std::size_t> high_water{0};
+        } prod;
+
+        struct alignas(line_size) consumer_side {
+            std::atomic<std::size_t> head{0};
+            std::size_t              cached_tail = 0;
+        } cons;
+    };
+
+} // namespace fs8